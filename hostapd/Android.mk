@@ -143,6 +143,7 @@ endif
 OBJS += src/utils/common.c
 OBJS += src/utils/wpa_debug.c
 OBJS += src/utils/wpabuf.c
+OBJS += src/utils/metrics.c
 OBJS += src/utils/os_$(CONFIG_OS).c
 OBJS += src/utils/ip_addr.c
 
@@ -493,9 +494,8 @@ OBJS += src/wps/wps_upnp_web.c
 OBJS += src/wps/wps_upnp_event.c
 OBJS += src/wps/wps_upnp_ap.c
 OBJS += src/wps/upnp_xml.c
-OBJS += src/wps/httpread.c
-OBJS += src/wps/http_client.c
 OBJS += src/wps/http_server.c
+NEED_HTTP_CLIENT=y
 endif
 
 ifdef CONFIG_WPS_STRICT
@@ -561,6 +561,15 @@ NEED_DES=y
 L_CFLAGS += -DEAP_TLS_FUNCS
 OBJS += src/eap_server/eap_server_tls_common.c
 NEED_TLS_PRF=y
+ifdef CONFIG_OCSP_REFRESH
+L_CFLAGS += -DCONFIG_OCSP_REFRESH
+NEED_HTTP_CLIENT=y
+endif
+endif
+
+ifdef NEED_HTTP_CLIENT
+OBJS += src/wps/httpread.c
+OBJS += src/wps/http_client.c
 endif
 
 ifndef CONFIG_TLS
@@ -666,6 +675,9 @@ L_CFLAGS += -DCONFIG_INTERNAL_LIBTOMMATH
 ifdef CONFIG_INTERNAL_LIBTOMMATH_FAST
 L_CFLAGS += -DLTM_FAST
 endif
+ifdef CONFIG_INTERNAL_LIBTOMMATH_CT
+L_CFLAGS += -DLTM_CT
+endif
 else
 LIBS += -ltommath
 LIBS_h += -ltommath
@@ -2152,6 +2152,19 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 	} else if (os_strcmp(buf, "ocsp_stapling_response_multi") == 0) {
 		os_free(bss->ocsp_stapling_response_multi);
 		bss->ocsp_stapling_response_multi = os_strdup(pos);
+	} else if (os_strcmp(buf, "ocsp_stapling_responder") == 0) {
+		os_free(bss->ocsp_stapling_responder);
+		bss->ocsp_stapling_responder = os_strdup(pos);
+	} else if (os_strcmp(buf, "ocsp_stapling_refresh") == 0) {
+		int val = atoi(pos);
+
+		if (val < 60) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid ocsp_stapling_refresh %d",
+				   line, val);
+			return 1;
+		}
+		bss->ocsp_stapling_refresh = val;
 	} else if (os_strcmp(buf, "dh_file") == 0) {
 		os_free(bss->dh_file);
 		bss->dh_file = os_strdup(pos);
@@ -2765,6 +2778,18 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->ignore_broadcast_ssid = atoi(pos);
 	} else if (os_strcmp(buf, "no_probe_resp_if_max_sta") == 0) {
 		bss->no_probe_resp_if_max_sta = atoi(pos);
+	} else if (os_strcmp(buf, "no_probe_resp_if_denied") == 0) {
+		bss->no_probe_resp_if_denied = atoi(pos);
+	} else if (os_strcmp(buf, "probe_resp_rate_limit") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: invalid probe_resp_rate_limit %d",
+				   line, val);
+			return 1;
+		}
+		bss->probe_resp_rate_limit = val;
 	} else if (os_strcmp(buf, "wep_default_key") == 0) {
 		bss->ssid.wep.idx = atoi(pos);
 		if (bss->ssid.wep.idx > 3) {
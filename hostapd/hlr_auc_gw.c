@@ -88,6 +88,7 @@ struct milenage_parameters {
 	u8 sqn[6];
 	int set;
 	size_t res_len;
+	struct milenage_ctx *ctx; /* cached key schedule for ki/opc */
 };
 
 static struct milenage_parameters *milenage_db = NULL;
@@ -208,6 +209,7 @@ static struct milenage_parameters * db_get_milenage(const char *imsi_txt)
 	char cmd[128];
 	unsigned long long imsi;
 
+	milenage_deinit(db_tmp_milenage.ctx);
 	os_memset(&db_tmp_milenage, 0, sizeof(db_tmp_milenage));
 	imsi = atoll(imsi_txt);
 	os_snprintf(db_tmp_milenage.imsi, sizeof(db_tmp_milenage.imsi),
@@ -586,6 +588,14 @@ static struct milenage_parameters * get_milenage(const char *imsi)
 }
 
 
+static struct milenage_ctx * get_milenage_ctx(struct milenage_parameters *m)
+{
+	if (!m->ctx)
+		m->ctx = milenage_init(m->opc, m->ki);
+	return m->ctx;
+}
+
+
 static int sim_req_auth(char *imsi, char *resp, size_t resp_len)
 {
 	int count, max_chal, ret;
@@ -614,17 +624,24 @@ static int sim_req_auth(char *imsi, char *resp, size_t resp_len)
 
 	m = get_milenage(imsi);
 	if (m) {
-		u8 _rand[16], sres[4], kc[8];
+		u8 _rand[EAP_SIM_MAX_CHAL * 16], sres[EAP_SIM_MAX_CHAL * 4];
+		u8 kc[EAP_SIM_MAX_CHAL * 8];
+		struct milenage_ctx *ctx;
+
+		ctx = get_milenage_ctx(m);
+		if (!ctx || random_get_bytes(_rand, max_chal * 16) < 0)
+			return -1;
+		gsm_milenage_bulk(ctx, _rand, max_chal, sres, kc);
 		for (count = 0; count < max_chal; count++) {
-			if (random_get_bytes(_rand, 16) < 0)
-				return -1;
-			gsm_milenage(m->opc, m->ki, _rand, sres, kc);
 			*rpos++ = ' ';
-			rpos += wpa_snprintf_hex(rpos, rend - rpos, kc, 8);
+			rpos += wpa_snprintf_hex(rpos, rend - rpos,
+						 &kc[count * 8], 8);
 			*rpos++ = ':';
-			rpos += wpa_snprintf_hex(rpos, rend - rpos, sres, 4);
+			rpos += wpa_snprintf_hex(rpos, rend - rpos,
+						 &sres[count * 4], 4);
 			*rpos++ = ':';
-			rpos += wpa_snprintf_hex(rpos, rend - rpos, _rand, 16);
+			rpos += wpa_snprintf_hex(rpos, rend - rpos,
+						 &_rand[count * 16], 16);
 		}
 		*rpos = '\0';
 		return 0;
@@ -682,10 +699,15 @@ static int gsm_auth_req(char *imsi, char *resp, size_t resp_len)
 	m = get_milenage(imsi);
 	if (m) {
 		u8 _rand[16], sres[4], kc[8];
+		struct milenage_ctx *ctx;
+
+		ctx = get_milenage_ctx(m);
+		if (!ctx)
+			return -1;
 		for (count = 0; count < EAP_SIM_MAX_CHAL; count++) {
 			if (hexstr2bin(pos, _rand, 16) != 0)
 				return -1;
-			gsm_milenage(m->opc, m->ki, _rand, sres, kc);
+			gsm_milenage_bulk(ctx, _rand, 1, sres, kc);
 			*rpos++ = count == 0 ? ' ' : ':';
 			rpos += wpa_snprintf_hex(rpos, rend - rpos, kc, 8);
 			*rpos++ = ':';
@@ -747,9 +769,12 @@ static int aka_req_auth(char *imsi, char *resp, size_t resp_len)
 
 	m = get_milenage(imsi);
 	if (m) {
-		if (random_get_bytes(_rand, EAP_AKA_RAND_LEN) < 0)
+		struct milenage_ctx *ctx;
+
+		ctx = get_milenage_ctx(m);
+		if (!ctx || random_get_bytes(_rand, EAP_AKA_RAND_LEN) < 0)
 			return -1;
-		res_len = EAP_AKA_RES_MAX_LEN;
+		res_len = 8;
 		inc_sqn(m->sqn);
 #ifdef CONFIG_SQLITE
 		db_update_milenage_sqn(m);
@@ -760,8 +785,8 @@ static int aka_req_auth(char *imsi, char *resp, size_t resp_len)
 			       m->sqn[0], m->sqn[1], m->sqn[2],
 			       m->sqn[3], m->sqn[4], m->sqn[5]);
 		}
-		milenage_generate(m->opc, m->amf, m->ki, m->sqn, _rand,
-				  autn, ik, ck, res, &res_len);
+		milenage_generate_bulk(ctx, m->amf, m->sqn, _rand, 1,
+				       autn, ik, ck, res);
 		if (m->res_len >= EAP_AKA_RES_MIN_LEN &&
 		    m->res_len <= EAP_AKA_RES_MAX_LEN &&
 		    m->res_len < res_len)
@@ -945,6 +970,7 @@ static void cleanup(void)
 	while (m) {
 		prev = m;
 		m = m->next;
+		milenage_deinit(prev->ctx);
 		os_free(prev);
 	}
 
@@ -954,6 +980,8 @@ static void cleanup(void)
 		unlink(socket_path);
 
 #ifdef CONFIG_SQLITE
+	milenage_deinit(db_tmp_milenage.ctx);
+	db_tmp_milenage.ctx = NULL;
 	if (sqlite_db) {
 		sqlite3_close(sqlite_db);
 		sqlite_db = NULL;
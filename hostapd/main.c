@@ -14,6 +14,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/metrics.h"
 #include "utils/uuid.h"
 #include "crypto/random.h"
 #include "crypto/tls.h"
@@ -464,6 +465,7 @@ static void usage(void)
 		"usage: hostapd [-hdBKtv] [-P <PID file>] [-e <entropy file>] "
 		"\\\n"
 		"         [-g <global ctrl_iface>] [-G <group>]\\\n"
+		"         [-m <metrics file>]\\\n"
 		"         [-i <comma-separated list of interface names>]\\\n"
 		"         <configuration file(s)>\n"
 		"\n"
@@ -476,6 +478,7 @@ static void usage(void)
 		"   -G   group for control interfaces\n"
 		"   -P   PID file\n"
 		"   -K   include key data in debug messages\n"
+		"   -m   map counters and histograms to a file (e.g., under /dev/shm)\n"
 #ifdef CONFIG_DEBUG_FILE
 		"   -f   log output to debug file instead of stdout\n"
 #endif /* CONFIG_DEBUG_FILE */
@@ -642,6 +645,7 @@ int main(int argc, char *argv[])
 	int enable_trace_dbg = 0;
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 	int start_ifaces_in_sync = 0;
+	const char *metrics_file = NULL;
 	char **if_names = NULL;
 	size_t if_names_size = 0;
 
@@ -661,7 +665,7 @@ int main(int argc, char *argv[])
 	dl_list_init(&interfaces.global_ctrl_dst);
 
 	for (;;) {
-		c = getopt(argc, argv, "b:Bde:f:hi:KP:STtu:vg:G:");
+		c = getopt(argc, argv, "b:Bde:f:hi:Km:P:STtu:vg:G:");
 		if (c < 0)
 			break;
 		switch (c) {
@@ -685,6 +689,9 @@ int main(int argc, char *argv[])
 		case 'K':
 			wpa_debug_show_keys++;
 			break;
+		case 'm':
+			metrics_file = optarg;
+			break;
 		case 'P':
 			os_free(pid_file);
 			pid_file = os_rel2abs_path(optarg);
@@ -756,6 +763,11 @@ int main(int argc, char *argv[])
 	}
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
+	if (metrics_file && metrics_init(metrics_file) < 0) {
+		wpa_printf(MSG_ERROR, "Failed to initialize metrics");
+		return -1;
+	}
+
 	interfaces.count = argc - optind;
 	if (interfaces.count || num_bss_configs) {
 		interfaces.iface = os_calloc(interfaces.count + num_bss_configs,
@@ -894,6 +906,8 @@ int main(int argc, char *argv[])
 
 	fst_global_deinit();
 
+	metrics_deinit();
+
 	os_program_deinit();
 
 	return ret;
@@ -0,0 +1,384 @@
+/*
+ * Hotspot 2.0 SPP server - load test client
+ * Copyright (c) 2012-2014, Qualcomm Atheros, Inc.
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+/*
+ * This sends the same sppPostDevData request (built as in
+ * hs20/client/spp_client.c) to hs20_spp_server running in server mode
+ * (-s<server socket>) over a number of parallel connections and reports the
+ * request rate and latency. Each request is processed as a new subscription
+ * registration, so a test database should be used.
+ */
+
+#include "includes.h"
+#include <fcntl.h>
+#include <sys/un.h>
+
+#include "common.h"
+#include "eloop.h"
+#include "wpabuf.h"
+#include "xml-utils.h"
+
+
+#define SPP_NS_URI "http://www.wi-fi.org/specifications/hotspot2dot0/v1.0/spp"
+
+#define URN_OMA_DM_DEVINFO "urn:oma:mo:oma-dm-devinfo:1.0"
+#define URN_OMA_DM_DEVDETAIL "urn:oma:mo:oma-dm-devdetail:1.0"
+#define URN_HS20_DEVDETAIL_EXT "urn:wfa:mo-ext:hotspot2dot0-devdetail-ext:1.0"
+#define URN_HS20_PPS "urn:wfa:mo:hotspot2dot0-perprovidersubscription:1.0"
+
+
+struct spp_load {
+	const char *path;
+	struct wpabuf *req;
+	unsigned int total;
+	unsigned int started;
+	unsigned int completed;
+	unsigned int failed;
+	struct os_reltime start;
+	struct os_reltime sum;
+	struct os_reltime max;
+};
+
+struct spp_load_conn {
+	struct spp_load *load;
+	int sock;
+	size_t sent;
+	int receiving;
+	struct wpabuf *resp;
+	struct os_reltime start;
+};
+
+
+static void add_mo_container(struct xml_node_ctx *ctx, xml_namespace_t *ns,
+			     xml_node_t *parent, const char *urn,
+			     const char *fname)
+{
+	xml_node_t *node;
+	xml_node_t *fnode, *tnds;
+	char *str;
+
+	fnode = node_from_file(ctx, fname);
+	if (!fnode) {
+		printf("Failed to create XML node from file: %s\n", fname);
+		return;
+	}
+	tnds = mo_to_tnds(ctx, fnode, 0, urn, "syncml:dmddf1.2");
+	xml_node_free(ctx, fnode);
+	if (!tnds)
+		return;
+
+	str = xml_node_to_str(ctx, tnds);
+	xml_node_free(ctx, tnds);
+	if (str == NULL)
+		return;
+
+	node = xml_node_create_text(ctx, parent, ns, "moContainer", str);
+	if (node)
+		xml_node_add_attr(ctx, node, ns, "moURN", urn);
+	os_free(str);
+}
+
+
+static struct wpabuf * build_request(const char *user, const char *realm,
+				     const char *devinfo,
+				     const char *devdetail)
+{
+	struct xml_node_ctx *ctx;
+	xml_namespace_t *ns;
+	xml_node_t *spp_node, *soap;
+	struct wpabuf *buf = NULL;
+	char *str;
+
+	ctx = xml_node_init_ctx(NULL, NULL);
+	if (ctx == NULL)
+		return NULL;
+
+	spp_node = xml_node_create_root(ctx, SPP_NS_URI, "spp", &ns,
+					"sppPostDevData");
+	if (spp_node == NULL)
+		goto out;
+	xml_node_add_attr(ctx, spp_node, ns, "sppVersion", "1.0");
+	xml_node_add_attr(ctx, spp_node, NULL, "requestReason",
+			  "Subscription registration");
+	xml_node_add_attr(ctx, spp_node, NULL, "redirectURI",
+			  "http://localhost:12345/");
+	xml_node_create_text(ctx, spp_node, ns, "supportedSPPVersions", "1.0");
+	xml_node_create_text(ctx, spp_node, ns, "supportedMOList",
+			     URN_HS20_PPS " " URN_OMA_DM_DEVINFO " "
+			     URN_OMA_DM_DEVDETAIL " " URN_HS20_DEVDETAIL_EXT);
+	add_mo_container(ctx, ns, spp_node, URN_OMA_DM_DEVINFO, devinfo);
+	add_mo_container(ctx, ns, spp_node, URN_OMA_DM_DEVDETAIL, devdetail);
+
+	soap = soap_build_envelope(ctx, spp_node);
+	if (soap == NULL)
+		goto out;
+	str = xml_node_to_str(ctx, soap);
+	xml_node_free(ctx, soap);
+	if (str == NULL)
+		goto out;
+
+	buf = wpabuf_alloc(100 + os_strlen(user) + os_strlen(realm) +
+			   os_strlen(str));
+	if (buf) {
+		wpabuf_printf(buf, "HS20USER=%s\nHS20REALM=%s\n"
+			      "HS20ADDR=127.0.0.1\n\n", user, realm);
+		wpabuf_put_str(buf, str);
+	}
+	os_free(str);
+out:
+	xml_node_deinit_ctx(ctx);
+	return buf;
+}
+
+
+static int spp_load_start(struct spp_load *load);
+
+
+static void spp_load_conn_done(struct spp_load_conn *conn, int success)
+{
+	struct spp_load *load = conn->load;
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &conn->start, &diff);
+	if (conn->receiving)
+		eloop_unregister_read_sock(conn->sock);
+	else
+		eloop_unregister_sock(conn->sock, EVENT_TYPE_WRITE);
+	close(conn->sock);
+	wpabuf_free(conn->resp);
+	os_free(conn);
+
+	load->completed++;
+	if (!success)
+		load->failed++;
+	load->sum.sec += diff.sec;
+	load->sum.usec += diff.usec;
+	while (load->sum.usec >= 1000000) {
+		load->sum.sec++;
+		load->sum.usec -= 1000000;
+	}
+	if (os_reltime_before(&load->max, &diff))
+		load->max = diff;
+
+	if (load->completed == load->total) {
+		eloop_terminate();
+		return;
+	}
+	if (load->started < load->total && spp_load_start(load) < 0)
+		eloop_terminate();
+}
+
+
+static void spp_load_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct spp_load_conn *conn = eloop_ctx;
+	ssize_t res;
+
+	if (wpabuf_resize(&conn->resp, 4096) < 0) {
+		spp_load_conn_done(conn, 0);
+		return;
+	}
+	res = read(sock, wpabuf_put(conn->resp, 0),
+		   wpabuf_tailroom(conn->resp));
+	if (res < 0 && (errno == EAGAIN || errno == EINTR))
+		return;
+	if (res < 0) {
+		spp_load_conn_done(conn, 0);
+		return;
+	}
+	if (res > 0) {
+		wpabuf_put(conn->resp, res);
+		return;
+	}
+
+	/* process() return value 0 means a SOAP response was returned */
+	spp_load_conn_done(conn, wpabuf_len(conn->resp) > 2 &&
+			   os_memcmp(wpabuf_head(conn->resp), "0\n", 2) == 0);
+}
+
+
+static void spp_load_send(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct spp_load_conn *conn = eloop_ctx;
+	struct wpabuf *req = conn->load->req;
+	ssize_t res;
+
+	res = write(sock, wpabuf_head_u8(req) + conn->sent,
+		    wpabuf_len(req) - conn->sent);
+	if (res < 0 && (errno == EAGAIN || errno == EINTR))
+		return;
+	if (res <= 0) {
+		spp_load_conn_done(conn, 0);
+		return;
+	}
+	conn->sent += res;
+	if (conn->sent < wpabuf_len(req))
+		return;
+
+	shutdown(sock, SHUT_WR);
+	if (eloop_register_read_sock(sock, spp_load_receive, conn, NULL) < 0) {
+		spp_load_conn_done(conn, 0);
+		return;
+	}
+	eloop_unregister_sock(sock, EVENT_TYPE_WRITE);
+	conn->receiving = 1;
+}
+
+
+static int spp_load_start(struct spp_load *load)
+{
+	struct spp_load_conn *conn;
+	struct sockaddr_un addr;
+	int s;
+
+	s = socket(PF_UNIX, SOCK_STREAM, 0);
+	if (s < 0) {
+		perror("socket");
+		return -1;
+	}
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	os_strlcpy(addr.sun_path, load->path, sizeof(addr.sun_path));
+	if (connect(s, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		perror("connect");
+		close(s);
+		return -1;
+	}
+	if (fcntl(s, F_SETFL, O_NONBLOCK) < 0) {
+		perror("fcntl");
+		close(s);
+		return -1;
+	}
+
+	conn = os_zalloc(sizeof(*conn));
+	if (conn == NULL) {
+		close(s);
+		return -1;
+	}
+	conn->load = load;
+	conn->sock = s;
+	os_get_reltime(&conn->start);
+	if (eloop_register_sock(s, EVENT_TYPE_WRITE, spp_load_send, conn,
+				NULL) < 0) {
+		close(s);
+		os_free(conn);
+		return -1;
+	}
+	load->started++;
+
+	return 0;
+}
+
+
+static void spp_load_terminate(int sig, void *signal_ctx)
+{
+	eloop_terminate();
+}
+
+
+static void usage(void)
+{
+	printf("usage:\n"
+	       "hs20_spp_load -s<server socket> -r<realm> [-u<user>] "
+	       "[-n<requests>] [-c<parallel connections>] [-i<devinfo.xml>] "
+	       "[-d<devdetail.xml>]\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct spp_load load;
+	const char *realm = NULL, *user = "";
+	const char *devinfo = "devinfo.xml", *devdetail = "devdetail.xml";
+	unsigned int parallel = 1, i;
+	struct os_reltime now, diff;
+	double secs;
+
+	os_memset(&load, 0, sizeof(load));
+	load.total = 100;
+	for (;;) {
+		int c = getopt(argc, argv, "c:d:i:n:r:s:u:");
+		if (c < 0)
+			break;
+		switch (c) {
+		case 'c':
+			parallel = atoi(optarg);
+			break;
+		case 'd':
+			devdetail = optarg;
+			break;
+		case 'i':
+			devinfo = optarg;
+			break;
+		case 'n':
+			load.total = atoi(optarg);
+			break;
+		case 'r':
+			realm = optarg;
+			break;
+		case 's':
+			load.path = optarg;
+			break;
+		case 'u':
+			user = optarg;
+			break;
+		default:
+			usage();
+			return -1;
+		}
+	}
+	if (load.path == NULL || realm == NULL || load.total == 0 ||
+	    parallel == 0) {
+		usage();
+		return -1;
+	}
+	if (parallel > load.total)
+		parallel = load.total;
+
+	load.req = build_request(user, realm, devinfo, devdetail);
+	if (load.req == NULL) {
+		printf("Failed to build sppPostDevData request\n");
+		return -1;
+	}
+
+	if (eloop_init() < 0) {
+		wpabuf_free(load.req);
+		return -1;
+	}
+	eloop_register_signal_terminate(spp_load_terminate, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	os_get_reltime(&load.start);
+	for (i = 0; i < parallel; i++) {
+		if (spp_load_start(&load) < 0)
+			break;
+	}
+	if (load.started)
+		eloop_run();
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &load.start, &diff);
+
+	eloop_destroy();
+	wpabuf_free(load.req);
+
+	secs = diff.sec + diff.usec / 1000000.0;
+	printf("%u/%u requests completed (%u failed) in %.3f s "
+	       "with %u parallel connections\n",
+	       load.completed, load.total, load.failed, secs, parallel);
+	if (load.completed && secs > 0) {
+		printf("%.1f requests/s, average latency %.3f ms, "
+		       "max %.3f ms\n",
+		       load.completed / secs,
+		       (load.sum.sec * 1000.0 + load.sum.usec / 1000.0) /
+		       load.completed,
+		       load.max.sec * 1000.0 + load.max.usec / 1000.0);
+	}
+
+	return load.completed == load.total && load.failed == 0 ? 0 : -1;
+}
@@ -8,13 +8,20 @@
 
 #include "includes.h"
 #include <time.h>
+#include <fcntl.h>
+#include <sys/un.h>
 #include <sqlite3.h>
 
 #include "common.h"
+#include "eloop.h"
+#include "wpabuf.h"
 #include "xml-utils.h"
 #include "spp_server.h"
 
 
+#define SPP_SERVER_MAX_REQ_LEN 1000000
+
+
 static void write_timestamp(FILE *f)
 {
 	time_t t;
@@ -61,25 +68,22 @@ void debug_dump_node(struct hs20_svc *ctx, const char *title, xml_node_t *node)
 }
 
 
-static int process(struct hs20_svc *ctx)
+static int process(struct hs20_svc *ctx, const char *user,
+		   const char *realm, const char *post, char **resp_str)
 {
 	int dmacc = 0;
 	xml_node_t *soap, *spp, *resp;
-	char *user, *realm, *post, *str;
+	char *str;
 
-	ctx->addr = getenv("HS20ADDR");
 	if (ctx->addr)
 		debug_print(ctx, 1, "Connection from %s", ctx->addr);
 
-	user = getenv("HS20USER");
 	if (user && strlen(user) == 0)
 		user = NULL;
-	realm = getenv("HS20REALM");
 	if (realm == NULL) {
 		debug_print(ctx, 1, "HS20REALM not set");
 		return -1;
 	}
-	post = getenv("HS20POST");
 	if (post == NULL) {
 		debug_print(ctx, 1, "HS20POST not set");
 		return -1;
@@ -121,9 +125,281 @@ static int process(struct hs20_svc *ctx)
 		debug_print(ctx, 1, "Could not get node string");
 		return -1;
 	}
-	printf("%s", str);
+	*resp_str = str;
+
+	return 0;
+}
+
+
+static int process_env(struct hs20_svc *ctx)
+{
+	char *str = NULL;
+	int ret;
+
+	ctx->addr = getenv("HS20ADDR");
+	ret = process(ctx, getenv("HS20USER"), getenv("HS20REALM"),
+		      getenv("HS20POST"), &str);
+	if (str) {
+		printf("%s", str);
+		free(str);
+	}
+
+	return ret;
+}
+
+
+/*
+ * Server mode: requests are read from a UNIX domain stream socket so that the
+ * database handle, prepared statements, and XML context are reused over
+ * requests instead of being set up again in a new process for each request.
+ *
+ * Request: HS20USER=, HS20REALM=, and HS20ADDR= lines (same values as the
+ * environment variables in the one-shot mode), an empty line, and the POST
+ * data until the client shuts down its sending side.
+ * Response: process() return value on the first line followed by the SOAP
+ * response, if any. The response is sent from eloop as the socket becomes
+ * writable so that a slow client does not block other requests.
+ */
+
+struct spp_conn {
+	struct hs20_svc *ctx;
+	int sock;
+	struct wpabuf *buf;
+	struct wpabuf *resp;
+	size_t sent;
+	int registered; /* sock is registered with eloop (read or write) */
+};
+
+
+static void spp_conn_free(struct spp_conn *conn)
+{
+	if (conn->registered && conn->resp)
+		eloop_unregister_sock(conn->sock, EVENT_TYPE_WRITE);
+	else if (conn->registered)
+		eloop_unregister_read_sock(conn->sock);
+	close(conn->sock);
+	wpabuf_free(conn->buf);
+	wpabuf_free(conn->resp);
+	os_free(conn);
+}
+
+
+static void spp_conn_send(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct spp_conn *conn = eloop_ctx;
+	ssize_t res;
+
+	res = write(sock, wpabuf_head_u8(conn->resp) + conn->sent,
+		    wpabuf_len(conn->resp) - conn->sent);
+	if (res < 0 && (errno == EAGAIN || errno == EINTR))
+		return;
+	if (res <= 0) {
+		debug_print(conn->ctx, 1, "Failed to send response: %s",
+			    res < 0 ? strerror(errno) : "no progress");
+		spp_conn_free(conn);
+		return;
+	}
+	conn->sent += res;
+	if (conn->sent == wpabuf_len(conn->resp))
+		spp_conn_free(conn);
+}
+
+
+static int spp_conn_header(char *line, const char *name, char **val)
+{
+	size_t len = os_strlen(name);
+
+	if (os_strncmp(line, name, len) != 0)
+		return 0;
+	/*
+	 * Values are terminated by LF, so a value with an embedded CR/LF could
+	 * be used to inject another header line; reject such requests.
+	 */
+	if (*val || os_strchr(line + len, '\r'))
+		return -1;
+	*val = line + len;
+	return 1;
+}
+
+
+static void spp_conn_process(struct spp_conn *conn)
+{
+	struct hs20_svc *ctx = conn->ctx;
+	char *pos, *end, *post = NULL;
+	char *user = NULL, *realm = NULL, *addr = NULL;
+	char *str = NULL;
+	int ret;
+
+	wpabuf_put_u8(conn->buf, '\0');
+	pos = wpabuf_mhead(conn->buf);
+	post = os_strstr(pos, "\n\n");
+	if (post) {
+		*post = '\0';
+		post += 2;
+	}
+	while (pos) {
+		end = os_strchr(pos, '\n');
+		if (end)
+			*end++ = '\0';
+		ret = spp_conn_header(pos, "HS20USER=", &user);
+		if (ret == 0)
+			ret = spp_conn_header(pos, "HS20REALM=", &realm);
+		if (ret == 0)
+			ret = spp_conn_header(pos, "HS20ADDR=", &addr);
+		if (ret < 0 || (ret == 0 && *pos)) {
+			debug_print(ctx, 1, "Invalid request header line");
+			spp_conn_free(conn);
+			return;
+		}
+		pos = end;
+	}
+
+	ctx->addr = addr;
+	ret = process(ctx, user, realm, post, &str);
+	debug_print(ctx, 1, "process() --> %d", ret);
+	ctx->addr = NULL;
+
+	conn->resp = wpabuf_alloc(20 + (str ? os_strlen(str) : 0));
+	if (conn->resp == NULL) {
+		free(str);
+		spp_conn_free(conn);
+		return;
+	}
+	wpabuf_printf(conn->resp, "%d\n", ret);
+	if (str)
+		wpabuf_put_str(conn->resp, str);
 	free(str);
 
+	eloop_unregister_read_sock(conn->sock);
+	conn->registered = 0;
+	if (eloop_register_sock(conn->sock, EVENT_TYPE_WRITE, spp_conn_send,
+				conn, NULL) < 0) {
+		spp_conn_free(conn);
+		return;
+	}
+	conn->registered = 1;
+}
+
+
+static void spp_conn_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct spp_conn *conn = eloop_ctx;
+	ssize_t res;
+
+	if (wpabuf_resize(&conn->buf, 4096) < 0) {
+		spp_conn_free(conn);
+		return;
+	}
+	res = read(sock, wpabuf_put(conn->buf, 0), wpabuf_tailroom(conn->buf));
+	if (res < 0 && (errno == EAGAIN || errno == EINTR))
+		return;
+	if (res < 0) {
+		debug_print(conn->ctx, 1, "read: %s", strerror(errno));
+		spp_conn_free(conn);
+		return;
+	}
+	if (res == 0) {
+		/* Full request received */
+		spp_conn_process(conn);
+		return;
+	}
+	wpabuf_put(conn->buf, res);
+	if (wpabuf_len(conn->buf) > SPP_SERVER_MAX_REQ_LEN) {
+		debug_print(conn->ctx, 1, "Too long request");
+		spp_conn_free(conn);
+	}
+}
+
+
+static void spp_server_accept(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct hs20_svc *ctx = eloop_ctx;
+	struct spp_conn *conn;
+	int s;
+
+	s = accept(sock, NULL, NULL);
+	if (s < 0) {
+		debug_print(ctx, 1, "accept: %s", strerror(errno));
+		return;
+	}
+
+	if (fcntl(s, F_SETFL, O_NONBLOCK) < 0) {
+		debug_print(ctx, 1, "fcntl: %s", strerror(errno));
+		close(s);
+		return;
+	}
+
+	conn = os_zalloc(sizeof(*conn));
+	if (conn == NULL) {
+		close(s);
+		return;
+	}
+	conn->ctx = ctx;
+	conn->sock = s;
+	conn->buf = wpabuf_alloc(4096);
+	if (conn->buf == NULL ||
+	    eloop_register_read_sock(s, spp_conn_receive, conn, NULL) < 0) {
+		wpabuf_free(conn->buf);
+		close(s);
+		os_free(conn);
+		return;
+	}
+	conn->registered = 1;
+}
+
+
+static void spp_server_terminate(int sig, void *signal_ctx)
+{
+	eloop_terminate();
+}
+
+
+static int spp_server_run(struct hs20_svc *ctx, const char *path)
+{
+	struct sockaddr_un addr;
+	int s;
+
+	s = socket(PF_UNIX, SOCK_STREAM, 0);
+	if (s < 0) {
+		perror("socket");
+		return -1;
+	}
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	os_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+	unlink(path);
+	if (bind(s, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+	    listen(s, 64) < 0) {
+		perror("bind/listen");
+		close(s);
+		return -1;
+	}
+
+	if (eloop_init() < 0) {
+		close(s);
+		unlink(path);
+		return -1;
+	}
+	if (eloop_register_read_sock(s, spp_server_accept, ctx, NULL) < 0) {
+		eloop_destroy();
+		close(s);
+		unlink(path);
+		return -1;
+	}
+	eloop_register_signal_terminate(spp_server_terminate, NULL);
+	/*
+	 * A client closing its connection before the response has been sent
+	 * must not terminate the server.
+	 */
+	signal(SIGPIPE, SIG_IGN);
+	debug_print(ctx, 1, "Waiting for requests on %s", path);
+	eloop_run();
+
+	eloop_unregister_read_sock(s);
+	close(s);
+	unlink(path);
+	eloop_destroy();
+
 	return 0;
 }
 
@@ -131,18 +407,20 @@ static int process(struct hs20_svc *ctx)
 static void usage(void)
 {
 	printf("usage:\n"
-	       "hs20_spp_server -r<root directory> [-f<debug log>]\n");
+	       "hs20_spp_server -r<root directory> [-f<debug log>] "
+	       "[-s<server socket>]\n");
 }
 
 
 int main(int argc, char *argv[])
 {
 	struct hs20_svc ctx;
+	const char *server_sock = NULL;
 	int ret;
 
 	os_memset(&ctx, 0, sizeof(ctx));
 	for (;;) {
-		int c = getopt(argc, argv, "f:r:");
+		int c = getopt(argc, argv, "f:r:s:");
 		if (c < 0)
 			break;
 		switch (c) {
@@ -158,6 +436,9 @@ int main(int argc, char *argv[])
 		case 'r':
 			ctx.root_dir = optarg;
 			break;
+		case 's':
+			server_sock = optarg;
+			break;
 		default:
 			usage();
 			return -1;
@@ -175,8 +456,12 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
-	ret = process(&ctx);
-	debug_print(&ctx, 1, "process() --> %d", ret);
+	if (server_sock) {
+		ret = spp_server_run(&ctx, server_sock);
+	} else {
+		ret = process_env(&ctx);
+		debug_print(&ctx, 1, "process() --> %d", ret);
+	}
 
 	xml_node_deinit_ctx(ctx.xml);
 	hs20_spp_server_deinit(&ctx);
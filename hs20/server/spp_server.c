@@ -354,55 +354,114 @@ static int new_password(char *buf, int buflen)
 }
 
 
-struct get_db_field_data {
-	const char *field;
-	char *value;
-};
+/*
+ * Get a prepared statement for the given SQL from the per-context cache or
+ * prepare and cache a new one. The returned statement has been reset and has
+ * no bindings.
+ */
+static sqlite3_stmt * db_prepare(struct hs20_svc *ctx, const char *sql)
+{
+	struct hs20_svc_stmt *e;
+	sqlite3_stmt *stmt;
+	char *sql_copy;
+	int i;
+
+	for (i = 0; i < HS20_SVC_STMT_CACHE_SIZE; i++) {
+		e = &ctx->stmt_cache[i];
+		if (e->sql && os_strcmp(e->sql, sql) == 0) {
+			sqlite3_reset(e->stmt);
+			sqlite3_clear_bindings(e->stmt);
+			return e->stmt;
+		}
+	}
+
+	if (sqlite3_prepare_v2(ctx->db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+		debug_print(ctx, 1, "DB: Failed to prepare '%s': %s",
+			    sql, sqlite3_errmsg(ctx->db));
+		return NULL;
+	}
+	sql_copy = os_strdup(sql);
+	if (sql_copy == NULL) {
+		sqlite3_finalize(stmt);
+		return NULL;
+	}
+
+	e = &ctx->stmt_cache[ctx->stmt_cache_next];
+	ctx->stmt_cache_next = (ctx->stmt_cache_next + 1) %
+		HS20_SVC_STMT_CACHE_SIZE;
+	sqlite3_finalize(e->stmt);
+	os_free(e->sql);
+	e->sql = sql_copy;
+	e->stmt = stmt;
+
+	return stmt;
+}
 
 
-static int get_db_field(void *ctx, int argc, char *argv[], char *col[])
+static void db_stmt_cache_flush(struct hs20_svc *ctx)
 {
-	struct get_db_field_data *data = ctx;
 	int i;
 
-	for (i = 0; i < argc; i++) {
-		if (os_strcmp(col[i], data->field) == 0 && argv[i]) {
-			os_free(data->value);
-			data->value = os_strdup(argv[i]);
-			break;
+	for (i = 0; i < HS20_SVC_STMT_CACHE_SIZE; i++) {
+		sqlite3_finalize(ctx->stmt_cache[i].stmt);
+		os_free(ctx->stmt_cache[i].sql);
+	}
+	os_memset(ctx->stmt_cache, 0, sizeof(ctx->stmt_cache));
+	ctx->stmt_cache_next = 0;
+}
+
+
+/*
+ * Run a query returning a single text column and return the value from the
+ * last row that had a non-NULL value.
+ */
+static char * db_get_stmt_text(struct hs20_svc *ctx, sqlite3_stmt *stmt)
+{
+	char *value = NULL;
+	const unsigned char *txt;
+	int res;
+
+	while ((res = sqlite3_step(stmt)) == SQLITE_ROW) {
+		txt = sqlite3_column_text(stmt, 0);
+		if (txt) {
+			os_free(value);
+			value = os_strdup((const char *) txt);
 		}
 	}
+	if (res != SQLITE_DONE)
+		debug_print(ctx, 1, "DB: Query failed: %s",
+			    sqlite3_errmsg(ctx->db));
+	sqlite3_reset(stmt);
 
-	return 0;
+	return value;
 }
 
 
 static char * db_get_val(struct hs20_svc *ctx, const char *user,
 			 const char *realm, const char *field, int dmacc)
 {
-	char *cmd;
-	struct get_db_field_data data;
+	char *cmd, *value;
+	sqlite3_stmt *stmt;
 
 	cmd = sqlite3_mprintf("SELECT %s FROM users WHERE "
-			      "%s=%Q AND realm=%Q AND phase2=1",
-			      field, dmacc ? "osu_user" : "identity",
-			      user, realm);
+			      "%s=? AND realm=? AND phase2=1",
+			      field, dmacc ? "osu_user" : "identity");
 	if (cmd == NULL)
 		return NULL;
-	memset(&data, 0, sizeof(data));
-	data.field = field;
-	if (sqlite3_exec(ctx->db, cmd, get_db_field, &data, NULL) != SQLITE_OK)
-	{
+	stmt = db_prepare(ctx, cmd);
+	sqlite3_free(cmd);
+	if (stmt == NULL ||
+	    sqlite3_bind_text(stmt, 1, user, -1, SQLITE_STATIC) != SQLITE_OK ||
+	    sqlite3_bind_text(stmt, 2, realm, -1, SQLITE_STATIC) != SQLITE_OK) {
 		debug_print(ctx, 1, "Could not find user '%s'", user);
-		sqlite3_free(cmd);
 		return NULL;
 	}
-	sqlite3_free(cmd);
+	value = db_get_stmt_text(ctx, stmt);
 
 	debug_print(ctx, 1, "DB: user='%s' realm='%s' field='%s' dmacc=%d --> "
-		    "value='%s'", user, realm, field, dmacc, data.value);
+		    "value='%s'", user, realm, field, dmacc, value);
 
-	return data.value;
+	return value;
 }
 
 
@@ -441,33 +500,42 @@ static char * db_get_session_val(struct hs20_svc *ctx, const char *user,
 				 const char *realm, const char *session_id,
 				 const char *field)
 {
-	char *cmd;
-	struct get_db_field_data data;
+	char *cmd, *value;
+	sqlite3_stmt *stmt;
+	int res;
 
 	if (user == NULL || realm == NULL) {
-		cmd = sqlite3_mprintf("SELECT %s FROM sessions WHERE "
-				      "id=%Q", field, session_id);
+		cmd = sqlite3_mprintf("SELECT %s FROM sessions WHERE id=?1",
+				      field);
 	} else {
 		cmd = sqlite3_mprintf("SELECT %s FROM sessions WHERE "
-				      "user=%Q AND realm=%Q AND id=%Q",
-				      field, user, realm, session_id);
+				      "user=?2 AND realm=?3 AND id=?1", field);
 	}
 	if (cmd == NULL)
 		return NULL;
-	debug_print(ctx, 1, "DB: %s", cmd);
-	memset(&data, 0, sizeof(data));
-	data.field = field;
-	if (sqlite3_exec(ctx->db, cmd, get_db_field, &data, NULL) != SQLITE_OK)
-	{
+	debug_print(ctx, 1, "DB: %s [id='%s' user='%s' realm='%s']", cmd,
+		    session_id ? session_id : "", user ? user : "",
+		    realm ? realm : "");
+	stmt = db_prepare(ctx, cmd);
+	sqlite3_free(cmd);
+	if (stmt == NULL)
+		return NULL;
+	res = sqlite3_bind_text(stmt, 1, session_id, -1, SQLITE_STATIC);
+	if (res == SQLITE_OK && user && realm) {
+		res = sqlite3_bind_text(stmt, 2, user, -1, SQLITE_STATIC);
+		if (res == SQLITE_OK)
+			res = sqlite3_bind_text(stmt, 3, realm, -1,
+						SQLITE_STATIC);
+	}
+	if (res != SQLITE_OK) {
 		debug_print(ctx, 1, "DB: Could not find session %s: %s",
 			    session_id, sqlite3_errmsg(ctx->db));
-		sqlite3_free(cmd);
 		return NULL;
 	}
-	sqlite3_free(cmd);
+	value = db_get_stmt_text(ctx, stmt);
 
-	debug_print(ctx, 1, "DB: return '%s'", data.value);
-	return data.value;
+	debug_print(ctx, 1, "DB: return '%s'", value);
+	return value;
 }
 
 
@@ -1186,27 +1254,24 @@ static xml_node_t * hs20_user_input_remediation(struct hs20_svc *ctx,
 static char * db_get_osu_config_val(struct hs20_svc *ctx, const char *realm,
 				    const char *field)
 {
-	char *cmd;
-	struct get_db_field_data data;
+	sqlite3_stmt *stmt;
+	char *value;
 
-	cmd = sqlite3_mprintf("SELECT value FROM osu_config WHERE realm=%Q AND "
-			      "field=%Q", realm, field);
-	if (cmd == NULL)
-		return NULL;
-	debug_print(ctx, 1, "DB: %s", cmd);
-	memset(&data, 0, sizeof(data));
-	data.field = "value";
-	if (sqlite3_exec(ctx->db, cmd, get_db_field, &data, NULL) != SQLITE_OK)
-	{
+	debug_print(ctx, 1, "DB: SELECT value FROM osu_config WHERE realm='%s' "
+		    "AND field='%s'", realm, field);
+	stmt = db_prepare(ctx, "SELECT value FROM osu_config WHERE realm=? AND "
+			  "field=?");
+	if (stmt == NULL ||
+	    sqlite3_bind_text(stmt, 1, realm, -1, SQLITE_STATIC) != SQLITE_OK ||
+	    sqlite3_bind_text(stmt, 2, field, -1, SQLITE_STATIC) != SQLITE_OK) {
 		debug_print(ctx, 1, "DB: Could not find osu_config %s: %s",
 			    realm, sqlite3_errmsg(ctx->db));
-		sqlite3_free(cmd);
 		return NULL;
 	}
-	sqlite3_free(cmd);
+	value = db_get_stmt_text(ctx, stmt);
 
-	debug_print(ctx, 1, "DB: return '%s'", data.value);
-	return data.value;
+	debug_print(ctx, 1, "DB: return '%s'", value);
+	return value;
 }
 
 
@@ -2287,6 +2352,7 @@ int hs20_spp_server_init(struct hs20_svc *ctx)
 
 void hs20_spp_server_deinit(struct hs20_svc *ctx)
 {
+	db_stmt_cache_flush(ctx);
 	sqlite3_close(ctx->db);
 	ctx->db = NULL;
 }
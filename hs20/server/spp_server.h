@@ -9,6 +9,13 @@
 #ifndef SPP_SERVER_H
 #define SPP_SERVER_H
 
+#define HS20_SVC_STMT_CACHE_SIZE 16
+
+struct hs20_svc_stmt {
+	char *sql;
+	sqlite3_stmt *stmt;
+};
+
 struct hs20_svc {
 	const void *ctx;
 	struct xml_node_ctx *xml;
@@ -16,6 +23,10 @@ struct hs20_svc {
 	FILE *debug_log;
 	sqlite3 *db;
 	const char *addr;
+
+	/* prepared statements reused over requests in server mode */
+	struct hs20_svc_stmt stmt_cache[HS20_SVC_STMT_CACHE_SIZE];
+	unsigned int stmt_cache_next;
 };
 
 
@@ -1,4 +1,6 @@
 <?php
 $osu_root = "/home/user/hs20-server";
 $osu_db = "sqlite:$osu_root/AS/DB/eap_user.db";
+/* Uncomment to use a long-running hs20_spp_server -s<path> process */
+//$spp_socket = "/tmp/hs20_spp_server.sock";
 ?>
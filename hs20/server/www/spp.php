@@ -101,7 +101,26 @@ putenv("HS20POST=$postdata");
 $addr = $_SERVER["REMOTE_ADDR"];
 putenv("HS20ADDR=$addr");
 
-$last = exec("$osu_root/spp/hs20_spp_server -r$osu_root -f/tmp/hs20_spp_server.log", $output, $ret);
+if (isset($spp_socket)) {
+  /* Long-running hs20_spp_server started with -s$spp_socket */
+  if (preg_match("/[\r\n]/", (isset($user) ? $user : "") . $realm . $addr)) {
+    error_log("spp.php - Invalid character in user or realm");
+    die("Invalid user or realm");
+  }
+  $sock = stream_socket_client("unix://$spp_socket", $errno, $errstr);
+  if (!$sock) {
+    error_log("spp.php - Could not connect to SPP server: $errstr");
+    die("Could not connect to SPP server");
+  }
+  fwrite($sock, "HS20USER=" . (isset($user) ? $user : "") . "\n" .
+	 "HS20REALM=$realm\n" . "HS20ADDR=$addr\n\n" . $postdata);
+  stream_socket_shutdown($sock, STREAM_SHUT_WR);
+  $ret = intval(fgets($sock));
+  $output = array(stream_get_contents($sock));
+  fclose($sock);
+} else {
+  $last = exec("$osu_root/spp/hs20_spp_server -r$osu_root -f/tmp/hs20_spp_server.log", $output, $ret);
+}
 
 if ($ret == 2) {
   if (empty($_SERVER['PHP_AUTH_DIGEST'])) {
@@ -356,6 +356,8 @@ struct hostapd_bss_config {
 	unsigned int tls_session_lifetime;
 	char *ocsp_stapling_response;
 	char *ocsp_stapling_response_multi;
+	char *ocsp_stapling_responder;
+	unsigned int ocsp_stapling_refresh;
 	char *dh_file;
 	char *openssl_ciphers;
 	u8 *pac_opaque_encr_key;
@@ -383,6 +385,8 @@ struct hostapd_bss_config {
 	int ap_max_inactivity;
 	int ignore_broadcast_ssid;
 	int no_probe_resp_if_max_sta;
+	int no_probe_resp_if_denied;
+	unsigned int probe_resp_rate_limit;
 
 	int wmm_enabled;
 	int wmm_uapsd;
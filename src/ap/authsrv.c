@@ -9,7 +9,9 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "utils/eloop.h"
 #include "crypto/tls.h"
+#include "wps/http_client.h"
 #include "eap_server/eap.h"
 #include "eap_server/eap_sim_db.h"
 #include "eapol_auth/eapol_auth_sm.h"
@@ -146,6 +148,109 @@ static int hostapd_setup_radius_srv(struct hostapd_data *hapd)
 #endif /* RADIUS_SERVER */
 
 
+#ifdef CONFIG_OCSP_REFRESH
+
+#define OCSP_REFRESH_RETRY 60
+#define OCSP_MAX_RESPONSE 65536
+
+static void authsrv_ocsp_refresh(void *eloop_ctx, void *timeout_ctx);
+
+
+static void authsrv_ocsp_http_cb(void *ctx, struct http_client *c,
+				 enum http_client_event event)
+{
+	struct hostapd_data *hapd = ctx;
+	struct wpabuf *resp = NULL;
+	unsigned int valid_time, next = OCSP_REFRESH_RETRY;
+
+	if (event == HTTP_CLIENT_OK)
+		resp = http_client_get_body(c);
+	if (!resp) {
+		wpa_printf(MSG_INFO,
+			   "OCSP: Failed to fetch response from %s (event=%d)",
+			   hapd->conf->ocsp_stapling_responder, event);
+	} else if (tls_global_set_ocsp_response(hapd->ssl_ctx, resp,
+						&valid_time) < 0) {
+		wpa_printf(MSG_INFO, "OCSP: Ignore invalid response from %s",
+			   hapd->conf->ocsp_stapling_responder);
+	} else {
+		next = hapd->conf->ocsp_stapling_refresh;
+		/* Refresh well before the response expires */
+		if (valid_time && valid_time / 2 < next)
+			next = valid_time / 2;
+		if (next < OCSP_REFRESH_RETRY)
+			next = OCSP_REFRESH_RETRY;
+		wpa_printf(MSG_DEBUG,
+			   "OCSP: Updated stapling response (next refresh in %u seconds)",
+			   next);
+	}
+
+	http_client_free(c);
+	hapd->ocsp_http = NULL;
+	eloop_register_timeout(next, 0, authsrv_ocsp_refresh, hapd, NULL);
+}
+
+
+static void authsrv_ocsp_refresh(void *eloop_ctx, void *timeout_ctx)
+{
+	struct hostapd_data *hapd = eloop_ctx;
+	const char *responder = hapd->conf->ocsp_stapling_responder;
+	struct wpabuf *ocsp_req, *req = NULL;
+	struct sockaddr_in dst;
+	char *url = NULL, *path;
+
+	http_client_free(hapd->ocsp_http);
+	hapd->ocsp_http = NULL;
+
+	ocsp_req = tls_global_get_ocsp_request(hapd->ssl_ctx);
+	if (!ocsp_req) {
+		wpa_printf(MSG_INFO, "OCSP: Could not build OCSP request");
+		goto fail;
+	}
+
+	if (os_strncmp(responder, "http://", 7) == 0)
+		url = http_client_url_parse(responder, &dst, &path);
+	if (!url) {
+		wpa_printf(MSG_INFO, "OCSP: Unsupported responder URL '%s'",
+			   responder);
+		goto fail;
+	}
+
+	req = wpabuf_alloc(os_strlen(path) + 200 + wpabuf_len(ocsp_req));
+	if (!req)
+		goto fail;
+	wpabuf_printf(req,
+		      "POST %s HTTP/1.0\r\n"
+		      "Host: %s:%d\r\n"
+		      "Content-Type: application/ocsp-request\r\n"
+		      "Content-Length: %u\r\n"
+		      "\r\n",
+		      path, inet_ntoa(dst.sin_addr), ntohs(dst.sin_port),
+		      (unsigned int) wpabuf_len(ocsp_req));
+	wpabuf_put_buf(req, ocsp_req);
+
+	wpa_printf(MSG_DEBUG, "OCSP: Request stapling response from %s",
+		   responder);
+	hapd->ocsp_http = http_client_addr(&dst, req, OCSP_MAX_RESPONSE,
+					   authsrv_ocsp_http_cb, hapd);
+	if (!hapd->ocsp_http)
+		goto fail;
+
+	os_free(url);
+	wpabuf_free(ocsp_req);
+	return;
+
+fail:
+	os_free(url);
+	wpabuf_free(ocsp_req);
+	wpabuf_free(req);
+	eloop_register_timeout(OCSP_REFRESH_RETRY, 0, authsrv_ocsp_refresh,
+			       hapd, NULL);
+}
+
+#endif /* CONFIG_OCSP_REFRESH */
+
+
 int authsrv_init(struct hostapd_data *hapd)
 {
 #ifdef EAP_TLS_FUNCS
@@ -188,6 +293,17 @@ int authsrv_init(struct hostapd_data *hapd)
 			authsrv_deinit(hapd);
 			return -1;
 		}
+
+		if (hapd->conf->ocsp_stapling_responder) {
+#ifdef CONFIG_OCSP_REFRESH
+			/* Fetch the first response in the background */
+			eloop_register_timeout(0, 0, authsrv_ocsp_refresh,
+					       hapd, NULL);
+#else /* CONFIG_OCSP_REFRESH */
+			wpa_printf(MSG_INFO,
+				   "ocsp_stapling_responder not supported in this build");
+#endif /* CONFIG_OCSP_REFRESH */
+		}
 	}
 #endif /* EAP_TLS_FUNCS */
 
@@ -224,6 +340,11 @@ void authsrv_deinit(struct hostapd_data *hapd)
 #endif /* RADIUS_SERVER */
 
 #ifdef EAP_TLS_FUNCS
+#ifdef CONFIG_OCSP_REFRESH
+	eloop_cancel_timeout(authsrv_ocsp_refresh, hapd, NULL);
+	http_client_free(hapd->ocsp_http);
+	hapd->ocsp_http = NULL;
+#endif /* CONFIG_OCSP_REFRESH */
 	if (hapd->ssl_ctx) {
 		tls_deinit(hapd->ssl_ctx);
 		hapd->ssl_ctx = NULL;
@@ -13,6 +13,7 @@
 #ifndef CONFIG_NATIVE_WINDOWS
 
 #include "utils/common.h"
+#include "utils/eloop.h"
 #include "common/ieee802_11_defs.h"
 #include "common/ieee802_11_common.h"
 #include "common/hw_features_common.h"
@@ -24,6 +25,7 @@
 #include "wmm.h"
 #include "ap_config.h"
 #include "sta_info.h"
+#include "ieee802_11_auth.h"
 #include "p2p_hostapd.h"
 #include "ap_drv_ops.h"
 #include "beacon.h"
@@ -698,6 +700,97 @@ void sta_track_claim_taxonomy_info(struct hostapd_iface *iface, const u8 *addr,
 #endif /* CONFIG_TAXONOMY */
 
 
+#define PROBE_REQ_RATE_SLOTS 64
+
+struct probe_req_rate {
+	u8 addr[ETH_ALEN];
+	struct os_reltime start;
+	unsigned int count;
+};
+
+
+static int probe_req_rate_limited(struct hostapd_data *hapd, const u8 *addr)
+{
+	struct probe_req_rate *entry;
+	struct os_reltime now;
+	unsigned int idx;
+
+	if (!hapd->probe_req_rate) {
+		hapd->probe_req_rate = os_calloc(PROBE_REQ_RATE_SLOTS,
+						 sizeof(*entry));
+		if (!hapd->probe_req_rate)
+			return 0;
+	}
+
+	/* Colliding source addresses simply take over the slot */
+	idx = (addr[3] ^ addr[4] ^ addr[5]) % PROBE_REQ_RATE_SLOTS;
+	entry = &hapd->probe_req_rate[idx];
+	os_get_reltime(&now);
+	if (os_memcmp(entry->addr, addr, ETH_ALEN) != 0 ||
+	    os_reltime_expired(&now, &entry->start, 1)) {
+		os_memcpy(entry->addr, addr, ETH_ALEN);
+		entry->start = now;
+		entry->count = 0;
+	}
+
+	return ++entry->count > hapd->conf->probe_resp_rate_limit;
+}
+
+
+/*
+ * Cheap checks done before the full element parsing to avoid spending time on
+ * Probe Request frames that would be dropped anyway. Only the SSID and SSID
+ * List elements are located here; anything more involved is left for
+ * ieee802_11_parse_elems() and the checks in handle_probe_req().
+ */
+static int probe_req_prefilter(struct hostapd_data *hapd,
+			       const struct ieee80211_mgmt *mgmt,
+			       const u8 *ie, size_t ie_len)
+{
+	const u8 *ssid;
+
+	if (hapd->conf->no_probe_resp_if_denied &&
+	    hostapd_check_acl(hapd, mgmt->sa, NULL) == HOSTAPD_ACL_REJECT) {
+		wpa_printf(MSG_MSGDUMP, "Probe Request from " MACSTR
+			   " ignored due to MAC ACL", MAC2STR(mgmt->sa));
+		hapd->probe_req_drop_acl++;
+		return -1;
+	}
+
+	ssid = get_ie(ie, ie_len, WLAN_EID_SSID);
+	if (ssid && ssid[1] > 0 &&
+	    (ssid[1] != hapd->conf->ssid.ssid_len ||
+	     os_memcmp(ssid + 2, hapd->conf->ssid.ssid, ssid[1]) != 0) &&
+#ifdef CONFIG_P2P
+	    !((hapd->conf->p2p & P2P_GROUP_OWNER) &&
+	      ssid[1] == P2P_WILDCARD_SSID_LEN &&
+	      os_memcmp(ssid + 2, P2P_WILDCARD_SSID,
+			P2P_WILDCARD_SSID_LEN) == 0) &&
+#endif /* CONFIG_P2P */
+	    !get_ie(ie, ie_len, WLAN_EID_SSID_LIST)) {
+		if (!(mgmt->da[0] & 0x01)) {
+			wpa_printf(MSG_MSGDUMP, "Probe Request from " MACSTR
+				   " for foreign SSID '%s' (DA " MACSTR ")",
+				   MAC2STR(mgmt->sa),
+				   wpa_ssid_txt(ssid + 2, ssid[1]),
+				   MAC2STR(mgmt->da));
+		}
+		hapd->probe_req_drop_ssid++;
+		return -1;
+	}
+
+	if (hapd->conf->probe_resp_rate_limit &&
+	    probe_req_rate_limited(hapd, mgmt->sa)) {
+		wpa_printf(MSG_MSGDUMP, "Probe Request from " MACSTR
+			   " ignored due to rate limit", MAC2STR(mgmt->sa));
+		hapd->probe_req_drop_rate++;
+		return -1;
+	}
+
+	return 0;
+}
+
+
 void handle_probe_req(struct hostapd_data *hapd,
 		      const struct ieee80211_mgmt *mgmt, size_t len,
 		      int ssi_signal)
@@ -729,6 +822,24 @@ void handle_probe_req(struct hostapd_data *hapd,
 	if (!hapd->iconf->send_probe_response)
 		return;
 
+#ifdef CONFIG_TAXONOMY
+	{
+		struct sta_info *sta;
+		struct hostapd_sta_info *info;
+
+		if ((sta = ap_get_sta(hapd, mgmt->sa)) != NULL) {
+			taxonomy_sta_info_probe_req(hapd, sta, ie, ie_len);
+		} else if ((info = sta_track_get(hapd->iface,
+						 mgmt->sa)) != NULL) {
+			taxonomy_hostapd_sta_info_probe_req(hapd, info,
+							    ie, ie_len);
+		}
+	}
+#endif /* CONFIG_TAXONOMY */
+
+	if (probe_req_prefilter(hapd, mgmt, ie, ie_len) < 0)
+		return;
+
 	if (ieee802_11_parse_elems(ie, ie_len, &elems, 0) == ParseFailed) {
 		wpa_printf(MSG_DEBUG, "Could not parse ProbeReq from " MACSTR,
 			   MAC2STR(mgmt->sa));
@@ -807,21 +918,6 @@ void handle_probe_req(struct hostapd_data *hapd,
 	}
 #endif /* CONFIG_P2P */
 
-#ifdef CONFIG_TAXONOMY
-	{
-		struct sta_info *sta;
-		struct hostapd_sta_info *info;
-
-		if ((sta = ap_get_sta(hapd, mgmt->sa)) != NULL) {
-			taxonomy_sta_info_probe_req(hapd, sta, ie, ie_len);
-		} else if ((info = sta_track_get(hapd->iface,
-						 mgmt->sa)) != NULL) {
-			taxonomy_hostapd_sta_info_probe_req(hapd, info,
-							    ie, ie_len);
-		}
-	}
-#endif /* CONFIG_TAXONOMY */
-
 	res = ssid_match(hapd, elems.ssid, elems.ssid_len,
 			 elems.ssid_list, elems.ssid_list_len);
 	if (res == NO_SSID_MATCH) {
@@ -1342,10 +1438,15 @@ int ieee802_11_set_beacon(struct hostapd_data *hapd)
 
 	res = hostapd_drv_set_ap(hapd, &params);
 	hostapd_free_ap_extra_ies(hapd, beacon, proberesp, assocresp);
-	if (res)
+	if (res) {
 		wpa_printf(MSG_ERROR, "Failed to set beacon parameters");
-	else
+	} else {
+		/* BSS Load values advertised in the installed Beacon frame */
+		hapd->bss_load_num_sta = hapd->num_sta;
+		hapd->bss_load_chan_util = iface->channel_utilization;
+		hapd->beacon_set_count++;
 		ret = 0;
+	}
 fail:
 	ieee802_11_free_ap_params(&params);
 	return ret;
@@ -1357,6 +1458,9 @@ int ieee802_11_set_beacons(struct hostapd_iface *iface)
 	size_t i;
 	int ret = 0;
 
+	/* This covers any update that was scheduled for later */
+	ieee802_11_cancel_scheduled_beacons(iface);
+
 	for (i = 0; i < iface->num_bss; i++) {
 		if (iface->bss[i]->started &&
 		    ieee802_11_set_beacon(iface->bss[i]) < 0)
@@ -1382,4 +1486,40 @@ int ieee802_11_update_beacons(struct hostapd_iface *iface)
 	return ret;
 }
 
+
+static void ieee802_11_scheduled_beacons_timeout(void *eloop_ctx,
+						 void *timeout_ctx)
+{
+	struct hostapd_iface *iface = eloop_ctx;
+
+	ieee802_11_update_beacons(iface);
+}
+
+
+/**
+ * ieee802_11_schedule_beacons - Request a Beacon update for all BSSes
+ * @iface: Pointer to interface data
+ *
+ * This is used for changes that do not need to be reflected in the Beacon
+ * frames immediately, e.g., ERP and HT protection changes due to STAs joining
+ * or leaving. Multiple requests within BEACON_UPDATE_DELAY_USEC result in a
+ * single update to the driver.
+ */
+void ieee802_11_schedule_beacons(struct hostapd_iface *iface)
+{
+	if (eloop_is_timeout_registered(ieee802_11_scheduled_beacons_timeout,
+					iface, NULL))
+		return;
+	eloop_register_timeout(0, BEACON_UPDATE_DELAY_USEC,
+			       ieee802_11_scheduled_beacons_timeout, iface,
+			       NULL);
+}
+
+
+void ieee802_11_cancel_scheduled_beacons(struct hostapd_iface *iface)
+{
+	eloop_cancel_timeout(ieee802_11_scheduled_beacons_timeout, iface,
+			     NULL);
+}
+
 #endif /* CONFIG_NATIVE_WINDOWS */
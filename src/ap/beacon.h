@@ -12,12 +12,18 @@
 
 struct ieee80211_mgmt;
 
+/* Window for coalescing Beacon updates requested with
+ * ieee802_11_schedule_beacons() */
+#define BEACON_UPDATE_DELAY_USEC 10000
+
 void handle_probe_req(struct hostapd_data *hapd,
 		      const struct ieee80211_mgmt *mgmt, size_t len,
 		      int ssi_signal);
 int ieee802_11_set_beacon(struct hostapd_data *hapd);
 int ieee802_11_set_beacons(struct hostapd_iface *iface);
 int ieee802_11_update_beacons(struct hostapd_iface *iface);
+void ieee802_11_schedule_beacons(struct hostapd_iface *iface);
+void ieee802_11_cancel_scheduled_beacons(struct hostapd_iface *iface);
 int ieee802_11_build_ap_params(struct hostapd_data *hapd,
 			       struct wpa_driver_ap_params *params);
 void ieee802_11_free_ap_params(struct wpa_driver_ap_params *params);
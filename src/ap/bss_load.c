@@ -31,7 +31,10 @@ static void update_channel_utilization(void *eloop_data, void *user_data)
 		return;
 	}
 
-	ieee802_11_set_beacon(hapd);
+	/* Avoid a driver update if the BSS Load element would not change */
+	if (hapd->bss_load_num_sta != hapd->num_sta ||
+	    hapd->bss_load_chan_util != hapd->iface->channel_utilization)
+		ieee802_11_set_beacon(hapd);
 
 	sec = ((hapd->bss_load_update_timeout / 1000) * 1024) / 1000;
 	usec = (hapd->bss_load_update_timeout % 1000) * 1024;
@@ -566,13 +566,21 @@ int hostapd_ctrl_iface_status(struct hostapd_data *hapd, char *buf,
 				  "bss[%d]=%s\n"
 				  "bssid[%d]=" MACSTR "\n"
 				  "ssid[%d]=%s\n"
-				  "num_sta[%d]=%d\n",
+				  "num_sta[%d]=%d\n"
+				  "probe_req_drop_ssid[%d]=%u\n"
+				  "probe_req_drop_acl[%d]=%u\n"
+				  "probe_req_drop_rate[%d]=%u\n"
+				  "beacon_set_count[%d]=%u\n",
 				  (int) i, bss->conf->iface,
 				  (int) i, MAC2STR(bss->own_addr),
 				  (int) i,
 				  wpa_ssid_txt(bss->conf->ssid.ssid,
 					       bss->conf->ssid.ssid_len),
-				  (int) i, bss->num_sta);
+				  (int) i, bss->num_sta,
+				  (int) i, bss->probe_req_drop_ssid,
+				  (int) i, bss->probe_req_drop_acl,
+				  (int) i, bss->probe_req_drop_rate,
+				  (int) i, bss->beacon_set_count);
 		if (os_snprintf_error(buflen - len, ret))
 			return len;
 		len += ret;
@@ -21,6 +21,7 @@ struct hostapd_data;
 struct sta_info;
 struct ieee80211_ht_capabilities;
 struct full_dynamic_vlan;
+struct probe_req_rate;
 enum wps_event;
 union wps_event_data;
 #ifdef CONFIG_MESH
@@ -169,6 +170,9 @@ struct hostapd_data {
 	struct dl_list ctrl_dst;
 
 	void *ssl_ctx;
+#ifdef CONFIG_OCSP_REFRESH
+	struct http_client *ocsp_http;
+#endif /* CONFIG_OCSP_REFRESH */
 	void *eap_sim_db_priv;
 	struct radius_server_data *radius_srv;
 	struct dl_list erp_keys; /* struct eap_server_erp_key */
@@ -201,6 +205,12 @@ struct hostapd_data {
 	struct hostapd_probereq_cb *probereq_cb;
 	size_t num_probereq_cb;
 
+	/* Probe Request frames dropped before full element parsing */
+	unsigned int probe_req_drop_ssid;
+	unsigned int probe_req_drop_acl;
+	unsigned int probe_req_drop_rate;
+	struct probe_req_rate *probe_req_rate;
+
 	void (*public_action_cb)(void *ctx, const u8 *buf, size_t len,
 				 int freq);
 	void *public_action_cb_ctx;
@@ -244,6 +254,11 @@ struct hostapd_data {
 
 	/* BSS Load */
 	unsigned int bss_load_update_timeout;
+	/* Values advertised in the last Beacon BSS Load element */
+	unsigned int bss_load_num_sta;
+	u8 bss_load_chan_util;
+	/* Number of Beacon updates installed to the driver */
+	unsigned int beacon_set_count;
 
 #ifdef CONFIG_P2P
 	struct p2p_data *p2p;
@@ -274,6 +289,9 @@ struct hostapd_data {
 	struct wpabuf *mesh_pending_auth;
 	struct os_reltime mesh_pending_auth_time;
 	u8 mesh_required_peer[ETH_ALEN];
+	u8 *mesh_llid_map; /* bitmap of local link IDs in use */
+	struct os_reltime mesh_admit_time;
+	unsigned int mesh_admit_count;
 #endif /* CONFIG_MESH */
 
 #ifdef CONFIG_SQLITE
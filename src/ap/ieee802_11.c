@@ -12,6 +12,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/metrics.h"
 #include "crypto/crypto.h"
 #include "crypto/sha256.h"
 #include "crypto/random.h"
@@ -2212,7 +2213,7 @@ static void handle_assoc(struct hostapd_data *hapd,
 		sta->nonerp_set = 1;
 		hapd->iface->num_sta_non_erp++;
 		if (hapd->iface->num_sta_non_erp == 1)
-			ieee802_11_set_beacons(hapd->iface);
+			ieee802_11_schedule_beacons(hapd->iface);
 	}
 
 	if (!(sta->capability & WLAN_CAPABILITY_SHORT_SLOT_TIME) &&
@@ -2222,7 +2223,7 @@ static void handle_assoc(struct hostapd_data *hapd,
 		if (hapd->iface->current_mode->mode ==
 		    HOSTAPD_MODE_IEEE80211G &&
 		    hapd->iface->num_sta_no_short_slot_time == 1)
-			ieee802_11_set_beacons(hapd->iface);
+			ieee802_11_schedule_beacons(hapd->iface);
 	}
 
 	if (sta->capability & WLAN_CAPABILITY_SHORT_PREAMBLE)
@@ -2236,7 +2237,7 @@ static void handle_assoc(struct hostapd_data *hapd,
 		hapd->iface->num_sta_no_short_preamble++;
 		if (hapd->iface->current_mode->mode == HOSTAPD_MODE_IEEE80211G
 		    && hapd->iface->num_sta_no_short_preamble == 1)
-			ieee802_11_set_beacons(hapd->iface);
+			ieee802_11_schedule_beacons(hapd->iface);
 	}
 
 #ifdef CONFIG_IEEE80211N
@@ -2610,6 +2611,26 @@ static int handle_action(struct hostapd_data *hapd,
 }
 
 
+static void ieee802_11_rx_mgmt_metric(u16 stype)
+{
+	static const char * const names[16] = {
+		"ap.rx_mgmt.assoc_req", "ap.rx_mgmt.assoc_resp",
+		"ap.rx_mgmt.reassoc_req", "ap.rx_mgmt.reassoc_resp",
+		"ap.rx_mgmt.probe_req", "ap.rx_mgmt.probe_resp",
+		"ap.rx_mgmt.timing_adv", "ap.rx_mgmt.reserved7",
+		"ap.rx_mgmt.beacon", "ap.rx_mgmt.atim",
+		"ap.rx_mgmt.disassoc", "ap.rx_mgmt.auth",
+		"ap.rx_mgmt.deauth", "ap.rx_mgmt.action",
+		"ap.rx_mgmt.action_no_ack", "ap.rx_mgmt.reserved15"
+	};
+	static struct metric *rx[16];
+
+	if (!rx[stype])
+		rx[stype] = metrics_get(names[stype], METRIC_COUNTER);
+	metrics_inc(rx[stype]);
+}
+
+
 /**
  * ieee802_11_mgmt - process incoming IEEE 802.11 management frames
  * @hapd: hostapd BSS data structure (the BSS to which the management frame was
@@ -2636,6 +2657,7 @@ int ieee802_11_mgmt(struct hostapd_data *hapd, const u8 *buf, size_t len,
 	mgmt = (struct ieee80211_mgmt *) buf;
 	fc = le_to_host16(mgmt->frame_control);
 	stype = WLAN_FC_GET_STYPE(fc);
+	ieee802_11_rx_mgmt_metric(stype);
 
 	if (stype == WLAN_FC_STYPE_BEACON) {
 		handle_beacon(hapd, mgmt, len, fi);
@@ -12,6 +12,7 @@
 #include "utils/eloop.h"
 #include "utils/state_machine.h"
 #include "utils/bitfield.h"
+#include "utils/metrics.h"
 #include "common/ieee802_11_defs.h"
 #include "crypto/aes.h"
 #include "crypto/aes_wrap.h"
@@ -70,6 +71,37 @@ static const int dot11RSNAConfigPMKLifetime = 43200;
 static const int dot11RSNAConfigPMKReauthThreshold = 70;
 static const int dot11RSNAConfigSATimeout = 60;
 
+enum wpa_metric_id {
+	WPA_METRIC_MSG1_TX,
+	WPA_METRIC_MSG2_MIC_FAILURES,
+	WPA_METRIC_MSG3_TX,
+	WPA_METRIC_DURATION,
+	WPA_METRIC_COMPLETED,
+	WPA_METRIC_FAILURES,
+	NUM_WPA_METRICS
+};
+
+
+static struct metric * wpa_metric(enum wpa_metric_id id)
+{
+	static const struct {
+		const char *name;
+		enum metric_type type;
+	} defs[NUM_WPA_METRICS] = {
+		{ "wpa.4way.msg1_tx", METRIC_COUNTER },
+		{ "wpa.4way.msg2_mic_failures", METRIC_COUNTER },
+		{ "wpa.4way.msg3_tx", METRIC_COUNTER },
+		{ "wpa.4way.duration_ms", METRIC_HISTOGRAM },
+		{ "wpa.4way.completed", METRIC_COUNTER },
+		{ "wpa.4way.failures", METRIC_COUNTER },
+	};
+	static struct metric *m[NUM_WPA_METRICS];
+
+	if (!m[id])
+		m[id] = metrics_get(defs[id].name, defs[id].type);
+	return m[id];
+}
+
 
 static inline int wpa_auth_mic_failure_report(
 	struct wpa_authenticator *wpa_auth, const u8 *addr)
@@ -530,6 +562,8 @@ void wpa_deinit(struct wpa_authenticator *wpa_auth)
 
 
 	os_free(wpa_auth->wpa_ie);
+	os_free(wpa_auth->eapol_tx);
+	bin_clear_free(wpa_auth->kde_buf, wpa_auth->kde_buf_size);
 
 	group = wpa_auth->group;
 	while (group) {
@@ -795,6 +829,21 @@ static int ft_check_msg_2_of_4(struct wpa_authenticator *wpa_auth,
 #endif /* CONFIG_IEEE80211R */
 
 
+/*
+ * Get a buffer of at least len octets. The buffer is reused for following
+ * frames and only reallocated when it needs to grow.
+ */
+static u8 * wpa_get_buf(u8 **buf, size_t *size, size_t len)
+{
+	if (*buf == NULL || *size < len) {
+		bin_clear_free(*buf, *size);
+		*buf = os_malloc(len);
+		*size = *buf ? len : 0;
+	}
+	return *buf;
+}
+
+
 static int wpa_receive_error_report(struct wpa_authenticator *wpa_auth,
 				    struct wpa_state_machine *sm, int group)
 {
@@ -1325,9 +1374,8 @@ continue_processing:
 	}
 #endif /* CONFIG_PEERKEY */
 
-	os_free(sm->last_rx_eapol_key);
-	sm->last_rx_eapol_key = os_malloc(data_len);
-	if (sm->last_rx_eapol_key == NULL)
+	if (!wpa_get_buf(&sm->last_rx_eapol_key, &sm->last_rx_eapol_key_size,
+			 data_len))
 		return;
 	os_memcpy(sm->last_rx_eapol_key, data, data_len);
 	sm->last_rx_eapol_key_len = data_len;
@@ -1398,7 +1446,7 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 	size_t len, mic_len, keyhdrlen;
 	int alg;
 	int key_data_len, pad_len = 0;
-	u8 *buf, *pos;
+	u8 *buf;
 	int version, pairwise;
 	int i;
 	u8 *key_mic, *key_data;
@@ -1449,9 +1497,12 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 	if (!mic_len && encr)
 		len += AES_BLOCK_SIZE;
 
-	hdr = os_zalloc(len);
+	hdr = (struct ieee802_1x_hdr *) wpa_get_buf(&wpa_auth->eapol_tx,
+						    &wpa_auth->eapol_tx_size,
+						    len);
 	if (hdr == NULL)
 		return;
+	os_memset(hdr, 0, len);
 	hdr->version = wpa_auth->conf.eapol_version;
 	hdr->type = IEEE802_1X_TYPE_EAPOL_KEY;
 	hdr->length = host_to_be16(len  - sizeof(*hdr));
@@ -1521,30 +1572,24 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			    key_mic + 2, AES_BLOCK_SIZE + kde_len);
 #endif /* CONFIG_FILS */
 	} else if (encr && kde) {
-		buf = os_zalloc(key_data_len);
-		if (buf == NULL) {
-			os_free(hdr);
-			return;
-		}
-		pos = buf;
-		os_memcpy(pos, kde, kde_len);
-		pos += kde_len;
-
+		/*
+		 * Build the plaintext Key Data after the space reserved for
+		 * the AES key wrap IV (if any) and encrypt it in place.
+		 */
+		buf = key_data + key_data_len - kde_len - pad_len;
+		os_memcpy(buf, kde, kde_len);
 		if (pad_len)
-			*pos++ = 0xdd;
+			buf[kde_len] = 0xdd;
 
 		wpa_hexdump_key(MSG_DEBUG, "Plaintext EAPOL-Key Key Data",
-				buf, key_data_len);
+				buf, kde_len + pad_len);
 		if (version == WPA_KEY_INFO_TYPE_HMAC_SHA1_AES ||
 		    sm->wpa_key_mgmt == WPA_KEY_MGMT_OSEN ||
 		    wpa_key_mgmt_suite_b(sm->wpa_key_mgmt) ||
 		    version == WPA_KEY_INFO_TYPE_AES_128_CMAC) {
 			if (aes_wrap(sm->PTK.kek, sm->PTK.kek_len,
-				     (key_data_len - 8) / 8, buf, key_data)) {
-				os_free(hdr);
-				os_free(buf);
+				     (key_data_len - 8) / 8, buf, key_data))
 				return;
-			}
 			WPA_PUT_BE16(key_mic + mic_len, key_data_len);
 #ifndef CONFIG_NO_RC4
 		} else if (sm->PTK.kek_len == 16) {
@@ -1554,16 +1599,12 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			inc_byte_array(sm->group->Counter, WPA_NONCE_LEN);
 			os_memcpy(ek, key->key_iv, 16);
 			os_memcpy(ek + 16, sm->PTK.kek, sm->PTK.kek_len);
-			os_memcpy(key_data, buf, key_data_len);
 			rc4_skip(ek, 32, 256, key_data, key_data_len);
 			WPA_PUT_BE16(key_mic + mic_len, key_data_len);
 #endif /* CONFIG_NO_RC4 */
 		} else {
-			os_free(hdr);
-			os_free(buf);
 			return;
 		}
-		os_free(buf);
 	}
 
 	if (key_info & WPA_KEY_INFO_MIC) {
@@ -1571,7 +1612,6 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			wpa_auth_logger(wpa_auth, sm->addr, LOGGER_DEBUG,
 					"PTK not valid when sending EAPOL-Key "
 					"frame");
-			os_free(hdr);
 			return;
 		}
 
@@ -1594,7 +1634,6 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			   1);
 	wpa_auth_send_eapol(wpa_auth, sm->addr, (u8 *) hdr, len,
 			    sm->pairwise_set);
-	os_free(hdr);
 }
 
 
@@ -1985,6 +2024,9 @@ SM_STATE(WPA_PTK, PTKSTART)
 
 	wpa_auth_logger(sm->wpa_auth, sm->addr, LOGGER_DEBUG,
 			"sending 1/4 msg of 4-Way Handshake");
+	metrics_inc(wpa_metric(WPA_METRIC_MSG1_TX));
+	if (sm->TimeoutCtr == 1)
+		os_get_reltime(&sm->ptk_start);
 	/*
 	 * TODO: Could add PMKID even with WPA2-PSK, but only if there is only
 	 * one possible PSK for this STA.
@@ -2155,6 +2197,7 @@ SM_STATE(WPA_PTK, PTKCALCNEGOTIATING)
 	if (!ok) {
 		wpa_auth_logger(sm->wpa_auth, sm->addr, LOGGER_DEBUG,
 				"invalid MIC in msg 2/4 of 4-Way Handshake");
+		metrics_inc(wpa_metric(WPA_METRIC_MSG2_MIC_FAILURES));
 		if (psk_found)
 			wpa_auth_psk_failure_report(sm->wpa_auth, sm->addr);
 		return;
@@ -2376,6 +2419,7 @@ SM_STATE(WPA_PTK, PTKINITNEGOTIATING)
 	}
 	wpa_auth_logger(sm->wpa_auth, sm->addr, LOGGER_DEBUG,
 			"sending 3/4 msg of 4-Way Handshake");
+	metrics_inc(wpa_metric(WPA_METRIC_MSG3_TX));
 	if (sm->wpa == WPA_VERSION_WPA2) {
 		/* WPA2 send GTK in the 4-way handshake */
 		secure = 1;
@@ -2429,7 +2473,8 @@ SM_STATE(WPA_PTK, PTKINITNEGOTIATING)
 	if (WPA_GET_BE32(sm->ip_addr) > 0)
 		kde_len += 2 + RSN_SELECTOR_LEN + 3 * 4;
 #endif /* CONFIG_P2P */
-	kde = os_malloc(kde_len);
+	kde = wpa_get_buf(&sm->wpa_auth->kde_buf, &sm->wpa_auth->kde_buf_size,
+			  kde_len);
 	if (kde == NULL)
 		return;
 
@@ -2446,7 +2491,7 @@ SM_STATE(WPA_PTK, PTKINITNEGOTIATING)
 		if (res < 0) {
 			wpa_printf(MSG_ERROR, "FT: Failed to insert "
 				   "PMKR1Name into RSN IE in EAPOL-Key data");
-			os_free(kde);
+			os_memset(kde, 0, kde_len);
 			return;
 		}
 		pos -= wpa_ie_len;
@@ -2483,7 +2528,7 @@ SM_STATE(WPA_PTK, PTKINITNEGOTIATING)
 		if (res < 0) {
 			wpa_printf(MSG_ERROR, "FT: Failed to insert FTIE "
 				   "into EAPOL-Key Key Data");
-			os_free(kde);
+			os_memset(kde, 0, kde_len);
 			return;
 		}
 		pos += res;
@@ -2520,7 +2565,7 @@ SM_STATE(WPA_PTK, PTKINITNEGOTIATING)
 		       WPA_KEY_INFO_ACK | WPA_KEY_INFO_INSTALL |
 		       WPA_KEY_INFO_KEY_TYPE,
 		       _rsc, sm->ANonce, kde, pos - kde, keyidx, encr);
-	os_free(kde);
+	os_memset(kde, 0, kde_len);
 }
 
 
@@ -2571,6 +2616,16 @@ SM_STATE(WPA_PTK, PTKINITDONE)
 	wpa_auth_vlogger(sm->wpa_auth, sm->addr, LOGGER_INFO,
 			 "pairwise key handshake completed (%s)",
 			 sm->wpa == WPA_VERSION_WPA ? "WPA" : "RSN");
+	if (sm->ptk_start.sec) {
+		struct os_reltime now, age;
+
+		os_get_reltime(&now);
+		os_reltime_sub(&now, &sm->ptk_start, &age);
+		metrics_observe(wpa_metric(WPA_METRIC_DURATION),
+				age.sec * 1000 + age.usec / 1000);
+		sm->ptk_start.sec = 0;
+	}
+	metrics_inc(wpa_metric(WPA_METRIC_COMPLETED));
 
 #ifdef CONFIG_IEEE80211R
 	wpa_ft_push_pmk_r1(sm->wpa_auth, sm->addr);
@@ -2625,6 +2680,7 @@ SM_STEP(WPA_PTK)
 			SM_ENTER(WPA_PTK, PTKSTART);
 		else {
 			wpa_auth->dot11RSNA4WayHandshakeFailures++;
+			metrics_inc(wpa_metric(WPA_METRIC_FAILURES));
 			wpa_auth_logger(sm->wpa_auth, sm->addr, LOGGER_INFO,
 					"INITPMK - keyAvailable = false");
 			SM_ENTER(WPA_PTK, DISCONNECT);
@@ -2638,6 +2694,7 @@ SM_STEP(WPA_PTK)
 			wpa_auth_logger(sm->wpa_auth, sm->addr, LOGGER_INFO,
 					"no PSK configured for the STA");
 			wpa_auth->dot11RSNA4WayHandshakeFailures++;
+			metrics_inc(wpa_metric(WPA_METRIC_FAILURES));
 			SM_ENTER(WPA_PTK, DISCONNECT);
 		}
 		break;
@@ -2648,6 +2705,7 @@ SM_STEP(WPA_PTK)
 		else if (sm->TimeoutCtr >
 			 (int) dot11RSNAConfigPairwiseUpdateCount) {
 			wpa_auth->dot11RSNA4WayHandshakeFailures++;
+			metrics_inc(wpa_metric(WPA_METRIC_FAILURES));
 			wpa_auth_vlogger(sm->wpa_auth, sm->addr, LOGGER_DEBUG,
 					 "PTKSTART: Retry limit %d reached",
 					 dot11RSNAConfigPairwiseUpdateCount);
@@ -2676,6 +2734,7 @@ SM_STEP(WPA_PTK)
 		else if (sm->TimeoutCtr >
 			 (int) dot11RSNAConfigPairwiseUpdateCount) {
 			wpa_auth->dot11RSNA4WayHandshakeFailures++;
+			metrics_inc(wpa_metric(WPA_METRIC_FAILURES));
 			wpa_auth_vlogger(sm->wpa_auth, sm->addr, LOGGER_DEBUG,
 					 "PTKINITNEGOTIATING: Retry limit %d "
 					 "reached",
@@ -2743,7 +2802,8 @@ SM_STATE(WPA_PTK_GROUP, REKEYNEGOTIATING)
 	if (sm->wpa == WPA_VERSION_WPA2) {
 		kde_len = 2 + RSN_SELECTOR_LEN + 2 + gsm->GTK_len +
 			ieee80211w_kde_len(sm);
-		kde_buf = os_malloc(kde_len);
+		kde_buf = wpa_get_buf(&sm->wpa_auth->kde_buf,
+				      &sm->wpa_auth->kde_buf_size, kde_len);
 		if (kde_buf == NULL)
 			return;
 
@@ -2766,7 +2826,8 @@ SM_STATE(WPA_PTK_GROUP, REKEYNEGOTIATING)
 		       (!sm->Pair ? WPA_KEY_INFO_INSTALL : 0),
 		       rsc, gsm->GNonce, kde, kde_len, gsm->GN, 1);
 
-	os_free(kde_buf);
+	if (kde_buf)
+		os_memset(kde_buf, 0, kde_len);
 }
 
 
@@ -3206,6 +3267,24 @@ void wpa_gtk_rekey(struct wpa_authenticator *wpa_auth)
 }
 
 
+/**
+ * wpa_auth_force_gtk_rekey - Start GTK rekeying immediately
+ * @wpa_auth: Pointer to WPA authenticator data
+ *
+ * This runs the same group rekeying as an expiry of the wpa_group_rekey timer,
+ * i.e., a new GTK is distributed to all stations with the group key handshake.
+ * The rekey timer is restarted. This differs from wpa_gtk_rekey(), which only
+ * rotates the local group keys without running the handshake.
+ */
+void wpa_auth_force_gtk_rekey(struct wpa_authenticator *wpa_auth)
+{
+	if (wpa_auth == NULL)
+		return;
+	eloop_cancel_timeout(wpa_rekey_gtk, wpa_auth, NULL);
+	wpa_rekey_gtk(wpa_auth, NULL);
+}
+
+
 static const char * wpa_bool_txt(int val)
 {
 	return val ? "TRUE" : "FALSE";
@@ -50,6 +50,7 @@ struct wpa_state_machine {
 	Boolean Disconnect;
 	int TimeoutCtr;
 	int GTimeoutCtr;
+	struct os_reltime ptk_start; /* first 4-way handshake msg 1/4 */
 	Boolean TimeoutEvt;
 	Boolean EAPOLKeyReceived;
 	Boolean EAPOLKeyPairwise;
@@ -79,6 +80,7 @@ struct wpa_state_machine {
 
 	u8 *last_rx_eapol_key; /* starting from IEEE 802.1X header */
 	size_t last_rx_eapol_key_len;
+	size_t last_rx_eapol_key_size; /* allocated size */
 
 	unsigned int changed:1;
 	unsigned int in_step_loop:1;
@@ -201,6 +203,15 @@ struct wpa_authenticator {
 	u8 *wpa_ie;
 	size_t wpa_ie_len;
 
+	/*
+	 * Buffers for building EAPOL-Key frames and their plaintext Key Data.
+	 * These are shared by all STAs and grown as needed.
+	 */
+	u8 *eapol_tx;
+	size_t eapol_tx_size;
+	u8 *kde_buf;
+	size_t kde_buf_size;
+
 	u8 addr[ETH_ALEN];
 
 	struct rsn_pmksa_cache *pmksa;
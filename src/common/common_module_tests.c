@@ -88,6 +88,55 @@ static int ieee802_11_parse_tests(void)
 }
 
 
+static int elem_index_tests(void)
+{
+	struct ieee802_11_elem_index idx;
+	u8 buf[2 * 40 + 3];
+	const struct ieee802_11_parse_test_data *test;
+	int i, eid, ret = 0;
+
+	wpa_printf(MSG_INFO, "ieee802_11_elem_index tests");
+
+	for (i = 0; parse_tests[i].data; i++) {
+		test = &parse_tests[i];
+		ieee802_11_elem_index_build(&idx, test->data, test->len);
+		for (eid = 0; eid < 256; eid++) {
+			if (ieee802_11_elem_index_get(&idx, test->data,
+						      test->len, eid) !=
+			    get_ie(test->data, test->len, eid)) {
+				wpa_printf(MSG_ERROR,
+					   "ieee802_11_elem_index test %d failed for eid %d",
+					   i, eid);
+				ret = -1;
+				break;
+			}
+		}
+	}
+
+	/* More distinct elements than index entries and a truncated element */
+	for (i = 0; i < 40; i++) {
+		buf[2 * i] = 100 + i;
+		buf[2 * i + 1] = 0;
+	}
+	buf[80] = 0;
+	buf[81] = 5;
+	buf[82] = 0;
+	ieee802_11_elem_index_build(&idx, buf, sizeof(buf));
+	for (eid = 0; eid < 256; eid++) {
+		if (ieee802_11_elem_index_get(&idx, buf, sizeof(buf), eid) !=
+		    get_ie(buf, sizeof(buf), eid)) {
+			wpa_printf(MSG_ERROR,
+				   "ieee802_11_elem_index overflow test failed for eid %d",
+				   eid);
+			ret = -1;
+			break;
+		}
+	}
+
+	return ret;
+}
+
+
 struct rsn_ie_parse_test_data {
 	u8 *data;
 	size_t len;
@@ -200,6 +249,7 @@ int common_module_tests(void)
 	wpa_printf(MSG_INFO, "common module tests");
 
 	if (ieee802_11_parse_tests() < 0 ||
+	    elem_index_tests() < 0 ||
 	    gas_tests() < 0 ||
 	    rsn_ie_parse_tests() < 0)
 		ret = -1;
@@ -1408,6 +1408,80 @@ const u8 * get_ie(const u8 *ies, size_t len, u8 eid)
 }
 
 
+/**
+ * ieee802_11_elem_index_build - Build an element index for an IEs buffer
+ * @idx: Buffer for the index
+ * @ies: Information elements buffer
+ * @len: Information elements buffer length
+ *
+ * The buffer is walked once in the same way as get_ie() does, i.e., parsing
+ * stops at the first truncated element.
+ */
+void ieee802_11_elem_index_build(struct ieee802_11_elem_index *idx,
+				 const u8 *ies, size_t len)
+{
+	const u8 *pos, *end;
+	u8 eid;
+
+	idx->num = 0;
+	if (len > 0xffff) {
+		/* Offsets would not fit; fall back to get_ie() for all IDs */
+		os_memset(idx->present, 0xff, sizeof(idx->present));
+		return;
+	}
+	os_memset(idx->present, 0, sizeof(idx->present));
+	if (!ies)
+		return;
+
+	pos = ies;
+	end = ies + len;
+	while (end - pos > 1) {
+		if (2 + pos[1] > end - pos)
+			break;
+
+		eid = pos[0];
+		if (!ieee802_11_elem_index_has(idx, eid)) {
+			idx->present[eid / 32] |= BIT(eid % 32);
+			if (idx->num < IEEE802_11_ELEM_INDEX_SIZE) {
+				idx->id[idx->num] = eid;
+				idx->offset[idx->num] = pos - ies;
+				idx->num++;
+			}
+		}
+
+		pos += 2 + pos[1];
+	}
+}
+
+
+/**
+ * ieee802_11_elem_index_get - Fetch an element using an element index
+ * @idx: Index built with ieee802_11_elem_index_build() for the same buffer
+ * @ies: Information elements buffer
+ * @len: Information elements buffer length
+ * @eid: Information element identifier (WLAN_EID_*)
+ * Returns: Pointer to the information element (id field) or %NULL if not found
+ *
+ * This returns the same element as get_ie() would for the same buffer.
+ */
+const u8 * ieee802_11_elem_index_get(const struct ieee802_11_elem_index *idx,
+				     const u8 *ies, size_t len, u8 eid)
+{
+	unsigned int i;
+
+	if (!ieee802_11_elem_index_has(idx, eid))
+		return NULL;
+
+	for (i = 0; i < idx->num; i++) {
+		if (idx->id[i] == eid)
+			return ies + idx->offset[i];
+	}
+
+	/* More distinct elements than index entries */
+	return get_ie(ies, len, eid);
+}
+
+
 size_t mbo_add_ie(u8 *buf, size_t len, const u8 *attr, size_t attr_len)
 {
 	/*
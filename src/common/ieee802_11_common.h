@@ -175,6 +175,32 @@ extern size_t global_op_class_size;
 
 const u8 * get_ie(const u8 *ies, size_t len, u8 eid);
 
+#define IEEE802_11_ELEM_INDEX_SIZE 32
+
+/*
+ * Compact index of an IEs buffer: a bitmap of the present element IDs and the
+ * offset of the first instance of each ID. Only the first
+ * IEEE802_11_ELEM_INDEX_SIZE distinct IDs get an offset entry; the remaining
+ * ones are marked present and looked up by walking the buffer.
+ */
+struct ieee802_11_elem_index {
+	u32 present[8];
+	u8 num;
+	u8 id[IEEE802_11_ELEM_INDEX_SIZE];
+	u16 offset[IEEE802_11_ELEM_INDEX_SIZE];
+};
+
+void ieee802_11_elem_index_build(struct ieee802_11_elem_index *idx,
+				 const u8 *ies, size_t len);
+const u8 * ieee802_11_elem_index_get(const struct ieee802_11_elem_index *idx,
+				     const u8 *ies, size_t len, u8 eid);
+
+static inline int
+ieee802_11_elem_index_has(const struct ieee802_11_elem_index *idx, u8 eid)
+{
+	return !!(idx->present[eid / 32] & BIT(eid % 32));
+}
+
 size_t mbo_add_ie(u8 *buf, size_t len, const u8 *attr, size_t attr_len);
 
 #endif /* IEEE802_11_COMMON_H */
@@ -20,7 +20,8 @@
  * @n: Length of the plaintext key in 64-bit units; e.g., 2 = 128-bit = 16
  * bytes
  * @cipher: Wrapped key to be unwrapped, (n + 1) * 64 bits
- * @plain: Plaintext key, n * 64 bits
+ * @plain: Plaintext key, n * 64 bits; this may be the same buffer as cipher
+ * to unwrap the key in place
  * Returns: 0 on success, -1 on failure (e.g., integrity verification failed)
  */
 int aes_unwrap(const u8 *kek, size_t kek_len, int n, const u8 *cipher,
@@ -34,7 +35,7 @@ int aes_unwrap(const u8 *kek, size_t kek_len, int n, const u8 *cipher,
 	/* 1) Initialize variables. */
 	os_memcpy(a, cipher, 8);
 	r = plain;
-	os_memcpy(r, cipher + 8, 8 * n);
+	os_memmove(r, cipher + 8, 8 * n);
 
 	ctx = aes_decrypt_init(kek, kek_len);
 	if (ctx == NULL)
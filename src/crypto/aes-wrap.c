@@ -19,7 +19,8 @@
  * @kek_len: Length of KEK in octets
  * @n: Length of the plaintext key in 64-bit units; e.g., 2 = 128-bit = 16
  * bytes
- * @plain: Plaintext key to be wrapped, n * 64 bits
+ * @plain: Plaintext key to be wrapped, n * 64 bits; this may point to
+ * cipher + 8 to wrap the key in place
  * @cipher: Wrapped key, (n + 1) * 64 bits
  * Returns: 0 on success, -1 on failure
  */
@@ -35,7 +36,7 @@ int aes_wrap(const u8 *kek, size_t kek_len, int n, const u8 *plain, u8 *cipher)
 
 	/* 1) Initialize variables. */
 	os_memset(a, 0xa6, 8);
-	os_memcpy(r, plain, 8 * n);
+	os_memmove(r, plain, 8 * n);
 
 	ctx = aes_encrypt_init(kek, kek_len);
 	if (ctx == NULL)
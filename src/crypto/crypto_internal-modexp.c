@@ -35,7 +35,11 @@ int crypto_mod_exp(const u8 *base, size_t base_len,
 	    bignum_set_unsigned_bin(bn_modulus, modulus, modulus_len) < 0)
 		goto error;
 
-	if (bignum_exptmod(bn_base, bn_exp, bn_modulus, bn_result) < 0)
+	/*
+	 * All current users pass in a secret (DH private key) exponent (see
+	 * bignum_exptmod_ct()).
+	 */
+	if (bignum_exptmod_ct(bn_base, bn_exp, bn_modulus, bn_result) < 0)
 		goto error;
 
 	ret = bignum_get_unsigned_bin(bn_result, result, result_len);
@@ -18,32 +18,75 @@
 #include "includes.h"
 
 #include "common.h"
-#include "crypto/aes_wrap.h"
+#include "crypto/aes.h"
 #include "milenage.h"
 
 
+struct milenage_ctx {
+	void *aes; /* expanded K */
+	u8 opc[16];
+};
+
+
 /**
- * milenage_f1 - Milenage f1 and f1* algorithms
+ * milenage_init - Initialize Milenage context for a subscriber
  * @opc: OPc = 128-bit value derived from OP and K
  * @k: K = 128-bit subscriber key
- * @_rand: RAND = 128-bit random challenge
- * @sqn: SQN = 48-bit sequence number
- * @amf: AMF = 16-bit authentication management field
- * @mac_a: Buffer for MAC-A = 64-bit network authentication code, or %NULL
- * @mac_s: Buffer for MAC-S = 64-bit resync authentication code, or %NULL
- * Returns: 0 on success, -1 on failure
+ * Returns: Pointer to context data or %NULL on failure
+ *
+ * The AES key schedule for K is expanded once here and reused for all the
+ * Milenage functions computed with this context. The context can be kept
+ * for as long as K and OPc of the subscriber do not change and it needs to
+ * be freed with milenage_deinit().
  */
-int milenage_f1(const u8 *opc, const u8 *k, const u8 *_rand,
-		const u8 *sqn, const u8 *amf, u8 *mac_a, u8 *mac_s)
+struct milenage_ctx * milenage_init(const u8 *opc, const u8 *k)
 {
-	u8 tmp1[16], tmp2[16], tmp3[16];
+	struct milenage_ctx *ctx;
+
+	ctx = os_zalloc(sizeof(*ctx));
+	if (ctx == NULL)
+		return NULL;
+	ctx->aes = aes_encrypt_init(k, 16);
+	if (ctx->aes == NULL) {
+		os_free(ctx);
+		return NULL;
+	}
+	os_memcpy(ctx->opc, opc, 16);
+	return ctx;
+}
+
+
+/**
+ * milenage_deinit - Free Milenage context
+ * @ctx: Context data from milenage_init()
+ */
+void milenage_deinit(struct milenage_ctx *ctx)
+{
+	if (ctx == NULL)
+		return;
+	aes_encrypt_deinit(ctx->aes);
+	bin_clear_free(ctx, sizeof(*ctx));
+}
+
+
+/* TEMP = E_K(RAND XOR OP_C) */
+static void milenage_temp(struct milenage_ctx *ctx, const u8 *_rand, u8 *temp)
+{
+	u8 tmp[16];
 	int i;
 
-	/* tmp1 = TEMP = E_K(RAND XOR OP_C) */
 	for (i = 0; i < 16; i++)
-		tmp1[i] = _rand[i] ^ opc[i];
-	if (aes_128_encrypt_block(k, tmp1, tmp1))
-		return -1;
+		tmp[i] = _rand[i] ^ ctx->opc[i];
+	aes_encrypt(ctx->aes, tmp, temp);
+}
+
+
+static void milenage_out1(struct milenage_ctx *ctx, const u8 *temp,
+			  const u8 *sqn, const u8 *amf, u8 *mac_a, u8 *mac_s)
+{
+	const u8 *opc = ctx->opc;
+	u8 tmp1[16], tmp2[16], tmp3[16];
+	int i;
 
 	/* tmp2 = IN1 = SQN || AMF || SQN || AMF */
 	os_memcpy(tmp2, sqn, 6);
@@ -57,74 +100,55 @@ int milenage_f1(const u8 *opc, const u8 *k, const u8 *_rand,
 		tmp3[(i + 8) % 16] = tmp2[i] ^ opc[i];
 	/* XOR with TEMP = E_K(RAND XOR OP_C) */
 	for (i = 0; i < 16; i++)
-		tmp3[i] ^= tmp1[i];
+		tmp3[i] ^= temp[i];
 	/* XOR with c1 (= ..00, i.e., NOP) */
 
 	/* f1 || f1* = E_K(tmp3) XOR OP_c */
-	if (aes_128_encrypt_block(k, tmp3, tmp1))
-		return -1;
+	aes_encrypt(ctx->aes, tmp3, tmp1);
 	for (i = 0; i < 16; i++)
 		tmp1[i] ^= opc[i];
 	if (mac_a)
 		os_memcpy(mac_a, tmp1, 8); /* f1 */
 	if (mac_s)
 		os_memcpy(mac_s, tmp1 + 8, 8); /* f1* */
-	return 0;
 }
 
 
-/**
- * milenage_f2345 - Milenage f2, f3, f4, f5, f5* algorithms
- * @opc: OPc = 128-bit value derived from OP and K
- * @k: K = 128-bit subscriber key
- * @_rand: RAND = 128-bit random challenge
- * @res: Buffer for RES = 64-bit signed response (f2), or %NULL
- * @ck: Buffer for CK = 128-bit confidentiality key (f3), or %NULL
- * @ik: Buffer for IK = 128-bit integrity key (f4), or %NULL
- * @ak: Buffer for AK = 48-bit anonymity key (f5), or %NULL
- * @akstar: Buffer for AK = 48-bit anonymity key (f5*), or %NULL
- * Returns: 0 on success, -1 on failure
- */
-int milenage_f2345(const u8 *opc, const u8 *k, const u8 *_rand,
-		   u8 *res, u8 *ck, u8 *ik, u8 *ak, u8 *akstar)
+static void milenage_out2345(struct milenage_ctx *ctx, const u8 *temp,
+			     u8 *res, u8 *ck, u8 *ik, u8 *ak, u8 *akstar)
 {
-	u8 tmp1[16], tmp2[16], tmp3[16];
+	const u8 *opc = ctx->opc;
+	u8 tmp1[16], tmp3[16];
 	int i;
 
-	/* tmp2 = TEMP = E_K(RAND XOR OP_C) */
-	for (i = 0; i < 16; i++)
-		tmp1[i] = _rand[i] ^ opc[i];
-	if (aes_128_encrypt_block(k, tmp1, tmp2))
-		return -1;
-
 	/* OUT2 = E_K(rot(TEMP XOR OP_C, r2) XOR c2) XOR OP_C */
 	/* OUT3 = E_K(rot(TEMP XOR OP_C, r3) XOR c3) XOR OP_C */
 	/* OUT4 = E_K(rot(TEMP XOR OP_C, r4) XOR c4) XOR OP_C */
 	/* OUT5 = E_K(rot(TEMP XOR OP_C, r5) XOR c5) XOR OP_C */
 
 	/* f2 and f5 */
-	/* rotate by r2 (= 0, i.e., NOP) */
-	for (i = 0; i < 16; i++)
-		tmp1[i] = tmp2[i] ^ opc[i];
-	tmp1[15] ^= 1; /* XOR c2 (= ..01) */
-	/* f5 || f2 = E_K(tmp1) XOR OP_c */
-	if (aes_128_encrypt_block(k, tmp1, tmp3))
-		return -1;
-	for (i = 0; i < 16; i++)
-		tmp3[i] ^= opc[i];
-	if (res)
-		os_memcpy(res, tmp3 + 8, 8); /* f2 */
-	if (ak)
-		os_memcpy(ak, tmp3, 6); /* f5 */
+	if (res || ak) {
+		/* rotate by r2 (= 0, i.e., NOP) */
+		for (i = 0; i < 16; i++)
+			tmp1[i] = temp[i] ^ opc[i];
+		tmp1[15] ^= 1; /* XOR c2 (= ..01) */
+		/* f5 || f2 = E_K(tmp1) XOR OP_c */
+		aes_encrypt(ctx->aes, tmp1, tmp3);
+		for (i = 0; i < 16; i++)
+			tmp3[i] ^= opc[i];
+		if (res)
+			os_memcpy(res, tmp3 + 8, 8); /* f2 */
+		if (ak)
+			os_memcpy(ak, tmp3, 6); /* f5 */
+	}
 
 	/* f3 */
 	if (ck) {
 		/* rotate by r3 = 0x20 = 4 bytes */
 		for (i = 0; i < 16; i++)
-			tmp1[(i + 12) % 16] = tmp2[i] ^ opc[i];
+			tmp1[(i + 12) % 16] = temp[i] ^ opc[i];
 		tmp1[15] ^= 2; /* XOR c3 (= ..02) */
-		if (aes_128_encrypt_block(k, tmp1, ck))
-			return -1;
+		aes_encrypt(ctx->aes, tmp1, ck);
 		for (i = 0; i < 16; i++)
 			ck[i] ^= opc[i];
 	}
@@ -133,10 +157,9 @@ int milenage_f2345(const u8 *opc, const u8 *k, const u8 *_rand,
 	if (ik) {
 		/* rotate by r4 = 0x40 = 8 bytes */
 		for (i = 0; i < 16; i++)
-			tmp1[(i + 8) % 16] = tmp2[i] ^ opc[i];
+			tmp1[(i + 8) % 16] = temp[i] ^ opc[i];
 		tmp1[15] ^= 4; /* XOR c4 (= ..04) */
-		if (aes_128_encrypt_block(k, tmp1, ik))
-			return -1;
+		aes_encrypt(ctx->aes, tmp1, ik);
 		for (i = 0; i < 16; i++)
 			ik[i] ^= opc[i];
 	}
@@ -145,18 +168,117 @@ int milenage_f2345(const u8 *opc, const u8 *k, const u8 *_rand,
 	if (akstar) {
 		/* rotate by r5 = 0x60 = 12 bytes */
 		for (i = 0; i < 16; i++)
-			tmp1[(i + 4) % 16] = tmp2[i] ^ opc[i];
+			tmp1[(i + 4) % 16] = temp[i] ^ opc[i];
 		tmp1[15] ^= 8; /* XOR c5 (= ..08) */
-		if (aes_128_encrypt_block(k, tmp1, tmp1))
-			return -1;
+		aes_encrypt(ctx->aes, tmp1, tmp1);
 		for (i = 0; i < 6; i++)
 			akstar[i] = tmp1[i] ^ opc[i];
 	}
+}
+
+
+/**
+ * milenage_f1 - Milenage f1 and f1* algorithms
+ * @opc: OPc = 128-bit value derived from OP and K
+ * @k: K = 128-bit subscriber key
+ * @_rand: RAND = 128-bit random challenge
+ * @sqn: SQN = 48-bit sequence number
+ * @amf: AMF = 16-bit authentication management field
+ * @mac_a: Buffer for MAC-A = 64-bit network authentication code, or %NULL
+ * @mac_s: Buffer for MAC-S = 64-bit resync authentication code, or %NULL
+ * Returns: 0 on success, -1 on failure
+ */
+int milenage_f1(const u8 *opc, const u8 *k, const u8 *_rand,
+		const u8 *sqn, const u8 *amf, u8 *mac_a, u8 *mac_s)
+{
+	struct milenage_ctx *ctx;
+	u8 temp[16];
+
+	ctx = milenage_init(opc, k);
+	if (ctx == NULL)
+		return -1;
+	milenage_temp(ctx, _rand, temp);
+	milenage_out1(ctx, temp, sqn, amf, mac_a, mac_s);
+	milenage_deinit(ctx);
+	return 0;
+}
+
+
+/**
+ * milenage_f2345 - Milenage f2, f3, f4, f5, f5* algorithms
+ * @opc: OPc = 128-bit value derived from OP and K
+ * @k: K = 128-bit subscriber key
+ * @_rand: RAND = 128-bit random challenge
+ * @res: Buffer for RES = 64-bit signed response (f2), or %NULL
+ * @ck: Buffer for CK = 128-bit confidentiality key (f3), or %NULL
+ * @ik: Buffer for IK = 128-bit integrity key (f4), or %NULL
+ * @ak: Buffer for AK = 48-bit anonymity key (f5), or %NULL
+ * @akstar: Buffer for AK = 48-bit anonymity key (f5*), or %NULL
+ * Returns: 0 on success, -1 on failure
+ */
+int milenage_f2345(const u8 *opc, const u8 *k, const u8 *_rand,
+		   u8 *res, u8 *ck, u8 *ik, u8 *ak, u8 *akstar)
+{
+	struct milenage_ctx *ctx;
+	u8 temp[16];
 
+	ctx = milenage_init(opc, k);
+	if (ctx == NULL)
+		return -1;
+	milenage_temp(ctx, _rand, temp);
+	milenage_out2345(ctx, temp, res, ck, ik, ak, akstar);
+	milenage_deinit(ctx);
 	return 0;
 }
 
 
+/**
+ * milenage_generate_bulk - Generate a set of AKA authentication vectors
+ * @ctx: Context data from milenage_init()
+ * @amf: AMF = 16-bit authentication management field
+ * @sqn: SQN = 48-bit sequence numbers (num * 6 octets)
+ * @_rand: RAND = 128-bit random challenges (num * 16 octets)
+ * @num: Number of vectors to generate
+ * @autn: Buffer for AUTN = 128-bit authentication tokens (num * 16 octets)
+ * @ik: Buffer for IK = 128-bit integrity keys (num * 16 octets), or %NULL
+ * @ck: Buffer for CK = 128-bit confidentiality keys (num * 16 octets), or
+ * %NULL
+ * @res: Buffer for RES = 64-bit signed responses (num * 8 octets), or %NULL
+ *
+ * Vector i is generated from sqn[i * 6] and _rand[i * 16] and the results are
+ * stored at the matching offsets of the output buffers.
+ */
+void milenage_generate_bulk(struct milenage_ctx *ctx, const u8 *amf,
+			    const u8 *sqn, const u8 *_rand, size_t num,
+			    u8 *autn, u8 *ik, u8 *ck, u8 *res)
+{
+	size_t n;
+	int i;
+	u8 temp[16], ak[6];
+
+	for (n = 0; n < num; n++) {
+		milenage_temp(ctx, _rand, temp);
+		milenage_out2345(ctx, temp, res, ck, ik, ak, NULL);
+
+		/* AUTN = (SQN ^ AK) || AMF || MAC */
+		for (i = 0; i < 6; i++)
+			autn[i] = sqn[i] ^ ak[i];
+		os_memcpy(autn + 6, amf, 2);
+		milenage_out1(ctx, temp, sqn, amf, autn + 8, NULL);
+
+		sqn += 6;
+		_rand += 16;
+		autn += 16;
+		if (ik)
+			ik += 16;
+		if (ck)
+			ck += 16;
+		if (res)
+			res += 8;
+	}
+}
+
+
 /**
  * milenage_generate - Generate AKA AUTN,IK,CK,RES
  * @opc: OPc = 128-bit operator variant algorithm configuration field (encr.)
@@ -174,25 +296,20 @@ void milenage_generate(const u8 *opc, const u8 *amf, const u8 *k,
 		       const u8 *sqn, const u8 *_rand, u8 *autn, u8 *ik,
 		       u8 *ck, u8 *res, size_t *res_len)
 {
-	int i;
-	u8 mac_a[8], ak[6];
+	struct milenage_ctx *ctx;
 
 	if (*res_len < 8) {
 		*res_len = 0;
 		return;
 	}
-	if (milenage_f1(opc, k, _rand, sqn, amf, mac_a, NULL) ||
-	    milenage_f2345(opc, k, _rand, res, ck, ik, ak, NULL)) {
+	ctx = milenage_init(opc, k);
+	if (ctx == NULL) {
 		*res_len = 0;
 		return;
 	}
+	milenage_generate_bulk(ctx, amf, sqn, _rand, 1, autn, ik, ck, res);
+	milenage_deinit(ctx);
 	*res_len = 8;
-
-	/* AUTN = (SQN ^ AK) || AMF || MAC */
-	for (i = 0; i < 6; i++)
-		autn[i] = sqn[i] ^ ak[i];
-	os_memcpy(autn + 6, amf, 2);
-	os_memcpy(autn + 8, mac_a, 8);
 }
 
 
@@ -209,20 +326,61 @@ int milenage_auts(const u8 *opc, const u8 *k, const u8 *_rand, const u8 *auts,
 		  u8 *sqn)
 {
 	u8 amf[2] = { 0x00, 0x00 }; /* TS 33.102 v7.0.0, 6.3.3 */
-	u8 ak[6], mac_s[8];
+	u8 temp[16], ak[6], mac_s[8];
+	struct milenage_ctx *ctx;
 	int i;
 
-	if (milenage_f2345(opc, k, _rand, NULL, NULL, NULL, NULL, ak))
+	ctx = milenage_init(opc, k);
+	if (ctx == NULL)
 		return -1;
+	milenage_temp(ctx, _rand, temp);
+	milenage_out2345(ctx, temp, NULL, NULL, NULL, NULL, ak);
 	for (i = 0; i < 6; i++)
 		sqn[i] = auts[i] ^ ak[i];
-	if (milenage_f1(opc, k, _rand, sqn, amf, NULL, mac_s) ||
-	    os_memcmp_const(mac_s, auts + 6, 8) != 0)
+	milenage_out1(ctx, temp, sqn, amf, NULL, mac_s);
+	milenage_deinit(ctx);
+	if (os_memcmp_const(mac_s, auts + 6, 8) != 0)
 		return -1;
 	return 0;
 }
 
 
+/**
+ * gsm_milenage_bulk - Generate a set of GSM-Milenage authentication triplets
+ * @ctx: Context data from milenage_init()
+ * @_rand: RAND = 128-bit random challenges (num * 16 octets)
+ * @num: Number of triplets to generate
+ * @sres: Buffer for SRES = 32-bit SRES values (num * 4 octets)
+ * @kc: Buffer for Kc = 64-bit Kc values (num * 8 octets)
+ */
+void gsm_milenage_bulk(struct milenage_ctx *ctx, const u8 *_rand, size_t num,
+		       u8 *sres, u8 *kc)
+{
+	u8 temp[16], res[8], ck[16], ik[16];
+	size_t n;
+	int i;
+
+	for (n = 0; n < num; n++) {
+		milenage_temp(ctx, _rand, temp);
+		milenage_out2345(ctx, temp, res, ck, ik, NULL, NULL);
+
+		for (i = 0; i < 8; i++)
+			kc[i] = ck[i] ^ ck[i + 8] ^ ik[i] ^ ik[i + 8];
+
+#ifdef GSM_MILENAGE_ALT_SRES
+		os_memcpy(sres, res, 4);
+#else /* GSM_MILENAGE_ALT_SRES */
+		for (i = 0; i < 4; i++)
+			sres[i] = res[i] ^ res[i + 4];
+#endif /* GSM_MILENAGE_ALT_SRES */
+
+		_rand += 16;
+		sres += 4;
+		kc += 8;
+	}
+}
+
+
 /**
  * gsm_milenage - Generate GSM-Milenage (3GPP TS 55.205) authentication triplet
  * @opc: OPc = 128-bit operator variant algorithm configuration field (encr.)
@@ -234,21 +392,13 @@ int milenage_auts(const u8 *opc, const u8 *k, const u8 *_rand, const u8 *auts,
  */
 int gsm_milenage(const u8 *opc, const u8 *k, const u8 *_rand, u8 *sres, u8 *kc)
 {
-	u8 res[8], ck[16], ik[16];
-	int i;
+	struct milenage_ctx *ctx;
 
-	if (milenage_f2345(opc, k, _rand, res, ck, ik, NULL, NULL))
+	ctx = milenage_init(opc, k);
+	if (ctx == NULL)
 		return -1;
-
-	for (i = 0; i < 8; i++)
-		kc[i] = ck[i] ^ ck[i + 8] ^ ik[i] ^ ik[i + 8];
-
-#ifdef GSM_MILENAGE_ALT_SRES
-	os_memcpy(sres, res, 4);
-#else /* GSM_MILENAGE_ALT_SRES */
-	for (i = 0; i < 4; i++)
-		sres[i] = res[i] ^ res[i + 4];
-#endif /* GSM_MILENAGE_ALT_SRES */
+	gsm_milenage_bulk(ctx, _rand, 1, sres, kc);
+	milenage_deinit(ctx);
 	return 0;
 }
 
@@ -272,14 +422,18 @@ int milenage_check(const u8 *opc, const u8 *k, const u8 *sqn, const u8 *_rand,
 		   u8 *auts)
 {
 	int i;
-	u8 mac_a[8], ak[6], rx_sqn[6];
+	u8 temp[16], mac_a[8], ak[6], rx_sqn[6];
 	const u8 *amf;
+	struct milenage_ctx *ctx;
 
 	wpa_hexdump(MSG_DEBUG, "Milenage: AUTN", autn, 16);
 	wpa_hexdump(MSG_DEBUG, "Milenage: RAND", _rand, 16);
 
-	if (milenage_f2345(opc, k, _rand, res, ck, ik, ak, NULL))
+	ctx = milenage_init(opc, k);
+	if (ctx == NULL)
 		return -1;
+	milenage_temp(ctx, _rand, temp);
+	milenage_out2345(ctx, temp, res, ck, ik, ak, NULL);
 
 	*res_len = 8;
 	wpa_hexdump_key(MSG_DEBUG, "Milenage: RES", res, *res_len);
@@ -294,21 +448,20 @@ int milenage_check(const u8 *opc, const u8 *k, const u8 *sqn, const u8 *_rand,
 
 	if (os_memcmp(rx_sqn, sqn, 6) <= 0) {
 		u8 auts_amf[2] = { 0x00, 0x00 }; /* TS 33.102 v7.0.0, 6.3.3 */
-		if (milenage_f2345(opc, k, _rand, NULL, NULL, NULL, NULL, ak))
-			return -1;
+		milenage_out2345(ctx, temp, NULL, NULL, NULL, NULL, ak);
 		wpa_hexdump_key(MSG_DEBUG, "Milenage: AK*", ak, 6);
 		for (i = 0; i < 6; i++)
 			auts[i] = sqn[i] ^ ak[i];
-		if (milenage_f1(opc, k, _rand, sqn, auts_amf, NULL, auts + 6))
-			return -1;
+		milenage_out1(ctx, temp, sqn, auts_amf, NULL, auts + 6);
+		milenage_deinit(ctx);
 		wpa_hexdump(MSG_DEBUG, "Milenage: AUTS", auts, 14);
 		return -2;
 	}
 
 	amf = autn + 6;
 	wpa_hexdump(MSG_DEBUG, "Milenage: AMF", amf, 2);
-	if (milenage_f1(opc, k, _rand, rx_sqn, amf, mac_a, NULL))
-		return -1;
+	milenage_out1(ctx, temp, rx_sqn, amf, mac_a, NULL);
+	milenage_deinit(ctx);
 
 	wpa_hexdump(MSG_DEBUG, "Milenage: MAC_A", mac_a, 8);
 
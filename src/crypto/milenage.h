@@ -9,6 +9,8 @@
 #ifndef MILENAGE_H
 #define MILENAGE_H
 
+struct milenage_ctx;
+
 void milenage_generate(const u8 *opc, const u8 *amf, const u8 *k,
 		       const u8 *sqn, const u8 *_rand, u8 *autn, u8 *ik,
 		       u8 *ck, u8 *res, size_t *res_len);
@@ -24,4 +26,12 @@ int milenage_f1(const u8 *opc, const u8 *k, const u8 *_rand,
 int milenage_f2345(const u8 *opc, const u8 *k, const u8 *_rand,
 		   u8 *res, u8 *ck, u8 *ik, u8 *ak, u8 *akstar);
 
+struct milenage_ctx * milenage_init(const u8 *opc, const u8 *k);
+void milenage_deinit(struct milenage_ctx *ctx);
+void milenage_generate_bulk(struct milenage_ctx *ctx, const u8 *amf,
+			    const u8 *sqn, const u8 *_rand, size_t num,
+			    u8 *autn, u8 *ik, u8 *ck, u8 *res);
+void gsm_milenage_bulk(struct milenage_ctx *ctx, const u8 *_rand, size_t num,
+		       u8 *sres, u8 *kc);
+
 #endif /* MILENAGE_H */
@@ -307,6 +307,32 @@ int __must_check tls_global_set_params(
  */
 int __must_check tls_global_set_verify(void *tls_ctx, int check_crl);
 
+/**
+ * tls_global_get_ocsp_request - Build OCSP request for the server certificate
+ * @tls_ctx: TLS context data from tls_init()
+ * Returns: DER encoded OCSPRequest or %NULL on failure
+ *
+ * This can be used after tls_global_set_params() to fetch a response for OCSP
+ * stapling from an OCSP responder.
+ */
+struct wpabuf * tls_global_get_ocsp_request(void *tls_ctx);
+
+/**
+ * tls_global_set_ocsp_response - Set OCSP stapling response
+ * @tls_ctx: TLS context data from tls_init()
+ * @resp: DER encoded OCSPResponse
+ * @valid_time: Buffer for returning the number of seconds the response remains
+ * valid or 0 if the response does not include nextUpdate
+ * Returns: 0 on success, -1 on failure
+ *
+ * The response is verified to be a currently valid response for the server
+ * certificate and it is kept in memory and used for OCSP stapling instead of
+ * the ocsp_stapling_response file until it expires.
+ */
+int __must_check tls_global_set_ocsp_response(void *tls_ctx,
+					      const struct wpabuf *resp,
+					      unsigned int *valid_time);
+
 /**
  * tls_connection_set_verify - Set certificate verification options
  * @tls_ctx: TLS context data from tls_init()
@@ -771,6 +771,19 @@ int tls_global_set_verify(void *ssl_ctx, int check_crl)
 }
 
 
+struct wpabuf * tls_global_get_ocsp_request(void *ssl_ctx)
+{
+	return NULL;
+}
+
+
+int tls_global_set_ocsp_response(void *ssl_ctx, const struct wpabuf *resp,
+				 unsigned int *valid_time)
+{
+	return -1;
+}
+
+
 int tls_connection_set_verify(void *ssl_ctx, struct tls_connection *conn,
 			      int verify_peer, unsigned int flags,
 			      const u8 *session_ctx, size_t session_ctx_len)
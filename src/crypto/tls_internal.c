@@ -353,6 +353,19 @@ int tls_global_set_verify(void *tls_ctx, int check_crl)
 }
 
 
+struct wpabuf * tls_global_get_ocsp_request(void *tls_ctx)
+{
+	return NULL;
+}
+
+
+int tls_global_set_ocsp_response(void *tls_ctx, const struct wpabuf *resp,
+				 unsigned int *valid_time)
+{
+	return -1;
+}
+
+
 int tls_connection_set_verify(void *tls_ctx, struct tls_connection *conn,
 			      int verify_peer, unsigned int flags,
 			      const u8 *session_ctx, size_t session_ctx_len)
@@ -611,7 +624,8 @@ struct wpabuf * tls_connection_decrypt2(void *tls_ctx,
 	if (conn->server) {
 		struct wpabuf *buf;
 		int res;
-		buf = wpabuf_alloc((wpabuf_len(in_data) + 500) * 3);
+		/* Decrypted data is never longer than the received records */
+		buf = wpabuf_alloc(wpabuf_len(in_data));
 		if (buf == NULL)
 			return NULL;
 		res = tlsv1_server_decrypt(conn->server, wpabuf_head(in_data),
@@ -7,6 +7,9 @@
  */
 
 #include "includes.h"
+#ifndef OPENSSL_NO_STDIO
+#include <sys/stat.h>
+#endif /* OPENSSL_NO_STDIO */
 
 #ifndef CONFIG_SMARTCARD
 #ifndef OPENSSL_NO_ENGINE
@@ -32,6 +35,7 @@
 #endif
 
 #include "common.h"
+#include "utils/list.h"
 #include "crypto.h"
 #include "sha1.h"
 #include "sha256.h"
@@ -192,10 +196,17 @@ struct tls_context {
 
 static struct tls_context *tls_global = NULL;
 
+static void tls_ca_cache_flush(void);
+#ifdef HAVE_OCSP
+static void tls_ocsp_cache_flush(void);
+#endif /* HAVE_OCSP */
+
 
 struct tls_data {
 	SSL_CTX *ssl;
 	unsigned int tls_session_lifetime;
+	struct wpabuf *ocsp_resp; /* OCSP stapling response in memory */
+	os_time_t ocsp_resp_expire; /* 0 if no nextUpdate in ocsp_resp */
 };
 
 struct tls_connection {
@@ -1052,12 +1063,17 @@ void tls_deinit(void *ssl_ctx)
 		ERR_free_strings();
 		EVP_cleanup();
 #endif /* < 1.1.0 */
+		tls_ca_cache_flush();
+#ifdef HAVE_OCSP
+		tls_ocsp_cache_flush();
+#endif /* HAVE_OCSP */
 		os_free(tls_global->ocsp_stapling_response);
 		tls_global->ocsp_stapling_response = NULL;
 		os_free(tls_global);
 		tls_global = NULL;
 	}
 
+	wpabuf_free(data->ocsp_resp);
 	os_free(data);
 }
 
@@ -1983,23 +1999,246 @@ static int tls_load_ca_der(struct tls_data *data, const char *ca_cert)
 #endif /* OPENSSL_NO_STDIO */
 
 
+/*
+ * Trusted CA certificates (and any CRLs included in the same files) are loaded
+ * into an X509_STORE that is shared by all connections in the process that use
+ * the same ca_cert/ca_path or ca_cert_blob. File based entries are reloaded
+ * when the modification time of the file or directory changes or when the
+ * earliest nextUpdate of a loaded CRL has been reached.
+ */
+
+#define TLS_CA_CACHE_MAX 16
+#define TLS_CA_CACHE_MIN_CRL_RELOAD 60
+
+struct tls_ca_cache_entry {
+	struct dl_list list;
+	X509_STORE *store;
+	char *ca_cert;
+	char *ca_path;
+	u8 *blob;
+	size_t blob_len;
+	os_time_t ca_cert_mtime;
+	os_time_t ca_path_mtime;
+	os_time_t crl_next_update; /* 0 if no CRLs were loaded */
+};
+
+static struct dl_list tls_ca_cache = DL_LIST_HEAD_INIT(tls_ca_cache);
+
+
+static void tls_x509_store_up_ref(X509_STORE *store)
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L || defined(LIBRESSL_VERSION_NUMBER)
+	CRYPTO_add(&store->references, 1, CRYPTO_LOCK_X509_STORE);
+#else /* < 1.1.0 */
+	X509_STORE_up_ref(store);
+#endif /* < 1.1.0 */
+}
+
+
+static int tls_ca_cache_mtime(const char *fname, os_time_t *mtime)
+{
+#ifndef OPENSSL_NO_STDIO
+	struct stat st;
+
+	if (!fname) {
+		*mtime = 0;
+		return 0;
+	}
+	if (stat(fname, &st) < 0)
+		return -1;
+	*mtime = st.st_mtime;
+	return 0;
+#else /* OPENSSL_NO_STDIO */
+	return -1;
+#endif /* OPENSSL_NO_STDIO */
+}
+
+
+static os_time_t tls_ca_cache_crl_next_update(X509_STORE *store)
+{
+	os_time_t next = 0;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(LIBRESSL_VERSION_NUMBER)
+	STACK_OF(X509_OBJECT) *objs;
+	struct os_time now;
+	int i, day, sec;
+
+	os_get_time(&now);
+	objs = X509_STORE_get0_objects(store);
+	for (i = 0; i < sk_X509_OBJECT_num(objs); i++) {
+		X509_OBJECT *obj = sk_X509_OBJECT_value(objs, i);
+		const ASN1_TIME *next_update;
+		os_time_t t;
+
+		if (X509_OBJECT_get_type(obj) != X509_LU_CRL)
+			continue;
+		next_update = X509_CRL_get0_nextUpdate(
+			X509_OBJECT_get0_X509_CRL(obj));
+		if (!next_update ||
+		    !ASN1_TIME_diff(&day, &sec, NULL, next_update))
+			continue;
+		t = now.sec + (os_time_t) day * 24 * 60 * 60 + sec;
+		/* Do not reload on every connection if a CRL has expired */
+		if (t < now.sec + TLS_CA_CACHE_MIN_CRL_RELOAD)
+			t = now.sec + TLS_CA_CACHE_MIN_CRL_RELOAD;
+		if (!next || t < next)
+			next = t;
+	}
+#endif /* >= 1.1.0 */
+	return next;
+}
+
+
+static void tls_ca_cache_entry_free(struct tls_ca_cache_entry *entry)
+{
+	dl_list_del(&entry->list);
+	X509_STORE_free(entry->store);
+	os_free(entry->ca_cert);
+	os_free(entry->ca_path);
+	os_free(entry->blob);
+	os_free(entry);
+}
+
+
+static void tls_ca_cache_flush(void)
+{
+	struct tls_ca_cache_entry *entry, *tmp;
+
+	dl_list_for_each_safe(entry, tmp, &tls_ca_cache,
+			      struct tls_ca_cache_entry, list)
+		tls_ca_cache_entry_free(entry);
+}
+
+
+static int tls_ca_cache_str_eq(const char *a, const char *b)
+{
+	if (!a || !b)
+		return a == b;
+	return os_strcmp(a, b) == 0;
+}
+
+
+/* Returns a new reference to a cached store or %NULL if not cached */
+static X509_STORE * tls_ca_cache_get(const char *ca_cert, const char *ca_path,
+				     const u8 *blob, size_t blob_len)
+{
+	struct tls_ca_cache_entry *entry;
+	os_time_t ca_cert_mtime, ca_path_mtime;
+	struct os_time now;
+
+	dl_list_for_each(entry, &tls_ca_cache, struct tls_ca_cache_entry,
+			 list) {
+		if (!tls_ca_cache_str_eq(entry->ca_cert, ca_cert) ||
+		    !tls_ca_cache_str_eq(entry->ca_path, ca_path) ||
+		    entry->blob_len != blob_len ||
+		    (blob && os_memcmp(entry->blob, blob, blob_len) != 0))
+			continue;
+
+		os_get_time(&now);
+		if (!blob &&
+		    (tls_ca_cache_mtime(ca_cert, &ca_cert_mtime) < 0 ||
+		     tls_ca_cache_mtime(ca_path, &ca_path_mtime) < 0 ||
+		     ca_cert_mtime != entry->ca_cert_mtime ||
+		     ca_path_mtime != entry->ca_path_mtime)) {
+			wpa_printf(MSG_DEBUG,
+				   "OpenSSL: CA certificate file changed - reload");
+			tls_ca_cache_entry_free(entry);
+			return NULL;
+		}
+		if (entry->crl_next_update && now.sec >= entry->crl_next_update)
+		{
+			wpa_printf(MSG_DEBUG,
+				   "OpenSSL: CRL nextUpdate reached - reload");
+			tls_ca_cache_entry_free(entry);
+			return NULL;
+		}
+
+		/* Keep the most recently used entries at the head */
+		dl_list_del(&entry->list);
+		dl_list_add(&tls_ca_cache, &entry->list);
+		tls_x509_store_up_ref(entry->store);
+		return entry->store;
+	}
+
+	return NULL;
+}
+
+
+static void tls_ca_cache_add(X509_STORE *store, const char *ca_cert,
+			     const char *ca_path, const u8 *blob,
+			     size_t blob_len)
+{
+	struct tls_ca_cache_entry *entry;
+
+	entry = os_zalloc(sizeof(*entry));
+	if (!entry)
+		return;
+	if (!blob &&
+	    (tls_ca_cache_mtime(ca_cert, &entry->ca_cert_mtime) < 0 ||
+	     tls_ca_cache_mtime(ca_path, &entry->ca_path_mtime) < 0)) {
+		os_free(entry);
+		return;
+	}
+	if (ca_cert)
+		entry->ca_cert = os_strdup(ca_cert);
+	if (ca_path)
+		entry->ca_path = os_strdup(ca_path);
+	if (blob) {
+		entry->blob = os_malloc(blob_len);
+		if (entry->blob) {
+			os_memcpy(entry->blob, blob, blob_len);
+			entry->blob_len = blob_len;
+		}
+	}
+	if ((ca_cert && !entry->ca_cert) || (ca_path && !entry->ca_path) ||
+	    (blob && !entry->blob)) {
+		os_free(entry->ca_cert);
+		os_free(entry->ca_path);
+		os_free(entry->blob);
+		os_free(entry);
+		return;
+	}
+	entry->crl_next_update = tls_ca_cache_crl_next_update(store);
+
+	if (dl_list_len(&tls_ca_cache) >= TLS_CA_CACHE_MAX)
+		tls_ca_cache_entry_free(dl_list_last(&tls_ca_cache,
+						     struct tls_ca_cache_entry,
+						     list));
+
+	tls_x509_store_up_ref(store);
+	entry->store = store;
+	dl_list_add(&tls_ca_cache, &entry->list);
+}
+
+
 static int tls_connection_ca_cert(struct tls_data *data,
 				  struct tls_connection *conn,
 				  const char *ca_cert, const u8 *ca_cert_blob,
 				  size_t ca_cert_blob_len, const char *ca_path)
 {
 	SSL_CTX *ssl_ctx = data->ssl;
-	X509_STORE *store;
+	X509_STORE *store = NULL;
+	int cached = 0;
 
-	/*
-	 * Remove previously configured trusted CA certificates before adding
-	 * new ones.
-	 */
-	store = X509_STORE_new();
-	if (store == NULL) {
-		wpa_printf(MSG_DEBUG, "OpenSSL: %s - failed to allocate new "
-			   "certificate store", __func__);
-		return -1;
+	if (ca_cert_blob)
+		store = tls_ca_cache_get(NULL, NULL, ca_cert_blob,
+					 ca_cert_blob_len);
+#ifndef OPENSSL_NO_STDIO
+	else if (ca_cert || ca_path)
+		store = tls_ca_cache_get(ca_cert, ca_path, NULL, 0);
+#endif /* OPENSSL_NO_STDIO */
+	if (store) {
+		cached = 1;
+	} else {
+		/*
+		 * Remove previously configured trusted CA certificates before
+		 * adding new ones.
+		 */
+		store = X509_STORE_new();
+		if (store == NULL) {
+			wpa_printf(MSG_DEBUG, "OpenSSL: %s - failed to "
+				   "allocate new certificate store", __func__);
+			return -1;
+		}
 	}
 	SSL_CTX_set_cert_store(ssl_ctx, store);
 
@@ -2045,9 +2284,17 @@ static int tls_connection_ca_cert(struct tls_data *data,
 	}
 
 	if (ca_cert_blob) {
-		X509 *cert = d2i_X509(NULL,
-				      (const unsigned char **) &ca_cert_blob,
-				      ca_cert_blob_len);
+		const u8 *blob = ca_cert_blob;
+		X509 *cert;
+
+		if (cached) {
+			wpa_printf(MSG_DEBUG, "OpenSSL: %s - using cached "
+				   "ca_cert_blob certificate store", __func__);
+			return 0;
+		}
+
+		cert = d2i_X509(NULL, (const unsigned char **) &ca_cert_blob,
+				ca_cert_blob_len);
 		if (cert == NULL) {
 			tls_show_errors(MSG_WARNING, __func__,
 					"Failed to parse ca_cert_blob");
@@ -2074,6 +2321,8 @@ static int tls_connection_ca_cert(struct tls_data *data,
 		X509_free(cert);
 		wpa_printf(MSG_DEBUG, "OpenSSL: %s - added ca_cert_blob "
 			   "to certificate store", __func__);
+		tls_ca_cache_add(SSL_CTX_get_cert_store(ssl_ctx), NULL, NULL,
+				 blob, ca_cert_blob_len);
 		return 0;
 	}
 
@@ -2128,6 +2377,12 @@ static int tls_connection_ca_cert(struct tls_data *data,
 
 	if (ca_cert || ca_path) {
 #ifndef OPENSSL_NO_STDIO
+		if (cached) {
+			wpa_printf(MSG_DEBUG, "TLS: Using cached trusted root "
+				   "certificate(s)");
+			return 0;
+		}
+
 		if (SSL_CTX_load_verify_locations(ssl_ctx, ca_cert, ca_path) !=
 		    1) {
 			tls_show_errors(MSG_WARNING, __func__,
@@ -2144,6 +2399,8 @@ static int tls_connection_ca_cert(struct tls_data *data,
 				   "certificate(s) loaded");
 			tls_get_errors(data);
 		}
+		tls_ca_cache_add(SSL_CTX_get_cert_store(ssl_ctx), ca_cert,
+				 ca_path, NULL, 0);
 #else /* OPENSSL_NO_STDIO */
 		wpa_printf(MSG_DEBUG, "OpenSSL: %s - OPENSSL_NO_STDIO",
 			   __func__);
@@ -3743,6 +4000,142 @@ static void debug_print_cert(X509 *cert, const char *title)
 }
 
 
+/*
+ * Verified OCSP responses from servers are cached based on the certificate
+ * identifier (issuer and serial number) and a hash of the response, so that
+ * the signature of a response that a server staples again does not need to be
+ * verified on each connection. Entries are used until the nextUpdate time of
+ * the response.
+ */
+
+#define TLS_OCSP_CACHE_MAX 16
+
+struct tls_ocsp_cache_entry {
+	struct dl_list list;
+	u8 key[SHA256_MAC_LEN];
+	int status;
+	os_time_t expire;
+};
+
+static struct dl_list tls_ocsp_cache = DL_LIST_HEAD_INIT(tls_ocsp_cache);
+
+
+static void tls_ocsp_cache_entry_free(struct tls_ocsp_cache_entry *entry)
+{
+	dl_list_del(&entry->list);
+	os_free(entry);
+}
+
+
+static void tls_ocsp_cache_flush(void)
+{
+	struct tls_ocsp_cache_entry *entry, *tmp;
+
+	dl_list_for_each_safe(entry, tmp, &tls_ocsp_cache,
+			      struct tls_ocsp_cache_entry, list)
+		tls_ocsp_cache_entry_free(entry);
+}
+
+
+static int tls_ocsp_cache_key(X509 *cert, X509 *issuer, const u8 *resp,
+			      size_t resp_len, u8 *key)
+{
+	OCSP_CERTID *id;
+	unsigned char *der = NULL;
+	const u8 *addr[2];
+	size_t len[2];
+	int der_len, res;
+
+	id = OCSP_cert_to_id(NULL, cert, issuer);
+	if (!id)
+		return -1;
+	der_len = i2d_OCSP_CERTID(id, &der);
+	OCSP_CERTID_free(id);
+	if (der_len <= 0)
+		return -1;
+
+	addr[0] = der;
+	len[0] = der_len;
+	addr[1] = resp;
+	len[1] = resp_len;
+	res = sha256_vector(2, addr, len, key);
+	OPENSSL_free(der);
+	return res;
+}
+
+
+/* Returns cached V_OCSP_CERTSTATUS_* value or -1 if not cached */
+static int tls_ocsp_cache_get(const u8 *key)
+{
+	struct tls_ocsp_cache_entry *entry;
+	struct os_time now;
+
+	os_get_time(&now);
+	dl_list_for_each(entry, &tls_ocsp_cache, struct tls_ocsp_cache_entry,
+			 list) {
+		if (os_memcmp(entry->key, key, SHA256_MAC_LEN) != 0)
+			continue;
+		if (now.sec >= entry->expire) {
+			tls_ocsp_cache_entry_free(entry);
+			return -1;
+		}
+		/* Keep the list in least recently used order */
+		dl_list_del(&entry->list);
+		dl_list_add(&tls_ocsp_cache, &entry->list);
+		return entry->status;
+	}
+
+	return -1;
+}
+
+
+static void tls_ocsp_cache_add(const u8 *key, int status,
+			       ASN1_GENERALIZEDTIME *next_update)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L && !defined(LIBRESSL_VERSION_NUMBER)
+	struct tls_ocsp_cache_entry *entry;
+	struct os_time now;
+	int day, sec;
+
+	if (!next_update || !ASN1_TIME_diff(&day, &sec, NULL, next_update) ||
+	    day < 0 || sec < 0 || (day == 0 && sec == 0))
+		return;
+
+	entry = os_zalloc(sizeof(*entry));
+	if (!entry)
+		return;
+	os_memcpy(entry->key, key, SHA256_MAC_LEN);
+	entry->status = status;
+	os_get_time(&now);
+	entry->expire = now.sec + (os_time_t) day * 24 * 60 * 60 + sec;
+
+	if (dl_list_len(&tls_ocsp_cache) >= TLS_OCSP_CACHE_MAX)
+		tls_ocsp_cache_entry_free(
+			dl_list_last(&tls_ocsp_cache,
+				     struct tls_ocsp_cache_entry, list));
+	dl_list_add(&tls_ocsp_cache, &entry->list);
+#endif /* >= 1.0.2 */
+}
+
+
+static int ocsp_status_ok(struct tls_connection *conn, int status)
+{
+	wpa_printf(MSG_DEBUG, "OpenSSL: OCSP status for server certificate: %s",
+		   OCSP_cert_status_str(status));
+
+	if (status == V_OCSP_CERTSTATUS_GOOD)
+		return 1;
+	if (status == V_OCSP_CERTSTATUS_REVOKED)
+		return 0;
+	if (conn->flags & TLS_CONN_REQUIRE_OCSP) {
+		wpa_printf(MSG_DEBUG, "OpenSSL: OCSP status unknown, but OCSP required");
+		return 0;
+	}
+	wpa_printf(MSG_DEBUG, "OpenSSL: OCSP status unknown, but OCSP was not required, so allow connection to continue");
+	return 1;
+}
+
+
 static int ocsp_resp_cb(SSL *s, void *arg)
 {
 	struct tls_connection *conn = arg;
@@ -3754,6 +4147,8 @@ static int ocsp_resp_cb(SSL *s, void *arg)
 	ASN1_GENERALIZEDTIME *produced_at, *this_update, *next_update;
 	X509_STORE *store;
 	STACK_OF(X509) *certs = NULL;
+	u8 key[SHA256_MAC_LEN];
+	int cache = 0;
 
 	len = SSL_get_tlsext_status_ocsp_resp(s, &p);
 	if (!p) {
@@ -3763,6 +4158,18 @@ static int ocsp_resp_cb(SSL *s, void *arg)
 
 	wpa_hexdump(MSG_DEBUG, "OpenSSL: OCSP response", p, len);
 
+	if (conn->peer_cert && conn->peer_issuer &&
+	    tls_ocsp_cache_key(conn->peer_cert, conn->peer_issuer, p, len,
+			       key) == 0) {
+		cache = 1;
+		status = tls_ocsp_cache_get(key);
+		if (status >= 0) {
+			wpa_printf(MSG_DEBUG,
+				   "OpenSSL: Use cached result of an earlier OCSP response verification");
+			return ocsp_status_ok(conn, status);
+		}
+	}
+
 	rsp = d2i_OCSP_RESPONSE(NULL, &p, len);
 	if (!rsp) {
 		wpa_printf(MSG_INFO, "OpenSSL: Failed to parse OCSP response");
@@ -3784,14 +4191,17 @@ static int ocsp_resp_cb(SSL *s, void *arg)
 		return 0;
 	}
 
+	/*
+	 * The certificate store may be shared with other connections through
+	 * the CA certificate cache, so it must not be modified here. The
+	 * issuer is passed in the certs stack instead, which is trusted as a
+	 * responder with OCSP_TRUSTOTHER and is available for building the
+	 * chain of a delegated responder.
+	 */
 	store = SSL_CTX_get_cert_store(conn->ssl_ctx);
 	if (conn->peer_issuer) {
 		debug_print_cert(conn->peer_issuer, "Add OCSP issuer");
 
-		if (X509_STORE_add_cert(store, conn->peer_issuer) != 1) {
-			tls_show_errors(MSG_INFO, __func__,
-					"OpenSSL: Could not add issuer to certificate store");
-		}
 		certs = sk_X509_new_null();
 		if (certs) {
 			X509 *cert;
@@ -3870,31 +4280,44 @@ static int ocsp_resp_cb(SSL *s, void *arg)
 		return 0;
 	}
 
+	if (cache)
+		tls_ocsp_cache_add(key, status, next_update);
+
 	OCSP_BASICRESP_free(basic);
 	OCSP_RESPONSE_free(rsp);
 
-	wpa_printf(MSG_DEBUG, "OpenSSL: OCSP status for server certificate: %s",
-		   OCSP_cert_status_str(status));
-
-	if (status == V_OCSP_CERTSTATUS_GOOD)
-		return 1;
-	if (status == V_OCSP_CERTSTATUS_REVOKED)
-		return 0;
-	if (conn->flags & TLS_CONN_REQUIRE_OCSP) {
-		wpa_printf(MSG_DEBUG, "OpenSSL: OCSP status unknown, but OCSP required");
-		return 0;
-	}
-	wpa_printf(MSG_DEBUG, "OpenSSL: OCSP status unknown, but OCSP was not required, so allow connection to continue");
-	return 1;
+	return ocsp_status_ok(conn, status);
 }
 
 
 static int ocsp_status_cb(SSL *s, void *arg)
 {
+	struct tls_data *data = arg;
 	char *tmp;
 	char *resp;
 	size_t len;
 
+	if (data->ocsp_resp) {
+		struct os_time now;
+
+		os_get_time(&now);
+		if (!data->ocsp_resp_expire ||
+		    now.sec < data->ocsp_resp_expire) {
+			wpa_printf(MSG_DEBUG, "OpenSSL: OCSP status callback - send response from memory");
+			len = wpabuf_len(data->ocsp_resp);
+			tmp = OPENSSL_malloc(len);
+			if (tmp == NULL)
+				return SSL_TLSEXT_ERR_ALERT_FATAL;
+			os_memcpy(tmp, wpabuf_head(data->ocsp_resp), len);
+			SSL_set_tlsext_status_ocsp_resp(s, tmp, len);
+			return SSL_TLSEXT_ERR_OK;
+		}
+
+		wpa_printf(MSG_DEBUG, "OpenSSL: OCSP response in memory has expired");
+		wpabuf_free(data->ocsp_resp);
+		data->ocsp_resp = NULL;
+	}
+
 	if (tls_global->ocsp_stapling_response == NULL) {
 		wpa_printf(MSG_DEBUG, "OpenSSL: OCSP status callback - no response configured");
 		return SSL_TLSEXT_ERR_OK;
@@ -3921,6 +4344,65 @@ static int ocsp_status_cb(SSL *s, void *arg)
 	return SSL_TLSEXT_ERR_OK;
 }
 
+
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L && !defined(LIBRESSL_VERSION_NUMBER)
+static OCSP_CERTID * ocsp_server_cert_id(SSL_CTX *ssl_ctx, X509 **issuer)
+{
+	X509 *cert;
+	STACK_OF(X509) *chain = NULL;
+	X509_STORE_CTX *store_ctx;
+	OCSP_CERTID *id;
+	int i;
+
+	*issuer = NULL;
+	cert = SSL_CTX_get0_certificate(ssl_ctx);
+	if (!cert) {
+		wpa_printf(MSG_INFO,
+			   "OpenSSL: No server certificate configured for OCSP");
+		return NULL;
+	}
+
+	/*
+	 * Look for the issuer first from the configured certificate chain and
+	 * then from the trusted CA certificates.
+	 */
+	if (SSL_CTX_get0_chain_certs(ssl_ctx, &chain) != 1)
+		chain = NULL;
+	for (i = 0; chain && i < sk_X509_num(chain); i++) {
+		X509 *c = sk_X509_value(chain, i);
+
+		if (X509_check_issued(c, cert) == X509_V_OK) {
+			*issuer = X509_dup(c);
+			break;
+		}
+	}
+
+	if (!*issuer) {
+		store_ctx = X509_STORE_CTX_new();
+		if (!store_ctx ||
+		    X509_STORE_CTX_init(store_ctx,
+					SSL_CTX_get_cert_store(ssl_ctx),
+					cert, NULL) != 1 ||
+		    X509_STORE_CTX_get1_issuer(issuer, store_ctx, cert) != 1)
+			*issuer = NULL;
+		X509_STORE_CTX_free(store_ctx);
+	}
+
+	if (!*issuer) {
+		wpa_printf(MSG_INFO,
+			   "OpenSSL: Could not find issuer of the server certificate for OCSP");
+		return NULL;
+	}
+
+	id = OCSP_cert_to_id(NULL, cert, *issuer);
+	if (!id) {
+		X509_free(*issuer);
+		*issuer = NULL;
+	}
+	return id;
+}
+#endif /* >= 1.0.2 */
+
 #endif /* HAVE_OCSP */
 
 
@@ -4128,7 +4610,7 @@ int tls_global_set_params(void *tls_ctx,
 
 #ifdef HAVE_OCSP
 	SSL_CTX_set_tlsext_status_cb(ssl_ctx, ocsp_status_cb);
-	SSL_CTX_set_tlsext_status_arg(ssl_ctx, ssl_ctx);
+	SSL_CTX_set_tlsext_status_arg(ssl_ctx, data);
 	os_free(tls_global->ocsp_stapling_response);
 	if (params->ocsp_stapling_response)
 		tls_global->ocsp_stapling_response =
@@ -4141,6 +4623,157 @@ int tls_global_set_params(void *tls_ctx,
 }
 
 
+struct wpabuf * tls_global_get_ocsp_request(void *tls_ctx)
+{
+#if defined(HAVE_OCSP) && OPENSSL_VERSION_NUMBER >= 0x10002000L && !defined(LIBRESSL_VERSION_NUMBER)
+	struct tls_data *data = tls_ctx;
+	OCSP_REQUEST *req;
+	OCSP_CERTID *id;
+	X509 *issuer;
+	struct wpabuf *buf = NULL;
+	unsigned char *pos;
+	int len;
+
+	id = ocsp_server_cert_id(data->ssl, &issuer);
+	if (!id)
+		return NULL;
+	X509_free(issuer);
+
+	req = OCSP_REQUEST_new();
+	if (!req || !OCSP_request_add0_id(req, id)) {
+		OCSP_CERTID_free(id);
+		OCSP_REQUEST_free(req);
+		return NULL;
+	}
+
+	len = i2d_OCSP_REQUEST(req, NULL);
+	if (len > 0)
+		buf = wpabuf_alloc(len);
+	if (buf) {
+		pos = wpabuf_put(buf, len);
+		i2d_OCSP_REQUEST(req, &pos);
+	}
+	OCSP_REQUEST_free(req);
+
+	return buf;
+#else /* HAVE_OCSP && >= 1.0.2 */
+	return NULL;
+#endif /* HAVE_OCSP && >= 1.0.2 */
+}
+
+
+int tls_global_set_ocsp_response(void *tls_ctx, const struct wpabuf *resp,
+				 unsigned int *valid_time)
+{
+#if defined(HAVE_OCSP) && OPENSSL_VERSION_NUMBER >= 0x10002000L && !defined(LIBRESSL_VERSION_NUMBER)
+	struct tls_data *data = tls_ctx;
+	const unsigned char *p = wpabuf_head(resp);
+	OCSP_RESPONSE *rsp;
+	OCSP_BASICRESP *basic = NULL;
+	OCSP_CERTID *id = NULL;
+	ASN1_GENERALIZEDTIME *produced_at, *this_update, *next_update;
+	X509 *issuer = NULL;
+	X509_STORE *store = NULL;
+	STACK_OF(X509) *certs = NULL;
+	struct wpabuf *copy;
+	struct os_time now;
+	int status, reason, day, sec;
+	int ret = -1;
+
+	*valid_time = 0;
+
+	rsp = d2i_OCSP_RESPONSE(NULL, &p, wpabuf_len(resp));
+	if (!rsp) {
+		wpa_printf(MSG_INFO, "OpenSSL: Failed to parse OCSP response");
+		return -1;
+	}
+
+	status = OCSP_response_status(rsp);
+	if (status != OCSP_RESPONSE_STATUS_SUCCESSFUL) {
+		wpa_printf(MSG_INFO, "OpenSSL: OCSP responder error %d (%s)",
+			   status, OCSP_response_status_str(status));
+		goto fail;
+	}
+
+	basic = OCSP_response_get1_basic(rsp);
+	if (!basic) {
+		wpa_printf(MSG_INFO, "OpenSSL: Could not find BasicOCSPResponse");
+		goto fail;
+	}
+
+	id = ocsp_server_cert_id(data->ssl, &issuer);
+	if (!id)
+		goto fail;
+
+	/*
+	 * The response needs to be signed by the issuer of the server
+	 * certificate or by a responder that the issuer has authorized.
+	 */
+	store = X509_STORE_new();
+	certs = sk_X509_new_null();
+	if (!store || !certs || X509_STORE_add_cert(store, issuer) != 1 ||
+	    !sk_X509_push(certs, issuer))
+		goto fail;
+	issuer = NULL;
+	if (OCSP_basic_verify(basic, certs, store, OCSP_TRUSTOTHER) <= 0) {
+		tls_show_errors(MSG_INFO, __func__,
+				"OpenSSL: OCSP response failed verification");
+		goto fail;
+	}
+
+	if (!OCSP_resp_find_status(basic, id, &status, &reason, &produced_at,
+				   &this_update, &next_update)) {
+		wpa_printf(MSG_INFO,
+			   "OpenSSL: Could not find server certificate from OCSP response");
+		goto fail;
+	}
+
+	if (!OCSP_check_validity(this_update, next_update, 5 * 60, -1)) {
+		tls_show_errors(MSG_INFO, __func__,
+				"OpenSSL: OCSP status times invalid");
+		goto fail;
+	}
+
+	if (next_update) {
+		if (!ASN1_TIME_diff(&day, &sec, NULL, next_update) ||
+		    day < 0 || sec < 0 || (day == 0 && sec == 0)) {
+			wpa_printf(MSG_INFO,
+				   "OpenSSL: OCSP response nextUpdate has passed");
+			goto fail;
+		}
+		*valid_time = day * 24 * 60 * 60 + sec;
+	}
+
+	wpa_printf(MSG_DEBUG,
+		   "OpenSSL: OCSP status for server certificate: %s (valid for %u seconds)",
+		   OCSP_cert_status_str(status), *valid_time);
+
+	copy = wpabuf_dup(resp);
+	if (!copy)
+		goto fail;
+	wpabuf_free(data->ocsp_resp);
+	data->ocsp_resp = copy;
+	data->ocsp_resp_expire = 0;
+	if (*valid_time) {
+		os_get_time(&now);
+		data->ocsp_resp_expire = now.sec + *valid_time;
+	}
+	ret = 0;
+
+fail:
+	sk_X509_pop_free(certs, X509_free);
+	X509_STORE_free(store);
+	X509_free(issuer);
+	OCSP_CERTID_free(id);
+	OCSP_BASICRESP_free(basic);
+	OCSP_RESPONSE_free(rsp);
+	return ret;
+#else /* HAVE_OCSP && >= 1.0.2 */
+	return -1;
+#endif /* HAVE_OCSP && >= 1.0.2 */
+}
+
+
 #if defined(EAP_FAST) || defined(EAP_FAST_DYNAMIC) || defined(EAP_SERVER_FAST)
 /* Pre-shared secred requires a patch to openssl, so this function is
  * commented out unless explicitly needed for EAP-FAST in order to be able to
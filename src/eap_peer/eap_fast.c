@@ -9,6 +9,7 @@
 #include "includes.h"
 
 #include "common.h"
+#include "utils/eloop.h"
 #include "crypto/tls.h"
 #include "crypto/sha1.h"
 #include "eap_common/eap_tlv_common.h"
@@ -28,6 +29,7 @@
 
 
 static void eap_fast_deinit(struct eap_sm *sm, void *priv);
+static void eap_fast_save_pac_timeout(void *eloop_ctx, void *timeout_ctx);
 
 
 struct eap_fast_data {
@@ -59,9 +61,11 @@ struct eap_fast_data {
 	int success;
 
 	struct eap_fast_pac *pac;
+	struct eap_fast_pac *pac_hash[EAP_FAST_PAC_HASH_SIZE];
 	struct eap_fast_pac *current_pac;
 	size_t max_pac_list_len;
 	int use_pac_binary_format;
+	int pac_dirty; /* PAC list changed since it was last saved */
 
 	u8 simck[EAP_FAST_SIMCK_LEN];
 	int simck_idx;
@@ -113,6 +117,47 @@ static int eap_fast_session_ticket_cb(void *ctx, const u8 *ticket, size_t len,
 }
 
 
+static void eap_fast_save_pac_flush(struct eap_sm *sm,
+				    struct eap_fast_data *data)
+{
+	struct eap_peer_config *config = eap_get_config(sm);
+
+	if (!data->pac_dirty)
+		return;
+	eloop_cancel_timeout(eap_fast_save_pac_timeout, sm, data);
+	data->pac_dirty = 0;
+	if (config == NULL)
+		return;
+
+	if (data->use_pac_binary_format)
+		eap_fast_save_pac_bin(sm, data->pac, config->pac_file);
+	else
+		eap_fast_save_pac(sm, data->pac, config->pac_file);
+}
+
+
+static void eap_fast_save_pac_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	eap_fast_save_pac_flush(eloop_ctx, timeout_ctx);
+}
+
+
+/*
+ * Mark the PAC list as changed. The PAC file is written once control returns
+ * to the event loop, i.e., after the current EAP response has been sent, so
+ * all updates from a single message result in a single write. Pending changes
+ * are also written out when the method is deinitialized.
+ */
+static void eap_fast_save_pac_deferred(struct eap_sm *sm,
+				       struct eap_fast_data *data)
+{
+	data->pac_dirty = 1;
+	if (!eloop_is_timeout_registered(eap_fast_save_pac_timeout, sm, data))
+		eloop_register_timeout(0, 0, eap_fast_save_pac_timeout, sm,
+				       data);
+}
+
+
 static void eap_fast_parse_phase1(struct eap_fast_data *data,
 				  const char *phase1)
 {
@@ -215,6 +260,7 @@ static void * eap_fast_init(struct eap_sm *sm)
 		return NULL;
 	}
 	eap_fast_pac_list_truncate(data->pac, data->max_pac_list_len);
+	eap_fast_pac_index(data->pac, data->pac_hash);
 
 	if (data->pac == NULL && !data->provisioning_allowed) {
 		wpa_printf(MSG_INFO, "EAP-FAST: No PAC configured and "
@@ -240,6 +286,7 @@ static void eap_fast_deinit(struct eap_sm *sm, void *priv)
 	os_free(data->key_block_p);
 	eap_peer_tls_ssl_deinit(sm, &data->ssl);
 
+	eap_fast_save_pac_flush(sm, data);
 	pac = data->pac;
 	prev = NULL;
 	while (pac) {
@@ -1030,20 +1077,28 @@ static struct wpabuf * eap_fast_process_pac(struct eap_sm *sm,
 					    struct eap_method_ret *ret,
 					    u8 *pac, size_t pac_len)
 {
-	struct eap_peer_config *config = eap_get_config(sm);
 	struct eap_fast_pac entry;
+	int res;
 
 	os_memset(&entry, 0, sizeof(entry));
 	if (eap_fast_process_pac_tlv(&entry, pac, pac_len) ||
 	    eap_fast_process_pac_info(&entry))
 		return NULL;
 
-	eap_fast_add_pac(&data->pac, &data->current_pac, &entry);
-	eap_fast_pac_list_truncate(data->pac, data->max_pac_list_len);
-	if (data->use_pac_binary_format)
-		eap_fast_save_pac_bin(sm, data->pac, config->pac_file);
-	else
-		eap_fast_save_pac(sm, data->pac, config->pac_file);
+	res = eap_fast_add_pac(&data->pac, &data->current_pac, &entry);
+	if (res == 1) {
+		wpa_printf(MSG_DEBUG,
+			   "EAP-FAST: Received PAC is already stored - skip PAC file update");
+	} else {
+		/*
+		 * The old entry for the A-ID may have been removed even if
+		 * adding the new one failed, so the list has changed in both
+		 * cases.
+		 */
+		eap_fast_pac_list_truncate(data->pac, data->max_pac_list_len);
+		eap_fast_pac_index(data->pac, data->pac_hash);
+		eap_fast_save_pac_deferred(sm, data);
+	}
 
 	if (data->provisioning) {
 		if (data->anon_provisioning) {
@@ -1372,7 +1427,7 @@ static const u8 * eap_fast_get_a_id(const u8 *buf, size_t len, size_t *id_len)
 static void eap_fast_select_pac(struct eap_fast_data *data,
 				const u8 *a_id, size_t a_id_len)
 {
-	data->current_pac = eap_fast_get_pac(data->pac, a_id, a_id_len,
+	data->current_pac = eap_fast_get_pac(data->pac_hash, a_id, a_id_len,
 					     PAC_TYPE_TUNNEL_PAC);
 	if (data->current_pac == NULL) {
 		/*
@@ -1380,7 +1435,7 @@ static void eap_fast_select_pac(struct eap_fast_data *data,
 		 * Machine Authentication PAC, if one is available.
 		 */
 		data->current_pac = eap_fast_get_pac(
-			data->pac, a_id, a_id_len,
+			data->pac_hash, a_id, a_id_len,
 			PAC_TYPE_MACHINE_AUTHENTICATION);
 	}
 
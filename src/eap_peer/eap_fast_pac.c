@@ -58,26 +58,66 @@ void eap_fast_free_pac(struct eap_fast_pac *pac)
 }
 
 
+static unsigned int eap_fast_pac_hash(const u8 *a_id, size_t a_id_len)
+{
+	unsigned int hash = 0;
+	size_t i;
+
+	for (i = 0; i < a_id_len; i++)
+		hash = hash * 31 + a_id[i];
+	return hash % EAP_FAST_PAC_HASH_SIZE;
+}
+
+
+/**
+ * eap_fast_pac_index - Build the A-ID hash index for a PAC list
+ * @pac_root: Root of the PAC list
+ * @pac_hash: Hash table with EAP_FAST_PAC_HASH_SIZE buckets (to be filled)
+ *
+ * The index needs to be rebuilt whenever entries are added to or removed from
+ * the PAC list. Entries within a bucket are kept in the PAC list order.
+ */
+void eap_fast_pac_index(struct eap_fast_pac *pac_root,
+			struct eap_fast_pac **pac_hash)
+{
+	struct eap_fast_pac *pac, **tail[EAP_FAST_PAC_HASH_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < EAP_FAST_PAC_HASH_SIZE; i++) {
+		pac_hash[i] = NULL;
+		tail[i] = &pac_hash[i];
+	}
+
+	for (pac = pac_root; pac; pac = pac->next) {
+		i = eap_fast_pac_hash(pac->a_id, pac->a_id_len);
+		pac->hnext = NULL;
+		*tail[i] = pac;
+		tail[i] = &pac->hnext;
+	}
+}
+
+
 /**
  * eap_fast_get_pac - Get a PAC entry based on A-ID
- * @pac_root: Pointer to root of the PAC list
+ * @pac_hash: A-ID hash index built with eap_fast_pac_index()
  * @a_id: A-ID to search for
  * @a_id_len: Length of A-ID
  * @pac_type: PAC-Type to search for
  * Returns: Pointer to the PAC entry, or %NULL if A-ID not found
  */
-struct eap_fast_pac * eap_fast_get_pac(struct eap_fast_pac *pac_root,
+struct eap_fast_pac * eap_fast_get_pac(struct eap_fast_pac **pac_hash,
 				       const u8 *a_id, size_t a_id_len,
 				       u16 pac_type)
 {
-	struct eap_fast_pac *pac = pac_root;
+	struct eap_fast_pac *pac;
 
+	pac = pac_hash[eap_fast_pac_hash(a_id, a_id_len)];
 	while (pac) {
 		if (pac->pac_type == pac_type && pac->a_id_len == a_id_len &&
 		    os_memcmp(pac->a_id, a_id, a_id_len) == 0) {
 			return pac;
 		}
-		pac = pac->next;
+		pac = pac->hnext;
 	}
 	return NULL;
 }
@@ -124,17 +164,47 @@ static int eap_fast_copy_buf(u8 **dst, size_t *dst_len,
 }
 
 
+static int eap_fast_buf_equal(const u8 *a, size_t a_len,
+			      const u8 *b, size_t b_len)
+{
+	if (a == NULL || b == NULL)
+		return a == b;
+	return a_len == b_len && os_memcmp(a, b, a_len) == 0;
+}
+
+
+static int eap_fast_pac_equal(struct eap_fast_pac *a, struct eap_fast_pac *b)
+{
+	return a->pac_type == b->pac_type &&
+		os_memcmp_const(a->pac_key, b->pac_key,
+				EAP_FAST_PAC_KEY_LEN) == 0 &&
+		eap_fast_buf_equal(a->pac_opaque, a->pac_opaque_len,
+				   b->pac_opaque, b->pac_opaque_len) &&
+		eap_fast_buf_equal(a->pac_info, a->pac_info_len,
+				   b->pac_info, b->pac_info_len) &&
+		eap_fast_buf_equal(a->a_id, a->a_id_len,
+				   b->a_id, b->a_id_len) &&
+		eap_fast_buf_equal(a->i_id, a->i_id_len,
+				   b->i_id, b->i_id_len) &&
+		eap_fast_buf_equal(a->a_id_info, a->a_id_info_len,
+				   b->a_id_info, b->a_id_info_len);
+}
+
+
 /**
  * eap_fast_add_pac - Add a copy of a PAC entry to a list
  * @pac_root: Pointer to PAC list root pointer
  * @pac_current: Pointer to the current PAC pointer
  * @entry: New entry to clone and add to the list
- * Returns: 0 on success, -1 on failure
+ * Returns: 0 on success, 1 if an identical entry was already in the list, or
+ * -1 on failure
  *
  * This function makes a clone of the given PAC entry and adds this copied
  * entry to the list (pac_root). If an old entry for the same A-ID is found,
  * it will be removed from the PAC list and in this case, pac_current entry
- * is set to %NULL if it was the removed entry.
+ * is set to %NULL if it was the removed entry. The list is left unmodified if
+ * the old entry is identical to the new one. The caller is responsible for
+ * rebuilding the A-ID hash index with eap_fast_pac_index() after changes.
  */
 int eap_fast_add_pac(struct eap_fast_pac **pac_root,
 		     struct eap_fast_pac **pac_current,
@@ -145,6 +215,16 @@ int eap_fast_add_pac(struct eap_fast_pac **pac_root,
 	if (entry == NULL || entry->a_id == NULL)
 		return -1;
 
+	for (pac = *pac_root; pac; pac = pac->next) {
+		if (pac->pac_type == entry->pac_type &&
+		    pac->a_id_len == entry->a_id_len &&
+		    os_memcmp(pac->a_id, entry->a_id, entry->a_id_len) == 0) {
+			if (eap_fast_pac_equal(pac, entry))
+				return 1;
+			break;
+		}
+	}
+
 	/* Remove a possible old entry for the matching A-ID. */
 	eap_fast_remove_pac(pac_root, pac_current,
 			    entry->a_id, entry->a_id_len, entry->pac_type);
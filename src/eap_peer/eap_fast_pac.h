@@ -11,8 +11,11 @@
 
 #include "eap_common/eap_fast_common.h"
 
+#define EAP_FAST_PAC_HASH_SIZE 16
+
 struct eap_fast_pac {
 	struct eap_fast_pac *next;
+	struct eap_fast_pac *hnext; /* next entry in the A-ID hash bucket */
 
 	u8 pac_key[EAP_FAST_PAC_KEY_LEN];
 	u8 *pac_opaque;
@@ -30,7 +33,9 @@ struct eap_fast_pac {
 
 
 void eap_fast_free_pac(struct eap_fast_pac *pac);
-struct eap_fast_pac * eap_fast_get_pac(struct eap_fast_pac *pac_root,
+void eap_fast_pac_index(struct eap_fast_pac *pac_root,
+			struct eap_fast_pac **pac_hash);
+struct eap_fast_pac * eap_fast_get_pac(struct eap_fast_pac **pac_hash,
 				       const u8 *a_id, size_t a_id_len,
 				       u16 pac_type);
 int eap_fast_add_pac(struct eap_fast_pac **pac_root,
@@ -403,7 +403,8 @@ static int eap_peer_tls_reassemble_fragment(struct eap_ssl_data *data,
 		return -1;
 	}
 
-	if (tls_in_len + in_len > 65536) {
+	if (tls_in_len + in_len > 65536 ||
+	    tls_in_len + data->tls_in_left > 65536) {
 		/*
 		 * Limit length to avoid rogue servers from causing large
 		 * memory allocations.
@@ -422,7 +423,11 @@ static int eap_peer_tls_reassemble_fragment(struct eap_ssl_data *data,
 		return -1;
 	}
 
-	if (wpabuf_resize(&data->tls_in, in_len) < 0) {
+	/*
+	 * Reserve room for the remaining part of the message at once to avoid
+	 * reallocating and copying the buffer for each fragment.
+	 */
+	if (wpabuf_resize(&data->tls_in, data->tls_in_left) < 0) {
 		wpa_printf(MSG_INFO, "SSL: Could not allocate memory for TLS "
 			   "data");
 		eap_peer_tls_reset_input(data);
@@ -471,11 +476,11 @@ static const struct wpabuf * eap_peer_tls_data_reassemble(
 
 		/* Message is now fully reassembled. */
 	} else {
-		/* No fragments in this message, so just make a copy of it. */
+		/* Wrap unfragmented messages as wpabuf without extra copy */
 		data->tls_in_left = 0;
-		data->tls_in = wpabuf_dup(in_data);
-		if (data->tls_in == NULL)
-			return NULL;
+		wpabuf_set(&data->tmpbuf, wpabuf_head(in_data),
+			   wpabuf_len(in_data));
+		data->tls_in = &data->tmpbuf;
 	}
 
 	return data->tls_in;
@@ -873,10 +878,9 @@ const u8 * eap_peer_tls_process_init(struct eap_sm *sm,
 		wpa_printf(MSG_DEBUG, "SSL: TLS Message Length: %d",
 			   tls_msg_len);
 		if (data->tls_in_left == 0) {
+			eap_peer_tls_reset_input(data);
 			data->tls_in_total = tls_msg_len;
 			data->tls_in_left = tls_msg_len;
-			wpabuf_free(data->tls_in);
-			data->tls_in = NULL;
 		}
 		pos += 4;
 		left -= 4;
@@ -910,7 +914,8 @@ const u8 * eap_peer_tls_process_init(struct eap_sm *sm,
 void eap_peer_tls_reset_input(struct eap_ssl_data *data)
 {
 	data->tls_in_left = data->tls_in_total = 0;
-	wpabuf_free(data->tls_in);
+	if (data->tls_in != &data->tmpbuf)
+		wpabuf_free(data->tls_in);
 	data->tls_in = NULL;
 }
 
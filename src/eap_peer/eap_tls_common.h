@@ -48,6 +48,14 @@ struct eap_ssl_data {
 	 */
 	size_t tls_in_total;
 
+	/**
+	 * tmpbuf - Wrapper for an unfragmented incoming TLS message
+	 *
+	 * tls_in points to this when the received message did not need to
+	 * be reassembled.
+	 */
+	struct wpabuf tmpbuf;
+
 	/**
 	 * phase2 - Whether this TLS connection is used in EAP phase 2 (tunnel)
 	 */
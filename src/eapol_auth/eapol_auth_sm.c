@@ -11,6 +11,7 @@
 #include "common.h"
 #include "eloop.h"
 #include "state_machine.h"
+#include "metrics.h"
 #include "common/eapol_common.h"
 #include "eap_common/eap_defs.h"
 #include "eap_common/eap_common.h"
@@ -82,6 +83,31 @@ static void eapol_auth_vlogger(struct eapol_authenticator *eapol,
 }
 
 
+static void eapol_auth_duration_metric(struct eapol_state_machine *sm,
+				       int success)
+{
+	static struct metric *m[256][2];
+	struct metric **dur = &m[sm->eap_type_authsrv][!!success];
+	struct os_reltime now, age;
+
+	if (!sm->auth_start.sec)
+		return;
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &sm->auth_start, &age);
+	sm->auth_start.sec = 0;
+
+	if (!*dur) {
+		char name[METRICS_NAME_LEN];
+
+		os_snprintf(name, sizeof(name), "eap.%s.%s_ms",
+			    eap_server_get_name(0, sm->eap_type_authsrv),
+			    success ? "success" : "failure");
+		*dur = metrics_get(name, METRIC_HISTOGRAM);
+	}
+	metrics_observe(*dur, age.sec * 1000 + age.usec / 1000);
+}
+
+
 static void eapol_auth_tx_canned_eap(struct eapol_state_machine *sm,
 				     int success)
 {
@@ -269,8 +295,10 @@ SM_STATE(AUTH_PAE, CONNECTING)
 
 SM_STATE(AUTH_PAE, HELD)
 {
-	if (sm->auth_pae_state == AUTH_PAE_AUTHENTICATING && sm->authFail)
+	if (sm->auth_pae_state == AUTH_PAE_AUTHENTICATING && sm->authFail) {
 		sm->authAuthFailWhileAuthenticating++;
+		eapol_auth_duration_metric(sm, 0);
+	}
 
 	SM_ENTRY_MA(AUTH_PAE, HELD, auth_pae);
 
@@ -298,8 +326,10 @@ SM_STATE(AUTH_PAE, AUTHENTICATED)
 {
 	char *extra = "";
 
-	if (sm->auth_pae_state == AUTH_PAE_AUTHENTICATING && sm->authSuccess)
+	if (sm->auth_pae_state == AUTH_PAE_AUTHENTICATING && sm->authSuccess) {
 		sm->authAuthSuccessesWhileAuthenticating++;
+		eapol_auth_duration_metric(sm, 1);
+	}
 							
 	SM_ENTRY_MA(AUTH_PAE, AUTHENTICATED, auth_pae);
 
@@ -324,6 +354,7 @@ SM_STATE(AUTH_PAE, AUTHENTICATING)
 {
 	SM_ENTRY_MA(AUTH_PAE, AUTHENTICATING, auth_pae);
 
+	os_get_reltime(&sm->auth_start);
 	sm->eapolStart = FALSE;
 	sm->authSuccess = FALSE;
 	sm->authFail = FALSE;
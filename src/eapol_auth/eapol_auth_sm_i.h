@@ -156,6 +156,7 @@ struct eapol_state_machine {
 	u8 eap_type_authsrv; /* EAP type of the last EAP packet from
 			      * Authentication server */
 	u8 eap_type_supp; /* EAP type of the last EAP packet from Supplicant */
+	struct os_reltime auth_start; /* entry to AUTHENTICATING */
 	struct radius_class_data radius_class;
 	struct wpabuf *radius_cui; /* Chargeable-User-Identity */
 
@@ -249,8 +249,8 @@ ieee802_1x_kay_get_participant(struct ieee802_1x_kay *kay, const u8 *ckn)
 {
 	struct ieee802_1x_mka_participant *participant;
 
-	dl_list_for_each(participant, &kay->participant_list,
-			 struct ieee802_1x_mka_participant, list) {
+	for (participant = kay->participant_hash[ckn[0]]; participant;
+	     participant = participant->hnext) {
 		if (os_memcmp(participant->ckn.name, ckn,
 			      participant->ckn.len) == 0)
 			return participant;
@@ -281,12 +281,17 @@ ieee802_1x_kay_get_principal_participant(struct ieee802_1x_kay *kay)
 }
 
 
-static struct ieee802_1x_kay_peer * get_peer_mi(struct dl_list *peers,
-						const u8 *mi)
+/**
+ * ieee802_1x_kay_get_peer
+ */
+static struct ieee802_1x_kay_peer *
+ieee802_1x_kay_get_peer(struct ieee802_1x_mka_participant *participant,
+			const u8 *mi)
 {
 	struct ieee802_1x_kay_peer *peer;
 
-	dl_list_for_each(peer, peers, struct ieee802_1x_kay_peer, list) {
+	for (peer = participant->peer_mi_hash[KAY_PEER_MI_HASH(mi)]; peer;
+	     peer = peer->mi_hnext) {
 		if (os_memcmp(peer->mi, mi, MI_LEN) == 0)
 			return peer;
 	}
@@ -302,7 +307,10 @@ static struct ieee802_1x_kay_peer *
 ieee802_1x_kay_get_potential_peer(
 	struct ieee802_1x_mka_participant *participant, const u8 *mi)
 {
-	return get_peer_mi(&participant->potential_peers, mi);
+	struct ieee802_1x_kay_peer *peer;
+
+	peer = ieee802_1x_kay_get_peer(participant, mi);
+	return peer && !peer->is_live ? peer : NULL;
 }
 
 
@@ -313,7 +321,10 @@ static struct ieee802_1x_kay_peer *
 ieee802_1x_kay_get_live_peer(struct ieee802_1x_mka_participant *participant,
 			     const u8 *mi)
 {
-	return get_peer_mi(&participant->live_peers, mi);
+	struct ieee802_1x_kay_peer *peer;
+
+	peer = ieee802_1x_kay_get_peer(participant, mi);
+	return peer && peer->is_live ? peer : NULL;
 }
 
 
@@ -339,23 +350,6 @@ ieee802_1x_kay_is_in_live_peer(
 }
 
 
-/**
- * ieee802_1x_kay_get_peer
- */
-static struct ieee802_1x_kay_peer *
-ieee802_1x_kay_get_peer(struct ieee802_1x_mka_participant *participant,
-			const u8 *mi)
-{
-	struct ieee802_1x_kay_peer *peer;
-
-	peer = ieee802_1x_kay_get_live_peer(participant, mi);
-	if (peer)
-		return peer;
-
-	return ieee802_1x_kay_get_potential_peer(participant, mi);
-}
-
-
 /**
  * ieee802_1x_kay_get_cipher_suite
  */
@@ -393,21 +387,19 @@ static struct ieee802_1x_kay_peer *
 ieee802_1x_kay_get_peer_sci(struct ieee802_1x_mka_participant *participant,
 			    const struct ieee802_1x_mka_sci *sci)
 {
-	struct ieee802_1x_kay_peer *peer;
-
-	dl_list_for_each(peer, &participant->live_peers,
-			 struct ieee802_1x_kay_peer, list) {
-		if (sci_equal(&peer->sci, sci))
-			return peer;
-	}
+	struct ieee802_1x_kay_peer *peer, *potential = NULL;
 
-	dl_list_for_each(peer, &participant->potential_peers,
-			 struct ieee802_1x_kay_peer, list) {
-		if (sci_equal(&peer->sci, sci))
+	for (peer = participant->peer_sci_hash[KAY_PEER_SCI_HASH(sci)]; peer;
+	     peer = peer->sci_hnext) {
+		if (!sci_equal(&peer->sci, sci))
+			continue;
+		if (peer->is_live)
 			return peer;
+		if (!potential)
+			potential = peer;
 	}
 
-	return NULL;
+	return potential;
 }
 
 
@@ -543,6 +535,65 @@ ieee802_1x_kay_create_peer(const u8 *mi, u32 mn)
 }
 
 
+static void
+ieee802_1x_kay_index_peer(struct ieee802_1x_mka_participant *participant,
+			  struct ieee802_1x_kay_peer *peer)
+{
+	unsigned int hash;
+
+	hash = KAY_PEER_MI_HASH(peer->mi);
+	peer->mi_hnext = participant->peer_mi_hash[hash];
+	participant->peer_mi_hash[hash] = peer;
+
+	hash = KAY_PEER_SCI_HASH(&peer->sci);
+	peer->sci_hnext = participant->peer_sci_hash[hash];
+	participant->peer_sci_hash[hash] = peer;
+
+	if (peer->is_live)
+		participant->num_live_peers++;
+	else
+		participant->num_potential_peers++;
+}
+
+
+static void
+ieee802_1x_kay_unindex_peer(struct ieee802_1x_mka_participant *participant,
+			    struct ieee802_1x_kay_peer *peer)
+{
+	struct ieee802_1x_kay_peer **pos;
+
+	pos = &participant->peer_mi_hash[KAY_PEER_MI_HASH(peer->mi)];
+	while (*pos && *pos != peer)
+		pos = &(*pos)->mi_hnext;
+	if (*pos)
+		*pos = peer->mi_hnext;
+
+	pos = &participant->peer_sci_hash[KAY_PEER_SCI_HASH(&peer->sci)];
+	while (*pos && *pos != peer)
+		pos = &(*pos)->sci_hnext;
+	if (*pos)
+		*pos = peer->sci_hnext;
+
+	if (peer->is_live)
+		participant->num_live_peers--;
+	else
+		participant->num_potential_peers--;
+}
+
+
+/**
+ * ieee802_1x_kay_delete_peer - Remove a live or potential peer
+ */
+static void
+ieee802_1x_kay_delete_peer(struct ieee802_1x_mka_participant *participant,
+			   struct ieee802_1x_kay_peer *peer)
+{
+	ieee802_1x_kay_unindex_peer(participant, peer);
+	dl_list_del(&peer->list);
+	os_free(peer);
+}
+
+
 /**
  * ieee802_1x_kay_create_live_peer
  */
@@ -569,7 +620,9 @@ ieee802_1x_kay_create_live_peer(struct ieee802_1x_mka_participant *participant,
 		return NULL;
 	}
 
+	peer->is_live = TRUE;
 	dl_list_add(&participant->live_peers, &peer->list);
+	ieee802_1x_kay_index_peer(participant, peer);
 	dl_list_add(&participant->rxsc_list, &rxsc->list);
 	secy_create_receive_sc(participant->kay, rxsc);
 
@@ -594,6 +647,7 @@ ieee802_1x_kay_create_potential_peer(
 		return NULL;
 
 	dl_list_add(&participant->potential_peers, &peer->list);
+	ieee802_1x_kay_index_peer(participant, peer);
 
 	wpa_printf(MSG_DEBUG, "KaY: potential peer created");
 	ieee802_1x_kay_dump_peer(peer);
@@ -620,6 +674,7 @@ ieee802_1x_kay_move_live_peer(struct ieee802_1x_mka_participant *participant,
 	if (!rxsc)
 		return NULL;
 
+	ieee802_1x_kay_unindex_peer(participant, peer);
 	os_memcpy(&peer->sci, &participant->current_peer_sci,
 		  sizeof(peer->sci));
 	peer->mn = mn;
@@ -629,7 +684,9 @@ ieee802_1x_kay_move_live_peer(struct ieee802_1x_mka_participant *participant,
 	ieee802_1x_kay_dump_peer(peer);
 
 	dl_list_del(&peer->list);
+	peer->is_live = TRUE;
 	dl_list_add_tail(&participant->live_peers, &peer->list);
+	ieee802_1x_kay_index_peer(participant, peer);
 
 	secy_get_available_receive_sc(participant->kay, &sc_ch);
 
@@ -773,8 +830,7 @@ ieee802_1x_mka_decode_basic_body(struct ieee802_1x_kay *kay, const u8 *mka_msg,
 		if (peer) {
 			wpa_printf(MSG_WARNING,
 				   "KaY: duplicated SCI detected, Maybe active attacker");
-			dl_list_del(&peer->list);
-			os_free(peer);
+			ieee802_1x_kay_delete_peer(participant, peer);
 		}
 
 		peer = ieee802_1x_kay_create_potential_peer(
@@ -822,11 +878,9 @@ ieee802_1x_mka_get_live_peer_length(
 	struct ieee802_1x_mka_participant *participant)
 {
 	int len = MKA_HDR_LEN;
-	struct ieee802_1x_kay_peer *peer;
 
-	dl_list_for_each(peer, &participant->live_peers,
-			 struct ieee802_1x_kay_peer, list)
-		len += sizeof(struct ieee802_1x_mka_peer_id);
+	len += participant->num_live_peers *
+		sizeof(struct ieee802_1x_mka_peer_id);
 
 	return MKA_ALIGN_LENGTH(len);
 }
@@ -882,11 +936,9 @@ ieee802_1x_mka_get_potential_peer_length(
 	struct ieee802_1x_mka_participant *participant)
 {
 	int len = MKA_HDR_LEN;
-	struct ieee802_1x_kay_peer *peer;
 
-	dl_list_for_each(peer, &participant->potential_peers,
-			 struct ieee802_1x_kay_peer, list)
-		len += sizeof(struct ieee802_1x_mka_peer_id);
+	len += participant->num_potential_peers *
+		sizeof(struct ieee802_1x_mka_peer_id);
 
 	return MKA_ALIGN_LENGTH(len);
 }
@@ -2328,8 +2380,7 @@ static void ieee802_1x_participant_timer(void *eloop_ctx, void *timeout_ctx)
 						participant, rxsc);
 				}
 			}
-			dl_list_del(&peer->list);
-			os_free(peer);
+			ieee802_1x_kay_delete_peer(participant, peer);
 			lp_changed = TRUE;
 		}
 	}
@@ -2373,8 +2424,7 @@ static void ieee802_1x_participant_timer(void *eloop_ctx, void *timeout_ctx)
 			wpa_hexdump(MSG_DEBUG, "\tMI: ", peer->mi,
 				    sizeof(peer->mi));
 			wpa_printf(MSG_DEBUG, "\tMN: %d", peer->mn);
-			dl_list_del(&peer->list);
-			os_free(peer);
+			ieee802_1x_kay_delete_peer(participant, peer);
 		}
 	}
 
@@ -2678,11 +2728,11 @@ int ieee802_1x_kay_delete_sas(struct ieee802_1x_kay *kay,
 	dl_list_for_each_safe(sa_key, pre_key, &principal->sak_list,
 			      struct data_key, list) {
 		if (is_ki_equal(&sa_key->key_identifier, ki)) {
+			if (principal->new_key == sa_key)
+				principal->new_key = NULL;
 			ieee802_1x_kay_deinit_data_key(sa_key);
 			break;
 		}
-		if (principal->new_key == sa_key)
-			principal->new_key = NULL;
 	}
 
 	return 0;
@@ -3171,8 +3221,8 @@ ieee802_1x_kay_create_mka(struct ieee802_1x_kay *kay, struct mka_key_name *ckn,
 		wpa_printf(MSG_ERROR, "KaY: CAK length not follow key schema");
 		return NULL;
 	}
-	if (ckn->len > MAX_CKN_LEN) {
-		wpa_printf(MSG_ERROR, "KaY: CKN is out of range(<=32 bytes)");
+	if (ckn->len == 0 || ckn->len > MAX_CKN_LEN) {
+		wpa_printf(MSG_ERROR, "KaY: CKN is out of range(1..32 bytes)");
 		return NULL;
 	}
 	if (!kay->enable) {
@@ -3282,6 +3332,8 @@ ieee802_1x_kay_create_mka(struct ieee802_1x_kay *kay, struct mka_key_name *ckn,
 			participant->ick.key, participant->ick.len);
 
 	dl_list_add(&kay->participant_list, &participant->list);
+	participant->hnext = kay->participant_hash[participant->ckn.name[0]];
+	kay->participant_hash[participant->ckn.name[0]] = participant;
 	wpa_hexdump(MSG_DEBUG, "KaY: Participant created:",
 		    ckn->name, ckn->len);
 
@@ -3305,7 +3357,7 @@ fail:
 void
 ieee802_1x_kay_delete_mka(struct ieee802_1x_kay *kay, struct mka_key_name *ckn)
 {
-	struct ieee802_1x_mka_participant *participant;
+	struct ieee802_1x_mka_participant *participant, **pos;
 	struct ieee802_1x_kay_peer *peer;
 	struct data_key *sak;
 	struct receive_sc *rxsc;
@@ -3325,21 +3377,26 @@ ieee802_1x_kay_delete_mka(struct ieee802_1x_kay *kay, struct mka_key_name *ckn)
 
 	eloop_cancel_timeout(ieee802_1x_participant_timer, participant, NULL);
 	dl_list_del(&participant->list);
+	for (pos = &kay->participant_hash[participant->ckn.name[0]]; *pos;
+	     pos = &(*pos)->hnext) {
+		if (*pos == participant) {
+			*pos = participant->hnext;
+			break;
+		}
+	}
 
 	/* remove live peer */
 	while (!dl_list_empty(&participant->live_peers)) {
 		peer = dl_list_entry(participant->live_peers.next,
 				     struct ieee802_1x_kay_peer, list);
-		dl_list_del(&peer->list);
-		os_free(peer);
+		ieee802_1x_kay_delete_peer(participant, peer);
 	}
 
 	/* remove potential peer */
 	while (!dl_list_empty(&participant->potential_peers)) {
 		peer = dl_list_entry(participant->potential_peers.next,
 				     struct ieee802_1x_kay_peer, list);
-		dl_list_del(&peer->list);
-		os_free(peer);
+		ieee802_1x_kay_delete_peer(participant, peer);
 	}
 
 	/* remove sak */
@@ -217,6 +217,10 @@ struct ieee802_1x_kay {
 	Boolean tx_enable;
 
 	struct dl_list participant_list;
+	/* participants hashed by the first octet of CKN */
+#define KAY_PARTICIPANT_HASH_SIZE 256
+	struct ieee802_1x_mka_participant *
+	participant_hash[KAY_PARTICIPANT_HASH_SIZE];
 	enum macsec_policy policy;
 
 	struct ieee802_1x_cp_sm *cp;
@@ -41,6 +41,12 @@ struct ieee802_1x_mka_peer_id {
 	be32 mn;
 };
 
+/* Peers are hashed by the last octet of MI and SCI MAC address */
+#define KAY_PEER_HASH_SIZE 64
+#define KAY_PEER_MI_HASH(mi) ((mi)[MI_LEN - 1] & (KAY_PEER_HASH_SIZE - 1))
+#define KAY_PEER_SCI_HASH(sci) \
+	((sci)->addr[ETH_ALEN - 1] & (KAY_PEER_HASH_SIZE - 1))
+
 struct ieee802_1x_kay_peer {
 	struct ieee802_1x_mka_sci sci;
 	u8 mi[MI_LEN];
@@ -52,6 +58,11 @@ struct ieee802_1x_kay_peer {
 	enum macsec_cap macsec_capability;
 	Boolean sak_used;
 	struct dl_list list;
+
+	/* not defined in IEEE 802.1X */
+	Boolean is_live; /* in live_peers instead of potential_peers */
+	struct ieee802_1x_kay_peer *mi_hnext; /* next entry in peer_mi_hash */
+	struct ieee802_1x_kay_peer *sci_hnext; /* next entry in peer_sci_hash */
 };
 
 struct macsec_ciphersuite {
@@ -103,6 +114,13 @@ struct ieee802_1x_mka_participant {
 
 	/* not defined in IEEE 802.1X */
 	struct dl_list list;
+	struct ieee802_1x_mka_participant *hnext; /* kay->participant_hash */
+
+	/* live and potential peers indexed by MI and SCI */
+	struct ieee802_1x_kay_peer *peer_mi_hash[KAY_PEER_HASH_SIZE];
+	struct ieee802_1x_kay_peer *peer_sci_hash[KAY_PEER_HASH_SIZE];
+	unsigned int num_live_peers;
+	unsigned int num_potential_peers;
 
 	struct mka_key kek;
 	struct mka_key ick;
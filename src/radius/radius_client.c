@@ -12,6 +12,7 @@
 #include "radius.h"
 #include "radius_client.h"
 #include "eloop.h"
+#include "metrics.h"
 
 /* Defaults for RADIUS retransmit values (exponential backoff) */
 
@@ -802,6 +803,8 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 	struct os_reltime now;
 	struct hostapd_radius_server *rconf;
 	int invalid_authenticator = 0;
+	static struct metric *auth_rtt, *acct_rtt;
+	struct metric **rtt;
 
 	if (msg_type == RADIUS_ACCT) {
 		handlers = radius->acct_handlers;
@@ -888,6 +891,14 @@ static void radius_client_receive(int sock, void *eloop_ctx, void *sock_ctx)
 		       "request, round trip time %d.%02d sec",
 		       roundtrip / 100, roundtrip % 100);
 	rconf->round_trip_time = roundtrip;
+	rtt = msg_type == RADIUS_AUTH ? &auth_rtt : &acct_rtt;
+	if (!*rtt)
+		*rtt = metrics_get(msg_type == RADIUS_AUTH ?
+				   "radius.auth_rtt_ms" : "radius.acct_rtt_ms",
+				   METRIC_HISTOGRAM);
+	metrics_observe(*rtt,
+			(now.sec - req->last_attempt.sec) * 1000 +
+			(now.usec - req->last_attempt.usec) / 1000);
 
 	/* Remove ACKed RADIUS packet from retransmit list */
 	if (prev_req)
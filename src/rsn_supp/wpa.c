@@ -29,6 +29,39 @@
 static const u8 null_rsc[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
 
+/*
+ * Get an EAPOL-Key frame buffer with data_len octets of zeroed body from the
+ * per-state machine TX buffer. The IEEE 802.1X header is built by
+ * ctx->alloc_eapol() only when the buffer needs to grow.
+ */
+static u8 * wpa_sm_alloc_eapol_key(struct wpa_sm *sm, u16 data_len,
+				   size_t *msg_len, void **data_pos)
+{
+	struct ieee802_1x_hdr *hdr;
+
+	if (!sm->eapol_tx || sm->eapol_tx_size < sizeof(*hdr) + data_len) {
+		u8 *buf;
+		size_t buf_len;
+
+		buf = wpa_sm_alloc_eapol(sm, IEEE802_1X_TYPE_EAPOL_KEY, NULL,
+					 data_len, &buf_len, NULL);
+		if (!buf)
+			return NULL;
+		os_free(sm->eapol_tx);
+		sm->eapol_tx = buf;
+		sm->eapol_tx_size = buf_len;
+	}
+
+	hdr = (struct ieee802_1x_hdr *) sm->eapol_tx;
+	hdr->length = host_to_be16(data_len);
+	os_memset(hdr + 1, 0, data_len);
+	*msg_len = sizeof(*hdr) + data_len;
+	if (data_pos)
+		*data_pos = hdr + 1;
+	return sm->eapol_tx;
+}
+
+
 /**
  * wpa_eapol_key_send - Send WPA/RSN EAPOL-Key message
  * @sm: Pointer to WPA state machine data from wpa_sm_init()
@@ -138,7 +171,8 @@ int wpa_eapol_key_send(struct wpa_sm *sm, struct wpa_ptk *ptk,
 		wpa_hexdump(MSG_DEBUG, "WPA: Encrypted Key Data from SIV",
 			    key_data, AES_BLOCK_SIZE + key_data_len);
 
-		os_free(msg);
+		if (msg != sm->eapol_tx)
+			os_free(msg);
 		msg = buf;
 		msg_len = buf_len;
 #else /* CONFIG_FILS */
@@ -150,7 +184,8 @@ int wpa_eapol_key_send(struct wpa_sm *sm, struct wpa_ptk *ptk,
 	ret = wpa_sm_ether_send(sm, dest, proto, msg, msg_len);
 	eapol_sm_notify_tx_eapol_key(sm->eapol);
 out:
-	os_free(msg);
+	if (msg != sm->eapol_tx)
+		os_free(msg);
 	return ret;
 }
 
@@ -191,8 +226,7 @@ void wpa_sm_key_request(struct wpa_sm *sm, int error, int pairwise)
 
 	mic_len = wpa_mic_len(sm->key_mgmt);
 	hdrlen = sizeof(*reply) + mic_len + 2;
-	rbuf = wpa_sm_alloc_eapol(sm, IEEE802_1X_TYPE_EAPOL_KEY, NULL,
-				  hdrlen, &rlen, (void *) &reply);
+	rbuf = wpa_sm_alloc_eapol_key(sm, hdrlen, &rlen, (void *) &reply);
 	if (rbuf == NULL)
 		return;
 
@@ -409,10 +443,9 @@ int wpa_supplicant_send_2_of_4(struct wpa_sm *sm, const unsigned char *dst,
 			       const u8 *wpa_ie, size_t wpa_ie_len,
 			       struct wpa_ptk *ptk)
 {
-	size_t mic_len, hdrlen, rlen;
+	size_t mic_len, hdrlen, rlen, key_data_len;
 	struct wpa_eapol_key *reply;
-	u8 *rbuf, *key_mic;
-	u8 *rsn_ie_buf = NULL;
+	u8 *rbuf, *key_mic, *key_data;
 	u16 key_info;
 
 	if (wpa_ie == NULL) {
@@ -421,47 +454,49 @@ int wpa_supplicant_send_2_of_4(struct wpa_sm *sm, const unsigned char *dst,
 		return -1;
 	}
 
+	key_data_len = wpa_ie_len;
 #ifdef CONFIG_IEEE80211R
-	if (wpa_key_mgmt_ft(sm->key_mgmt)) {
-		int res;
+	if (wpa_key_mgmt_ft(sm->key_mgmt))
+		key_data_len += 2 + 2 + PMKID_LEN + sm->assoc_resp_ies_len;
+#endif /* CONFIG_IEEE80211R */
 
+	mic_len = wpa_mic_len(sm->key_mgmt);
+	hdrlen = sizeof(*reply) + mic_len + 2;
+	rbuf = wpa_sm_alloc_eapol_key(sm, hdrlen + key_data_len,
+				      &rlen, (void *) &reply);
+	if (rbuf == NULL)
+		return -1;
+
+	key_mic = (u8 *) (reply + 1);
+	key_data = key_mic + mic_len + 2;
+	os_memcpy(key_data, wpa_ie, wpa_ie_len);
+	key_data_len = wpa_ie_len;
+
+#ifdef CONFIG_IEEE80211R
+	if (wpa_key_mgmt_ft(sm->key_mgmt)) {
 		/*
 		 * Add PMKR1Name into RSN IE (PMKID-List) and add MDIE and
 		 * FTIE from (Re)Association Response.
 		 */
-		rsn_ie_buf = os_malloc(wpa_ie_len + 2 + 2 + PMKID_LEN +
-				       sm->assoc_resp_ies_len);
-		if (rsn_ie_buf == NULL)
-			return -1;
-		os_memcpy(rsn_ie_buf, wpa_ie, wpa_ie_len);
-		res = wpa_insert_pmkid(rsn_ie_buf, &wpa_ie_len,
-				       sm->pmk_r1_name);
-		if (res < 0) {
-			os_free(rsn_ie_buf);
+		if (wpa_insert_pmkid(key_data, &key_data_len,
+				     sm->pmk_r1_name) < 0)
 			return -1;
-		}
 
 		if (sm->assoc_resp_ies) {
-			os_memcpy(rsn_ie_buf + wpa_ie_len, sm->assoc_resp_ies,
+			os_memcpy(key_data + key_data_len, sm->assoc_resp_ies,
 				  sm->assoc_resp_ies_len);
-			wpa_ie_len += sm->assoc_resp_ies_len;
+			key_data_len += sm->assoc_resp_ies_len;
 		}
 
-		wpa_ie = rsn_ie_buf;
+		/* Trim the frame to the actual Key Data length */
+		rlen = sizeof(struct ieee802_1x_hdr) + hdrlen + key_data_len;
+		((struct ieee802_1x_hdr *) rbuf)->length =
+			host_to_be16(hdrlen + key_data_len);
 	}
 #endif /* CONFIG_IEEE80211R */
 
-	wpa_hexdump(MSG_DEBUG, "WPA: WPA IE for msg 2/4", wpa_ie, wpa_ie_len);
-
-	mic_len = wpa_mic_len(sm->key_mgmt);
-	hdrlen = sizeof(*reply) + mic_len + 2;
-	rbuf = wpa_sm_alloc_eapol(sm, IEEE802_1X_TYPE_EAPOL_KEY,
-				  NULL, hdrlen + wpa_ie_len,
-				  &rlen, (void *) &reply);
-	if (rbuf == NULL) {
-		os_free(rsn_ie_buf);
-		return -1;
-	}
+	wpa_hexdump(MSG_DEBUG, "WPA: WPA IE for msg 2/4",
+		    key_data, key_data_len);
 
 	reply->type = (sm->proto == WPA_PROTO_RSN ||
 		       sm->proto == WPA_PROTO_OSEN) ?
@@ -481,10 +516,7 @@ int wpa_supplicant_send_2_of_4(struct wpa_sm *sm, const unsigned char *dst,
 	wpa_hexdump(MSG_DEBUG, "WPA: Replay Counter", reply->replay_counter,
 		    WPA_REPLAY_COUNTER_LEN);
 
-	key_mic = (u8 *) (reply + 1);
-	WPA_PUT_BE16(key_mic + mic_len, wpa_ie_len); /* Key Data Length */
-	os_memcpy(key_mic + mic_len + 2, wpa_ie, wpa_ie_len); /* Key Data */
-	os_free(rsn_ie_buf);
+	WPA_PUT_BE16(key_mic + mic_len, key_data_len); /* Key Data Length */
 
 	os_memcpy(reply->key_nonce, nonce, WPA_NONCE_LEN);
 
@@ -1219,8 +1251,7 @@ int wpa_supplicant_send_4_of_4(struct wpa_sm *sm, const unsigned char *dst,
 
 	mic_len = wpa_mic_len(sm->key_mgmt);
 	hdrlen = sizeof(*reply) + mic_len + 2;
-	rbuf = wpa_sm_alloc_eapol(sm, IEEE802_1X_TYPE_EAPOL_KEY, NULL,
-				  hdrlen, &rlen, (void *) &reply);
+	rbuf = wpa_sm_alloc_eapol_key(sm, hdrlen, &rlen, (void *) &reply);
 	if (rbuf == NULL)
 		return -1;
 
@@ -1527,8 +1558,7 @@ static int wpa_supplicant_send_2_of_2(struct wpa_sm *sm,
 
 	mic_len = wpa_mic_len(sm->key_mgmt);
 	hdrlen = sizeof(*reply) + mic_len + 2;
-	rbuf = wpa_sm_alloc_eapol(sm, IEEE802_1X_TYPE_EAPOL_KEY, NULL,
-				  hdrlen, &rlen, (void *) &reply);
+	rbuf = wpa_sm_alloc_eapol_key(sm, hdrlen, &rlen, (void *) &reply);
 	if (rbuf == NULL)
 		return -1;
 
@@ -1719,7 +1749,6 @@ static int wpa_supplicant_decrypt_key_data(struct wpa_sm *sm,
 		   ver == WPA_KEY_INFO_TYPE_AES_128_CMAC ||
 		   sm->key_mgmt == WPA_KEY_MGMT_OSEN ||
 		   wpa_key_mgmt_suite_b(sm->key_mgmt)) {
-		u8 *buf;
 		if (*key_data_len < 8 || *key_data_len % 8) {
 			wpa_msg(sm->ctx->msg_ctx, MSG_WARNING,
 				"WPA: Unsupported AES-WRAP len %u",
@@ -1727,22 +1756,13 @@ static int wpa_supplicant_decrypt_key_data(struct wpa_sm *sm,
 			return -1;
 		}
 		*key_data_len -= 8; /* AES-WRAP adds 8 bytes */
-		buf = os_malloc(*key_data_len);
-		if (buf == NULL) {
-			wpa_msg(sm->ctx->msg_ctx, MSG_WARNING,
-				"WPA: No memory for AES-UNWRAP buffer");
-			return -1;
-		}
 		if (aes_unwrap(sm->ptk.kek, sm->ptk.kek_len, *key_data_len / 8,
-			       key_data, buf)) {
-			bin_clear_free(buf, *key_data_len);
+			       key_data, key_data)) {
 			wpa_msg(sm->ctx->msg_ctx, MSG_WARNING,
 				"WPA: AES unwrap failed - "
 				"could not decrypt EAPOL-Key key data");
 			return -1;
 		}
-		os_memcpy(key_data, buf, *key_data_len);
-		bin_clear_free(buf, *key_data_len);
 		WPA_PUT_BE16(((u8 *) (key + 1)) + mic_len, *key_data_len);
 	} else {
 		wpa_msg(sm->ctx->msg_ctx, MSG_WARNING,
@@ -1955,9 +1975,15 @@ int wpa_sm_rx_eapol(struct wpa_sm *sm, const u8 *src_addr,
 
 	/*
 	 * Make a copy of the frame since we need to modify the buffer during
-	 * MAC validation and Key Data decryption.
+	 * MAC validation and Key Data decryption. The copy buffer is reused
+	 * for following frames.
 	 */
-	tmp = os_malloc(data_len);
+	if (!sm->eapol_rx || sm->eapol_rx_size < data_len) {
+		bin_clear_free(sm->eapol_rx, sm->eapol_rx_size);
+		sm->eapol_rx = os_malloc(data_len);
+		sm->eapol_rx_size = sm->eapol_rx ? data_len : 0;
+	}
+	tmp = sm->eapol_rx;
 	if (tmp == NULL)
 		goto out;
 	os_memcpy(tmp, buf, data_len);
@@ -2203,7 +2229,8 @@ int wpa_sm_rx_eapol(struct wpa_sm *sm, const u8 *src_addr,
 	ret = 1;
 
 out:
-	bin_clear_free(tmp, data_len);
+	if (tmp)
+		os_memset(tmp, 0, data_len);
 	return ret;
 }
 
@@ -2425,6 +2452,8 @@ void wpa_sm_deinit(struct wpa_sm *sm)
 	os_free(sm->assoc_wpa_ie);
 	os_free(sm->ap_wpa_ie);
 	os_free(sm->ap_rsn_ie);
+	os_free(sm->eapol_tx);
+	bin_clear_free(sm->eapol_rx, sm->eapol_rx_size);
 	wpa_sm_drop_sa(sm);
 	os_free(sm->ctx);
 	peerkey_deinit(sm);
@@ -2623,6 +2652,11 @@ void wpa_sm_set_config(struct wpa_sm *sm, struct rsn_supp_config *config)
 	if (!sm)
 		return;
 
+	/* Build a new IEEE 802.1X header for the next EAPOL-Key frame */
+	os_free(sm->eapol_tx);
+	sm->eapol_tx = NULL;
+	sm->eapol_tx_size = 0;
+
 	if (config) {
 		sm->network_ctx = config->network_ctx;
 		sm->peerkey_enabled = config->peerkey_enabled;
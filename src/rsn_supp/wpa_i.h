@@ -34,6 +34,15 @@ struct wpa_sm {
 
 	struct eapol_sm *eapol; /* EAPOL state machine from upper level code */
 
+	/*
+	 * Buffers for building transmitted and processing received EAPOL-Key
+	 * frames. These are reused for all frames and grown as needed.
+	 */
+	u8 *eapol_tx; /* starting from IEEE 802.1X header */
+	size_t eapol_tx_size;
+	u8 *eapol_rx; /* starting from IEEE 802.1X header */
+	size_t eapol_rx_size;
+
 	struct rsn_pmksa_cache *pmksa; /* PMKSA cache */
 	struct rsn_pmksa_cache_entry *cur_pmksa; /* current PMKSA entry */
 	struct dl_list pmksa_candidates;
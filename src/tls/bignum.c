@@ -222,3 +222,36 @@ int bignum_exptmod(const struct bignum *a, const struct bignum *b,
 	}
 	return 0;
 }
+
+
+/**
+ * bignum_exptmod_ct - Modular exponentiation with a secret exponent
+ * @a: Bignum from bignum_init(); base
+ * @b: Bignum from bignum_init(); secret exponent
+ * @c: Bignum from bignum_init(); modulus
+ * @d: Bignum from bignum_init(); used to store the result of a^b (mod c)
+ * Returns: 0 on success, -1 on failure
+ *
+ * This is like bignum_exptmod(), but meant for secret exponents. With
+ * CONFIG_INTERNAL_LIBTOMMATH_CT (LTM_CT), a fixed window is used for odd
+ * moduli so that the sequence of operations, the operand lengths, and the
+ * memory accesses do not depend on the exponent value. This is a side-channel
+ * hardening trade-off: for full length exponents it is about 15% slower than
+ * bignum_exptmod() with CONFIG_INTERNAL_LIBTOMMATH_FAST. Without that option,
+ * it is faster since it uses Montgomery instead of Barrett reduction. Without
+ * LTM_CT, this is the same as bignum_exptmod().
+ */
+int bignum_exptmod_ct(const struct bignum *a, const struct bignum *b,
+		      const struct bignum *c, struct bignum *d)
+{
+#if defined(CONFIG_INTERNAL_LIBTOMMATH) && defined(LTM_CT)
+	if (mp_exptmod_ct((mp_int *) a, (mp_int *) b, (mp_int *) c,
+			  (mp_int *) d) != MP_OKAY) {
+		wpa_printf(MSG_DEBUG, "BIGNUM: %s failed", __func__);
+		return -1;
+	}
+	return 0;
+#else /* CONFIG_INTERNAL_LIBTOMMATH && LTM_CT */
+	return bignum_exptmod(a, b, c, d);
+#endif /* CONFIG_INTERNAL_LIBTOMMATH && LTM_CT */
+}
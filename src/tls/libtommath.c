@@ -53,6 +53,16 @@
 #define BN_MP_ABS_C
 #endif /* LTM_FAST */
 
+#ifdef LTM_CT
+/* Fixed window exponentiation for secret exponents (mp_exptmod_ct()) at the
+ * cost of about 2.5 kB in code; it needs the Montgomery reduction routines
+ * even without LTM_FAST */
+#define BN_MP_MONTGOMERY_SETUP_C
+#define BN_FAST_MP_MONTGOMERY_REDUCE_C
+#define BN_MP_MONTGOMERY_CALC_NORMALIZATION_C
+#define BN_MP_MUL_2_C
+#endif /* LTM_CT */
+
 /* Current uses do not require support for negative exponent in exptmod, so we
  * can save about 1.5 kB in leaving out invmod. */
 #define LTM_NO_NEG_EXP
@@ -186,6 +196,9 @@ static int mp_init_size(mp_int * a, int size);
 #ifdef BN_MP_EXPTMOD_FAST_C
 static int mp_exptmod_fast (mp_int * G, mp_int * X, mp_int * P, mp_int * Y, int redmode);
 #endif /* BN_MP_EXPTMOD_FAST_C */
+#ifdef LTM_CT
+static int mp_exptmod_ct (mp_int * G, mp_int * X, mp_int * P, mp_int * Y);
+#endif /* LTM_CT */
 #ifdef BN_FAST_S_MP_SQR_C
 static int fast_s_mp_sqr (mp_int * a, mp_int * b);
 #endif /* BN_FAST_S_MP_SQR_C */
@@ -2696,8 +2709,11 @@ mp_montgomery_setup (mp_int * n, mp_digit * rho)
  * reduction.
  *
  * Based on Algorithm 14.32 on pp.601 of HAC.
+ *
+ * The final subtraction is left to the caller; the result is less than 2*n
+ * and has n->used + 1 digits (not clamped).
 */
-static int fast_mp_montgomery_reduce (mp_int * x, mp_int * n, mp_digit rho)
+static int fast_mp_montgomery_redc (mp_int * x, mp_int * n, mp_digit rho)
 {
   int     ix, res, olduse;
   mp_word W[MP_WARRAY];
@@ -2829,8 +2845,21 @@ static int fast_mp_montgomery_reduce (mp_int * x, mp_int * n, mp_digit rho)
     }
   }
 
-  /* set the max used and clamp */
+  /* set the max used */
   x->used = n->used + 1;
+  return MP_OKAY;
+}
+
+
+#ifdef BN_MP_EXPTMOD_FAST_C
+/* computes xR**-1 == x (mod N) via Montgomery Reduction */
+static int fast_mp_montgomery_reduce (mp_int * x, mp_int * n, mp_digit rho)
+{
+  int res;
+
+  if ((res = fast_mp_montgomery_redc (x, n, rho)) != MP_OKAY) {
+    return res;
+  }
   mp_clamp (x);
 
   /* if A >= m then A = A - m */
@@ -2839,6 +2868,7 @@ static int fast_mp_montgomery_reduce (mp_int * x, mp_int * n, mp_digit rho)
   }
   return MP_OKAY;
 }
+#endif /* BN_MP_EXPTMOD_FAST_C */
 #endif
 
 
@@ -3398,3 +3428,195 @@ mp_mul_d (mp_int * a, mp_digit b, mp_int * c)
   return MP_OKAY;
 }
 #endif
+
+
+#ifdef LTM_CT
+/* Fixed window exponentiation for secret exponents (not from LibTomMath).
+ *
+ * Unlike s_mp_exptmod() and mp_exptmod_fast(), the sequence of squarings and
+ * multiplications depends only on the sizes of P and X, the table entry for
+ * each window is selected without exponent dependent memory accesses, and
+ * the operands of every multiplication are kept at the full length of P.
+ * The conditional subtraction at the end of the Montgomery reduction is done
+ * with a mask. Only odd moduli are supported this way; others use
+ * mp_exptmod().
+ *
+ * This is a side-channel hardening measure, not a speedup: every window costs
+ * a multiplication and a scan over the whole table, while the sliding window
+ * in mp_exptmod_fast() skips zero bits and uses larger windows.
+ */
+#define MP_CT_WINSIZE_MAX 5
+
+/* Montgomery reduction leaving a result of exactly n->used digits; the
+ * final subtraction does not depend on the value of x */
+static int mp_ct_montgomery_reduce (mp_int * x, mp_int * n, mp_digit rho)
+{
+  mp_digit borrow, mask, t;
+  int      err, i, used = n->used;
+
+  if ((err = fast_mp_montgomery_redc (x, n, rho)) != MP_OKAY) {
+    return err;
+  }
+
+  /* x < 2*n, so x - n borrows exactly when x < n */
+  borrow = 0;
+  for (i = 0; i < used; i++) {
+    t = x->dp[i] - n->dp[i] - borrow;
+    borrow = t >> ((mp_digit)(CHAR_BIT * sizeof (mp_digit) - 1));
+  }
+  t = x->dp[used] - borrow;
+  borrow = t >> ((mp_digit)(CHAR_BIT * sizeof (mp_digit) - 1));
+
+  /* x = x - n unless that borrowed */
+  mask = borrow - 1;
+  borrow = 0;
+  for (i = 0; i < used; i++) {
+    t = x->dp[i] - n->dp[i] - borrow;
+    borrow = t >> ((mp_digit)(CHAR_BIT * sizeof (mp_digit) - 1));
+    x->dp[i] = (x->dp[i] & ~mask) | (t & MP_MASK & mask);
+  }
+  x->dp[used] = 0;
+  x->used = used;
+  return MP_OKAY;
+}
+
+static int mp_exptmod_ct (mp_int * G, mp_int * X, mp_int * P, mp_int * Y)
+{
+  mp_int   M[1 << MP_CT_WINSIZE_MAX], res, sel;
+  mp_digit *tab, mask, mp;
+  int      err, x, y, n, bits, bitidx, win, winsize, tabsize;
+
+  if (P->sign == MP_NEG || X->sign == MP_NEG || P->used == 0) {
+    return MP_VAL;
+  }
+  n = P->used;
+
+  /* same limits as for the Comba based reduction in mp_exptmod_fast() */
+  if (mp_iseven (P) == MP_YES || (n * 2 + 1) >= MP_WARRAY ||
+      n >= (1 << ((CHAR_BIT * sizeof (mp_word)) - (2 * DIGIT_BIT)))) {
+    return mp_exptmod (G, X, P, Y);
+  }
+
+  /* Process as many exponent bits as P has (X < P for DH private keys and
+   * RSA CRT exponents); only a longer X extends this. Both depend only on
+   * the lengths, not on the value of X. */
+  bits = mp_count_bits (P);
+  if (X->used > n ||
+      (X->used == n && (X->dp[n - 1] >> (((bits - 1) % DIGIT_BIT) + 1)))) {
+    bits = X->used * DIGIT_BIT;
+  }
+
+  /* The larger table pays off only with enough windows to amortize the
+   * additional precomputation and table scan cost */
+  winsize = bits > 1024 ? MP_CT_WINSIZE_MAX : 4;
+  tabsize = 1 << winsize;
+
+  for (x = 0; x < tabsize; x++) {
+    if ((err = mp_init_size (&M[x], n * 2 + 1)) != MP_OKAY) {
+      for (y = 0; y < x; y++) {
+        mp_clear (&M[y]);
+      }
+      return err;
+    }
+  }
+  if ((err = mp_init_size (&res, n * 2 + 1)) != MP_OKAY) {
+    goto LBL_M;
+  }
+  if ((err = mp_init_size (&sel, n)) != MP_OKAY) {
+    goto LBL_RES;
+  }
+  tab = XMALLOC (sizeof (mp_digit) * n * tabsize);
+  if (tab == NULL) {
+    err = MP_MEM;
+    goto LBL_SEL;
+  }
+
+  /* M[x] = G**x in the Montgomery representation */
+  if ((err = mp_montgomery_setup (P, &mp)) != MP_OKAY ||
+      (err = mp_montgomery_calc_normalization (&M[0], P)) != MP_OKAY ||
+      (err = mp_mulmod (G, &M[0], P, &M[1])) != MP_OKAY) {
+    goto LBL_TAB;
+  }
+  for (x = 2; x < tabsize; x++) {
+    if ((err = mp_mul (&M[x - 1], &M[1], &M[x])) != MP_OKAY ||
+        (err = mp_ct_montgomery_reduce (&M[x], P, mp)) != MP_OKAY) {
+      goto LBL_TAB;
+    }
+  }
+
+  /* flat copy of the table with every entry zero padded to n digits */
+  for (x = 0; x < tabsize; x++) {
+    for (y = 0; y < n; y++) {
+      tab[x * n + y] = y < M[x].used ? M[x].dp[y] : 0;
+    }
+  }
+
+  /* res = M[0] padded to n digits (the digits above used are zero) */
+  if ((err = mp_copy (&M[0], &res)) != MP_OKAY) {
+    goto LBL_TAB;
+  }
+  res.used = n;
+
+  bitidx = ((bits + winsize - 1) / winsize) * winsize;
+  while (bitidx > 0) {
+    bitidx -= winsize;
+
+    for (x = 0; x < winsize; x++) {
+      if ((err = mp_sqr (&res, &res)) != MP_OKAY ||
+          (err = mp_ct_montgomery_reduce (&res, P, mp)) != MP_OKAY) {
+        goto LBL_TAB;
+      }
+    }
+
+    /* a window may cross a digit boundary */
+    win = 0;
+    for (x = winsize - 1; x >= 0; x--) {
+      y = (bitidx + x) / DIGIT_BIT;
+      win = (win << 1) |
+        (int) (((y < X->used ? X->dp[y] : 0) >> ((bitidx + x) % DIGIT_BIT)) &
+               1);
+    }
+
+    /* sel = M[win]; not clamped, so that the length of the multiplication
+     * does not depend on the selected entry */
+    for (y = 0; y < n; y++) {
+      sel.dp[y] = 0;
+    }
+    for (x = 0; x < tabsize; x++) {
+      mask = (mp_digit) 0 - (mp_digit) ((((unsigned int) (x ^ win)) - 1U) >>
+                                        (sizeof (unsigned int) * CHAR_BIT - 1));
+      for (y = 0; y < n; y++) {
+        sel.dp[y] |= tab[x * n + y] & mask;
+      }
+    }
+    sel.used = n;
+    sel.sign = MP_ZPOS;
+
+    if ((err = mp_mul (&res, &sel, &res)) != MP_OKAY ||
+        (err = mp_ct_montgomery_reduce (&res, P, mp)) != MP_OKAY) {
+      goto LBL_TAB;
+    }
+  }
+
+  /* convert back from the Montgomery representation */
+  if ((err = mp_ct_montgomery_reduce (&res, P, mp)) != MP_OKAY) {
+    goto LBL_TAB;
+  }
+  mp_clamp (&res);
+
+  mp_exch (&res, Y);
+  err = MP_OKAY;
+LBL_TAB:
+  for (x = 0; x < n * tabsize; x++) {
+    tab[x] = 0;
+  }
+  XFREE (tab);
+LBL_SEL:mp_clear (&sel);
+LBL_RES:mp_clear (&res);
+LBL_M:
+  for (x = 0; x < tabsize; x++) {
+    mp_clear (&M[x]);
+  }
+  return err;
+}
+#endif /* LTM_CT */
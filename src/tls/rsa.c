@@ -302,12 +302,17 @@ int crypto_rsa_exptmod(const u8 *in, size_t inlen, u8 *out, size_t *outlen,
 		if (a == NULL || b == NULL)
 			goto error;
 
+		/*
+		 * The CRT exponents are secret; bignum_exptmod_ct() can be
+		 * built to use a fixed window exponentiation for them.
+		 */
+
 		/* a = tmp^dmp1 mod p */
-		if (bignum_exptmod(tmp, key->dmp1, key->p, a) < 0)
+		if (bignum_exptmod_ct(tmp, key->dmp1, key->p, a) < 0)
 			goto error;
 
 		/* b = tmp^dmq1 mod q */
-		if (bignum_exptmod(tmp, key->dmq1, key->q, b) < 0)
+		if (bignum_exptmod_ct(tmp, key->dmq1, key->q, b) < 0)
 			goto error;
 
 		/* tmp = (a - b) * (1/q mod p) (mod p) */
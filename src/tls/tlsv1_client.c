@@ -141,8 +141,8 @@ u8 * tlsv1_client_handshake(struct tlsv1_client *conn,
 			    size_t *out_len, u8 **appl_data,
 			    size_t *appl_data_len, int *need_more_data)
 {
-	const u8 *pos, *end;
-	u8 *msg = NULL, *in_msg = NULL, *in_pos, *in_end, alert, ct;
+	const u8 *pos, *end, *in_pos, *in_end;
+	u8 *msg = NULL, *in_msg = NULL, alert, ct;
 	size_t in_msg_len;
 	int no_appl_data;
 	int used;
@@ -174,15 +174,26 @@ u8 * tlsv1_client_handshake(struct tlsv1_client *conn,
 
 	pos = in_data;
 	end = in_data + in_len;
-	in_msg = os_malloc(in_len);
-	if (in_msg == NULL)
-		return NULL;
 
 	/* Each received packet may include multiple records */
 	while (pos < end) {
-		in_msg_len = in_len;
-		used = tlsv1_record_receive(&conn->rl, pos, end - pos,
-					    in_msg, &in_msg_len, &alert);
+		/*
+		 * Records that are not protected are processed directly from
+		 * the input buffer; a separate buffer is needed only for
+		 * decrypted records.
+		 */
+		if (in_msg == NULL &&
+		    conn->rl.read_cipher_suite != TLS_NULL_WITH_NULL_NULL) {
+			in_msg = os_malloc(in_len);
+			if (in_msg == NULL) {
+				tls_alert(conn, TLS_ALERT_LEVEL_FATAL,
+					  TLS_ALERT_INTERNAL_ERROR);
+				goto failed;
+			}
+		}
+		used = tlsv1_record_receive_frag(&conn->rl, pos, end - pos,
+						 in_msg, in_len, &in_pos,
+						 &in_msg_len, &alert);
 		if (used < 0) {
 			wpa_printf(MSG_DEBUG, "TLSv1: Processing received "
 				   "record failed");
@@ -210,8 +221,7 @@ u8 * tlsv1_client_handshake(struct tlsv1_client *conn,
 		}
 		ct = pos[0];
 
-		in_pos = in_msg;
-		in_end = in_msg + in_msg_len;
+		in_end = in_pos + in_msg_len;
 
 		/* Each received record may include multiple messages of the
 		 * same ContentType. */
@@ -145,7 +145,9 @@ int tlsv1_record_change_read_cipher(struct tlsv1_record_layer *rl)
  * Returns: 0 on success, -1 on failure
  *
  * This function fills in the TLS record layer header, adds HMAC, and encrypts
- * the data using the current write cipher.
+ * the data using the current write cipher. The payload may already be within
+ * buf; the record is then protected in place and the payload is moved only if
+ * it is not at its final location after the header and explicit IV.
  */
 int tlsv1_record_send(struct tlsv1_record_layer *rl, u8 content_type, u8 *buf,
 		      size_t buf_size, const u8 *payload, size_t payload_len,
@@ -195,7 +197,9 @@ int tlsv1_record_send(struct tlsv1_record_layer *rl, u8 content_type, u8 *buf,
 	 */
 	if (pos + payload_len > buf + buf_size)
 		return -1;
-	os_memmove(pos, payload, payload_len);
+	if (pos != payload)
+		os_memmove(pos, payload, payload_len);
+	payload = pos;
 	pos += payload_len;
 
 	if (rl->write_cipher_suite != TLS_NULL_WITH_NULL_NULL) {
@@ -261,23 +265,27 @@ int tlsv1_record_send(struct tlsv1_record_layer *rl, u8 content_type, u8 *buf,
 
 
 /**
- * tlsv1_record_receive - TLS record layer: Process a received message
+ * tlsv1_record_receive_frag - TLS record layer: Process a received record
  * @rl: Pointer to TLS record layer data
  * @in_data: Received data
  * @in_len: Length of the received data
- * @out_data: Buffer for output data (must be at least as long as in_data)
- * @out_len: Set to maximum out_data length by caller; used to return the
- * length of the used data
+ * @buf: Buffer for decrypted data or %NULL if no read cipher is in use
+ * @buf_len: Length of buf (must be at least as long as the record)
+ * @out_data: Buffer for returning a pointer to the record fragment
+ * @out_len: Buffer for returning the length of the record fragment
  * @alert: Buffer for returning an alert value on failure
  * Returns: Number of bytes used from in_data on success, 0 if record was not
  *	complete (more data needed), or -1 on failure
  *
- * This function decrypts the received message, verifies HMAC and TLS record
- * layer header.
+ * This function verifies the TLS record layer header and, if a read cipher is
+ * in use, decrypts the record into buf and verifies HMAC. The fragment of a
+ * record that is not protected is returned as a pointer into in_data without
+ * copying it.
  */
-int tlsv1_record_receive(struct tlsv1_record_layer *rl,
-			 const u8 *in_data, size_t in_len,
-			 u8 *out_data, size_t *out_len, u8 *alert)
+int tlsv1_record_receive_frag(struct tlsv1_record_layer *rl,
+			      const u8 *in_data, size_t in_len,
+			      u8 *buf, size_t buf_len,
+			      const u8 **out_data, size_t *out_len, u8 *alert)
 {
 	size_t i, rlen, hlen;
 	u8 padlen;
@@ -345,23 +353,41 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 
 	in_len = rlen;
 
-	if (*out_len < in_len) {
-		wpa_printf(MSG_DEBUG, "TLSv1: Not enough output buffer for "
-			   "processing received record");
-		*alert = TLS_ALERT_INTERNAL_ERROR;
-		return -1;
-	}
-
 	if (rl->read_cipher_suite != TLS_NULL_WITH_NULL_NULL) {
-		size_t plen;
-		if (crypto_cipher_decrypt(rl->read_cbc, in_data,
-					  out_data, in_len) < 0) {
+		size_t plen, skip = 0;
+
+		if (buf == NULL || buf_len < in_len) {
+			wpa_printf(MSG_DEBUG, "TLSv1: Not enough output buffer "
+				   "for processing received record");
+			*alert = TLS_ALERT_INTERNAL_ERROR;
+			return -1;
+		}
+
+		if (rl->iv_size && rl->tls_version >= TLS_VERSION_1_1 &&
+		    in_len >= rl->iv_size) {
+			u8 iv[TLS_MAX_IV_LEN];
+
+			/*
+			 * Decrypt opaque IV[Cipherspec.block_length] separately
+			 * so that the data does not need to be moved after
+			 * decryption.
+			 */
+			if (crypto_cipher_decrypt(rl->read_cbc, in_data, iv,
+						  rl->iv_size) < 0) {
+				*alert = TLS_ALERT_DECRYPTION_FAILED;
+				return -1;
+			}
+			skip = rl->iv_size;
+		}
+
+		if (crypto_cipher_decrypt(rl->read_cbc, in_data + skip,
+					  buf, in_len - skip) < 0) {
 			*alert = TLS_ALERT_DECRYPTION_FAILED;
 			return -1;
 		}
-		plen = in_len;
+		plen = in_len - skip;
 		wpa_hexdump_key(MSG_MSGDUMP, "TLSv1: Record Layer - Decrypted "
-				"data", out_data, plen);
+				"data", buf, plen);
 
 		if (rl->iv_size) {
 			/*
@@ -375,17 +401,11 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 			 * attacks more difficult.
 			 */
 
-			if (rl->tls_version >= TLS_VERSION_1_1) {
-				/* Remove opaque IV[Cipherspec.block_length] */
-				if (plen < rl->iv_size) {
-					wpa_printf(MSG_DEBUG, "TLSv1.1: Not "
-						   "enough room for IV");
-					force_mac_error = 1;
-					goto check_mac;
-				}
-				os_memmove(out_data, out_data + rl->iv_size,
-					   plen - rl->iv_size);
-				plen -= rl->iv_size;
+			if (rl->tls_version >= TLS_VERSION_1_1 && !skip) {
+				wpa_printf(MSG_DEBUG, "TLSv1.1: Not enough "
+					   "room for IV");
+				force_mac_error = 1;
+				goto check_mac;
 			}
 
 			/* Verify and remove padding */
@@ -395,7 +415,7 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 				force_mac_error = 1;
 				goto check_mac;
 			}
-			padlen = out_data[plen - 1];
+			padlen = buf[plen - 1];
 			if (padlen >= plen) {
 				wpa_printf(MSG_DEBUG, "TLSv1: Incorrect pad "
 					   "length (%u, plen=%lu) in "
@@ -405,11 +425,11 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 				goto check_mac;
 			}
 			for (i = plen - padlen - 1; i < plen - 1; i++) {
-				if (out_data[i] != padlen) {
+				if (buf[i] != padlen) {
 					wpa_hexdump(MSG_DEBUG,
 						    "TLSv1: Invalid pad in "
 						    "received record",
-						    out_data + plen - padlen -
+						    buf + plen - padlen -
 						    1, padlen + 1);
 					force_mac_error = 1;
 					goto check_mac;
@@ -420,7 +440,7 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 
 			wpa_hexdump_key(MSG_MSGDUMP, "TLSv1: Record Layer - "
 					"Decrypted data with IV and padding "
-					"removed", out_data, plen);
+					"removed", buf, plen);
 		}
 
 	check_mac:
@@ -447,7 +467,7 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 		crypto_hash_update(hmac, in_data - TLS_RECORD_HEADER_LEN, 3);
 		WPA_PUT_BE16(len, plen);
 		crypto_hash_update(hmac, len, 2);
-		crypto_hash_update(hmac, out_data, plen);
+		crypto_hash_update(hmac, buf, plen);
 		hlen = sizeof(hash);
 		if (crypto_hash_finish(hmac, hash, &hlen) < 0) {
 			wpa_printf(MSG_DEBUG, "TLSv1: Record Layer - Failed "
@@ -456,7 +476,7 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 			return -1;
 		}
 		if (hlen != rl->hash_size ||
-		    os_memcmp_const(hash, out_data + plen, hlen) != 0 ||
+		    os_memcmp_const(hash, buf + plen, hlen) != 0 ||
 		    force_mac_error) {
 			wpa_printf(MSG_DEBUG, "TLSv1: Invalid HMAC value in "
 				   "received message (force_mac_error=%d)",
@@ -465,9 +485,10 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 			return -1;
 		}
 
+		*out_data = buf;
 		*out_len = plen;
 	} else {
-		os_memcpy(out_data, in_data, in_len);
+		*out_data = in_data;
 		*out_len = in_len;
 	}
 
@@ -483,3 +504,47 @@ int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 
 	return TLS_RECORD_HEADER_LEN + rlen;
 }
+
+
+/**
+ * tlsv1_record_receive - TLS record layer: Process a received message
+ * @rl: Pointer to TLS record layer data
+ * @in_data: Received data
+ * @in_len: Length of the received data
+ * @out_data: Buffer for output data (must be at least as long as in_data)
+ * @out_len: Set to maximum out_data length by caller; used to return the
+ * length of the used data
+ * @alert: Buffer for returning an alert value on failure
+ * Returns: Number of bytes used from in_data on success, 0 if record was not
+ *	complete (more data needed), or -1 on failure
+ *
+ * This function decrypts the received message, verifies HMAC and TLS record
+ * layer header.
+ */
+int tlsv1_record_receive(struct tlsv1_record_layer *rl,
+			 const u8 *in_data, size_t in_len,
+			 u8 *out_data, size_t *out_len, u8 *alert)
+{
+	const u8 *frag;
+	size_t frag_len;
+	int used;
+
+	used = tlsv1_record_receive_frag(rl, in_data, in_len,
+					 out_data, *out_len,
+					 &frag, &frag_len, alert);
+	if (used <= 0)
+		return used;
+
+	if (frag != out_data) {
+		if (*out_len < frag_len) {
+			wpa_printf(MSG_DEBUG, "TLSv1: Not enough output buffer "
+				   "for processing received record");
+			*alert = TLS_ALERT_INTERNAL_ERROR;
+			return -1;
+		}
+		os_memcpy(out_data, frag, frag_len);
+	}
+	*out_len = frag_len;
+
+	return used;
+}
@@ -64,6 +64,10 @@ int tlsv1_record_change_read_cipher(struct tlsv1_record_layer *rl);
 int tlsv1_record_send(struct tlsv1_record_layer *rl, u8 content_type, u8 *buf,
 		      size_t buf_size, const u8 *payload, size_t payload_len,
 		      size_t *out_len);
+int tlsv1_record_receive_frag(struct tlsv1_record_layer *rl,
+			      const u8 *in_data, size_t in_len,
+			      u8 *buf, size_t buf_len,
+			      const u8 **out_data, size_t *out_len, u8 *alert);
 int tlsv1_record_receive(struct tlsv1_record_layer *rl,
 			 const u8 *in_data, size_t in_len,
 			 u8 *out_data, size_t *out_len, u8 *alert);
@@ -10,6 +10,7 @@
 
 #include "common.h"
 #include "crypto/crypto.h"
+#include "crypto/sha256.h"
 #include "asn1.h"
 #include "x509v3.h"
 
@@ -1987,6 +1988,104 @@ skip_digest_oid:
 }
 
 
+/*
+ * Cache of issuer/certificate pairs for which the signature has already been
+ * verified. This allows the same chain to be validated again (e.g., on each
+ * EAP-TLS authentication) without repeating the public key operations. Entries
+ * are not used after either certificate has expired.
+ */
+#define X509_SIG_CACHE_SIZE 32
+
+struct x509_sig_cache_entry {
+	u8 cert_hash[SHA256_MAC_LEN];
+	u8 issuer_key_hash[SHA256_MAC_LEN];
+	os_time_t not_after;
+	int used;
+};
+
+static struct x509_sig_cache_entry x509_sig_cache[X509_SIG_CACHE_SIZE];
+static unsigned int x509_sig_cache_next;
+static unsigned int x509_sig_cache_hits, x509_sig_cache_misses;
+
+
+static int x509_sig_cache_key(struct x509_certificate *issuer,
+			      struct x509_certificate *cert,
+			      u8 *cert_hash, u8 *issuer_key_hash)
+{
+	const u8 *addr[1];
+	size_t len[1];
+
+	addr[0] = cert->cert_start;
+	len[0] = cert->cert_len;
+	if (sha256_vector(1, addr, len, cert_hash) < 0)
+		return -1;
+	addr[0] = issuer->public_key;
+	len[0] = issuer->public_key_len;
+	return sha256_vector(1, addr, len, issuer_key_hash);
+}
+
+
+static int x509_check_signature_cached(struct x509_certificate *issuer,
+				       struct x509_certificate *cert,
+				       struct os_time *now)
+{
+	u8 cert_hash[SHA256_MAC_LEN], issuer_key_hash[SHA256_MAC_LEN];
+	struct x509_sig_cache_entry *e;
+	int i, have_key;
+
+	have_key = x509_sig_cache_key(issuer, cert, cert_hash,
+				      issuer_key_hash) == 0;
+	for (i = 0; have_key && i < X509_SIG_CACHE_SIZE; i++) {
+		e = &x509_sig_cache[i];
+		if (!e->used)
+			continue;
+		if ((unsigned long) now->sec > (unsigned long) e->not_after) {
+			e->used = 0;
+			continue;
+		}
+		if (os_memcmp(e->cert_hash, cert_hash, SHA256_MAC_LEN) == 0 &&
+		    os_memcmp(e->issuer_key_hash, issuer_key_hash,
+			      SHA256_MAC_LEN) == 0) {
+			x509_sig_cache_hits++;
+			wpa_printf(MSG_DEBUG,
+				   "X509: Certificate signature verified earlier");
+			return 0;
+		}
+	}
+
+	x509_sig_cache_misses++;
+	if (x509_certificate_check_signature(issuer, cert) < 0)
+		return -1;
+
+	if (have_key) {
+		e = &x509_sig_cache[x509_sig_cache_next];
+		x509_sig_cache_next = (x509_sig_cache_next + 1) %
+			X509_SIG_CACHE_SIZE;
+		os_memcpy(e->cert_hash, cert_hash, SHA256_MAC_LEN);
+		os_memcpy(e->issuer_key_hash, issuer_key_hash, SHA256_MAC_LEN);
+		e->not_after = cert->not_after;
+		if ((unsigned long) issuer->not_after <
+		    (unsigned long) e->not_after)
+			e->not_after = issuer->not_after;
+		e->used = 1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * x509_sig_cache_stats - Get certificate signature cache statistics
+ * @hits: Buffer for returning the number of signatures found in the cache
+ * @misses: Buffer for returning the number of verified signatures
+ */
+void x509_sig_cache_stats(unsigned int *hits, unsigned int *misses)
+{
+	*hits = x509_sig_cache_hits;
+	*misses = x509_sig_cache_misses;
+}
+
+
 static int x509_valid_issuer(const struct x509_certificate *cert)
 {
 	if ((cert->extensions_present & X509_EXT_BASIC_CONSTRAINTS) &&
@@ -2090,8 +2189,8 @@ int x509_certificate_chain_validate(struct x509_certificate *trusted,
 				return -1;
 			}
 
-			if (x509_certificate_check_signature(cert->next, cert)
-			    < 0) {
+			if (x509_check_signature_cached(cert->next, cert,
+							&now) < 0) {
 				wpa_printf(MSG_DEBUG, "X509: Invalid "
 					   "certificate signature within "
 					   "chain");
@@ -2114,7 +2213,7 @@ int x509_certificate_chain_validate(struct x509_certificate *trusted,
 				return -1;
 			}
 
-			if (x509_certificate_check_signature(trust, cert) < 0)
+			if (x509_check_signature_cached(trust, cert, &now) < 0)
 			{
 				wpa_printf(MSG_DEBUG, "X509: Invalid "
 					   "certificate signature");
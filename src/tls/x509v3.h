@@ -141,6 +141,7 @@ int x509_check_signature(struct x509_certificate *issuer,
 			 const u8 *signed_data, size_t signed_data_len);
 int x509_certificate_check_signature(struct x509_certificate *issuer,
 				     struct x509_certificate *cert);
+void x509_sig_cache_stats(unsigned int *hits, unsigned int *misses);
 int x509_certificate_chain_validate(struct x509_certificate *trusted,
 				    struct x509_certificate *chain,
 				    int *reason, int disable_time_checks);
@@ -114,6 +114,21 @@ struct eloop_data {
 
 static struct eloop_data eloop;
 
+/*
+ * Maximum number of expired timeouts to process per eloop_run() round. This
+ * bounds the extra delay that a burst of expiring timers (e.g., STA inactivity
+ * timers of a large BSS, or a handler that keeps re-registering itself with
+ * zero delay) can add to socket processing to the run time of this many
+ * handlers. Timer handlers are short, so 16 keeps the socket latency within
+ * the same order as a single socket dispatch round while still draining
+ * typical bursts in one round. Setting this to 1 restores the previous
+ * behavior of one timeout per round. Can be changed at build time with
+ * CONFIG_ELOOP_MAX_TIMEOUTS_PER_ROUND.
+ */
+#ifndef ELOOP_MAX_TIMEOUTS_PER_ROUND
+#define ELOOP_MAX_TIMEOUTS_PER_ROUND 16
+#endif /* ELOOP_MAX_TIMEOUTS_PER_ROUND */
+
 
 #ifdef WPA_TRACE
 
@@ -1069,7 +1084,7 @@ void eloop_run(void)
 #ifdef CONFIG_ELOOP_KQUEUE
 	struct timespec ts;
 #endif /* CONFIG_ELOOP_KQUEUE */
-	int res;
+	int res, expired;
 	struct os_reltime tv, now;
 
 #ifdef CONFIG_ELOOP_SELECT
@@ -1177,20 +1192,28 @@ void eloop_run(void)
 		eloop_process_pending_signals();
 
 
-		/* check if some registered timeouts have occurred */
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
-					list);
-		if (timeout) {
-			os_get_reltime(&now);
-			if (!os_reltime_before(&now, &timeout->time)) {
-				void *eloop_data = timeout->eloop_data;
-				void *user_data = timeout->user_data;
-				eloop_timeout_handler handler =
-					timeout->handler;
-				eloop_remove_timeout(timeout);
-				handler(eloop_data, user_data);
-			}
-
+		/*
+		 * Check if some registered timeouts have occurred. All
+		 * timeouts that had expired by now are processed in this
+		 * round (up to a limit to avoid starving the sockets) instead
+		 * of just the first one, so that a busy socket does not delay
+		 * timers by one socket dispatch round per expired timeout.
+		 */
+		os_get_reltime(&now);
+		for (expired = 0; expired < ELOOP_MAX_TIMEOUTS_PER_ROUND &&
+			     !eloop.terminate; expired++) {
+			void *eloop_data, *user_data;
+			eloop_timeout_handler handler;
+
+			timeout = dl_list_first(&eloop.timeout,
+						struct eloop_timeout, list);
+			if (!timeout || os_reltime_before(&now, &timeout->time))
+				break;
+			eloop_data = timeout->eloop_data;
+			user_data = timeout->user_data;
+			handler = timeout->handler;
+			eloop_remove_timeout(timeout);
+			handler(eloop_data, user_data);
 		}
 
 		if (res <= 0)
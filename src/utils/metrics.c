@@ -0,0 +1,161 @@
+/*
+ * Metrics registry
+ * Copyright (c) 2017, Jouni Malinen <j@w1.fi>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+#ifndef CONFIG_NATIVE_WINDOWS
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif /* CONFIG_NATIVE_WINDOWS */
+
+#include "common.h"
+#include "metrics.h"
+
+
+static struct metrics_table *metrics;
+static int metrics_mapped;
+
+
+/**
+ * metrics_init - Initialize the metrics registry
+ * @fname: File to map the metrics table into or %NULL to keep it in memory
+ * Returns: 0 on success, -1 on failure
+ *
+ * Until this is called, metrics_get() returns %NULL and all updates are
+ * ignored.
+ */
+int metrics_init(const char *fname)
+{
+	if (metrics)
+		return 0;
+
+#ifndef CONFIG_NATIVE_WINDOWS
+	if (fname) {
+		int fd;
+		void *map;
+
+		/*
+		 * The file is typically in a world-writable directory like
+		 * /dev/shm, so do not follow or reuse a file someone else may
+		 * have placed there; always create a new one.
+		 */
+		if (unlink(fname) < 0 && errno != ENOENT) {
+			wpa_printf(MSG_ERROR, "metrics: unlink(%s): %s",
+				   fname, strerror(errno));
+			return -1;
+		}
+		fd = open(fname, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW, 0644);
+		if (fd < 0) {
+			wpa_printf(MSG_ERROR, "metrics: open(%s): %s",
+				   fname, strerror(errno));
+			return -1;
+		}
+		if (ftruncate(fd, sizeof(*metrics)) < 0) {
+			wpa_printf(MSG_ERROR, "metrics: ftruncate(%s): %s",
+				   fname, strerror(errno));
+			close(fd);
+			return -1;
+		}
+		map = mmap(NULL, sizeof(*metrics), PROT_READ | PROT_WRITE,
+			   MAP_SHARED, fd, 0);
+		close(fd);
+		if (map == MAP_FAILED) {
+			wpa_printf(MSG_ERROR, "metrics: mmap(%s): %s",
+				   fname, strerror(errno));
+			return -1;
+		}
+		metrics = map;
+		metrics_mapped = 1;
+		/* ftruncate() filled the new file with zeros */
+	}
+#endif /* CONFIG_NATIVE_WINDOWS */
+
+	if (!metrics) {
+		metrics = os_zalloc(sizeof(*metrics));
+		if (!metrics)
+			return -1;
+	}
+
+	metrics->version = METRICS_VERSION;
+	metrics->max = METRICS_MAX;
+	metrics->num = 0;
+	metrics->magic = METRICS_MAGIC;
+
+	return 0;
+}
+
+
+void metrics_deinit(void)
+{
+	if (!metrics)
+		return;
+#ifndef CONFIG_NATIVE_WINDOWS
+	if (metrics_mapped) {
+		munmap(metrics, sizeof(*metrics));
+		metrics_mapped = 0;
+		metrics = NULL;
+		return;
+	}
+#endif /* CONFIG_NATIVE_WINDOWS */
+	os_free(metrics);
+	metrics = NULL;
+}
+
+
+/**
+ * metrics_get - Find or register a metric
+ * @name: Metric name
+ * @type: Metric type
+ * Returns: Pointer to the metric or %NULL if the registry is not in use, the
+ * table is full, or the name is already used for another type
+ *
+ * The returned pointer remains valid until metrics_deinit() and can be
+ * stored by the caller to avoid repeated lookups. All update functions accept
+ * %NULL and do nothing in that case.
+ */
+struct metric * metrics_get(const char *name, enum metric_type type)
+{
+	struct metric *m;
+	u32 i;
+
+	if (!metrics)
+		return NULL;
+
+	for (i = 0; i < metrics->num; i++) {
+		m = &metrics->metrics[i];
+		if (os_strncmp(m->name, name, METRICS_NAME_LEN) == 0)
+			return m->type == (u32) type ? m : NULL;
+	}
+
+	if (metrics->num == METRICS_MAX) {
+		wpa_printf(MSG_DEBUG, "metrics: No room for %s", name);
+		return NULL;
+	}
+
+	m = &metrics->metrics[metrics->num];
+	os_memset(m, 0, sizeof(*m));
+	os_strlcpy(m->name, name, METRICS_NAME_LEN);
+	m->type = type;
+	metrics->num++;
+
+	return m;
+}
+
+
+void metrics_observe(struct metric *m, u64 val)
+{
+	unsigned int bucket = 0;
+
+	if (!m)
+		return;
+
+	while (val >> bucket && bucket < METRICS_HIST_BUCKETS - 1)
+		bucket++;
+	m->hist[bucket]++;
+	m->sum += val;
+	m->value++;
+}
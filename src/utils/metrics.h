@@ -0,0 +1,73 @@
+/*
+ * Metrics registry
+ * Copyright (c) 2017, Jouni Malinen <j@w1.fi>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+/*
+ * All metrics live in a single fixed-size table. When a file name is given to
+ * metrics_init(), the table is a shared file mapping (e.g., under /dev/shm) so
+ * that an external exporter can read the values directly without going
+ * through the control interface. The process has a single writer thread, so
+ * values are updated with plain stores. A reader may see a histogram in the
+ * middle of an update and, on targets without atomic 64-bit stores, a torn
+ * value; such a reader needs to read a value twice and retry if it changed.
+ */
+
+#define METRICS_MAGIC 0x4d545243 /* "MTRC" */
+#define METRICS_VERSION 1
+#define METRICS_MAX 256
+#define METRICS_NAME_LEN 48
+
+/*
+ * Histogram buckets: bucket 0 is < 1 and bucket i (i > 0) covers
+ * [2^(i-1), 2^i) with the last bucket covering everything larger.
+ */
+#define METRICS_HIST_BUCKETS 16
+
+enum metric_type {
+	METRIC_COUNTER = 1,
+	METRIC_GAUGE = 2,
+	METRIC_HISTOGRAM = 3,
+};
+
+struct metric {
+	char name[METRICS_NAME_LEN];
+	u32 type; /* enum metric_type */
+	u32 reserved;
+	u64 value; /* counter/gauge value or number of histogram samples */
+	u64 sum; /* sum of histogram samples */
+	u64 hist[METRICS_HIST_BUCKETS];
+};
+
+struct metrics_table {
+	u32 magic;
+	u32 version;
+	u32 max;
+	u32 num; /* updated after a new entry has been fully initialized */
+	struct metric metrics[METRICS_MAX];
+};
+
+int metrics_init(const char *fname);
+void metrics_deinit(void);
+struct metric * metrics_get(const char *name, enum metric_type type);
+void metrics_observe(struct metric *m, u64 val);
+
+static inline void metrics_inc(struct metric *m)
+{
+	if (m)
+		m->value++;
+}
+
+static inline void metrics_set(struct metric *m, u64 val)
+{
+	if (m)
+		m->value = val;
+}
+
+#endif /* METRICS_H */
@@ -43,6 +43,7 @@
 #define HTTPREAD_READBUF_SIZE 1024      /* read in chunks of this size */
 #define HTTPREAD_HEADER_MAX_SIZE 4096   /* max allowed for headers */
 #define HTTPREAD_BODYBUF_DELTA 4096     /* increase allocation by this */
+#define HTTPREAD_HEADER_MAX_LINES 32    /* header lines indexed for lookup */
 
 
 /* control instance -- actual definition (opaque to application)
@@ -61,6 +62,11 @@ struct httpread {
 	int got_hdr;            /* nonzero when header is finalized */
 	char hdr[HTTPREAD_HEADER_MAX_SIZE+1];   /* headers stored here */
 	int hdr_nbytes;
+	/* offsets of the option lines within hdr (first line excluded);
+	 * lines past HTTPREAD_HEADER_MAX_LINES are found by scanning */
+	int hdr_line_offset[HTTPREAD_HEADER_MAX_LINES];
+	int hdr_nlines;
+	int hdr_lines_end;      /* offset of the terminating empty line */
 
 	enum httpread_hdr_type hdr_type;
 	int version;            /* 1 if we've seen 1.1 */
@@ -117,6 +123,23 @@ static int word_eq(char *s1, char *s2)
 }
 
 
+/* Find the end of the header block (the byte following the empty line's
+ * CRLF) within buf, only considering terminators that end at or after
+ * offset start. Returns -1 if the header is not yet complete.
+ */
+static int httpread_hdr_end(const char *buf, int start, int len)
+{
+	const char *pos, *end = buf + len;
+
+	for (pos = buf + (start > 3 ? start : 3); pos < end; pos++) {
+		if (pos[0] == '\n' && pos[-1] == '\r' && pos[-2] == '\n' &&
+		    pos[-3] == '\r')
+			return pos + 1 - buf;
+	}
+	return -1;
+}
+
+
 static void httpread_timeout_handler(void *eloop_data, void *user_ctx);
 
 /* httpread_destroy -- if h is non-NULL, clean up
@@ -303,6 +326,8 @@ static int httpread_hdr_analyze(struct httpread *h)
 			break;
 		if (!isgraph(*hbp))
 			goto bad;
+		if (h->hdr_nlines < HTTPREAD_HEADER_MAX_LINES)
+			h->hdr_line_offset[h->hdr_nlines++] = hbp - h->hdr;
 		if (httpread_hdr_option_analyze(h, hbp))
 			goto bad;
 		/* skip line */
@@ -311,6 +336,8 @@ static int httpread_hdr_analyze(struct httpread *h)
 				break;
 	}
 
+	h->hdr_lines_end = hbp - h->hdr;
+
 	/* chunked overrides content-length always */
 	if (h->chunked)
 		h->got_content_length = 0;
@@ -377,6 +404,34 @@ static void httpread_read_handler(int sd, void *eloop_ctx, void *sock_ctx)
 	 * boundaries between header and data and etc.
 	 */
 	wpa_printf(MSG_DEBUG, "httpread: Trying to read more data(%p)", h);
+	if (h->got_hdr && !h->got_body && !h->chunked &&
+	    h->got_content_length &&
+	    h->body_alloc_nbytes > h->content_length) {
+		/* Rest of a body of known length; the buffer for all of it
+		 * has already been allocated, so read straight into place
+		 * instead of staging the data in readbuf. */
+		nread = read(h->sd, h->body + h->body_nbytes,
+			     h->content_length - h->body_nbytes);
+		if (nread < 0) {
+			wpa_printf(MSG_DEBUG, "httpread failed: %s",
+				   strerror(errno));
+			goto bad;
+		}
+		wpa_hexdump_ascii(MSG_MSGDUMP, "httpread - read",
+				  h->body + h->body_nbytes, nread);
+		if (nread == 0) {
+			wpa_printf(MSG_DEBUG,
+				   "httpread premature eof(%p) %d/%d",
+				   h, h->body_nbytes, h->content_length);
+			goto bad;
+		}
+		h->body_nbytes += nread;
+		if (h->body_nbytes < h->content_length)
+			goto get_more;
+		h->got_body = 1;
+		wpa_printf(MSG_DEBUG, "httpread got content(%p)", h);
+		goto got_file;
+	}
 	nread = read(h->sd, readbuf, sizeof(readbuf));
 	if (nread < 0) {
 		wpa_printf(MSG_DEBUG, "httpread failed: %s", strerror(errno));
@@ -415,33 +470,38 @@ static void httpread_read_handler(int sd, void *eloop_ctx, void *sock_ctx)
 	 * and an empty line (CR LF only).
 	 */
 	if (!h->got_hdr) {
-		hbp = h->hdr + h->hdr_nbytes;
+		int ncopy, hdr_end;
+
 		/* add to headers until:
 		 *      -- we run out of data in read buffer
 		 *      -- or, we run out of header buffer room
 		 *      -- or, we get double CRLF in headers
+		 * Copy as much as fits in one go and then look for the
+		 * terminator only in the newly added bytes (plus the three
+		 * preceding ones in case it straddles two reads).
 		 */
-		for (;;) {
-			if (nread == 0)
-				goto get_more;
-			if (h->hdr_nbytes == HTTPREAD_HEADER_MAX_SIZE) {
+		ncopy = HTTPREAD_HEADER_MAX_SIZE - h->hdr_nbytes;
+		if (ncopy > nread)
+			ncopy = nread;
+		hbp = h->hdr + h->hdr_nbytes;
+		os_memcpy(hbp, rbp, ncopy);
+		hdr_end = httpread_hdr_end(h->hdr, h->hdr_nbytes,
+					   h->hdr_nbytes + ncopy);
+		if (hdr_end < 0) {
+			h->hdr_nbytes += ncopy;
+			if (nread > ncopy) {
 				wpa_printf(MSG_DEBUG,
 					   "httpread: Too long header");
 				goto bad;
 			}
-			*hbp++ = *rbp++;
-			nread--;
-			h->hdr_nbytes++;
-			if (h->hdr_nbytes >= 4 &&
-			    hbp[-1] == '\n' &&
-			    hbp[-2] == '\r' &&
-			    hbp[-3] == '\n' &&
-			    hbp[-4] == '\r' ) {
-				h->got_hdr = 1;
-				*hbp = 0;       /* null terminate */
-				break;
-			}
+			goto get_more;
 		}
+		ncopy = hdr_end - h->hdr_nbytes;
+		rbp += ncopy;
+		nread -= ncopy;
+		h->hdr_nbytes = hdr_end;
+		h->hdr[hdr_end] = 0;       /* null terminate */
+		h->got_hdr = 1;
 		/* here we've just finished reading the header */
 		if (httpread_hdr_analyze(h)) {
 			wpa_printf(MSG_DEBUG, "httpread bad hdr(%p)", h);
@@ -462,10 +522,10 @@ static void httpread_read_handler(int sd, void *eloop_ctx, void *sock_ctx)
 	/* Certain types of requests never have data and so
 	 * must be specially recognized.
 	 */
-	if (!os_strncasecmp(h->hdr, "SUBSCRIBE", 9) ||
-	    !os_strncasecmp(h->hdr, "UNSUBSCRIBE", 11) ||
-	    !os_strncasecmp(h->hdr, "HEAD", 4) ||
-	    !os_strncasecmp(h->hdr, "GET", 3)) {
+	if (h->hdr_type == HTTPREAD_HDR_TYPE_SUBSCRIBE ||
+	    h->hdr_type == HTTPREAD_HDR_TYPE_UNSUBSCRIBE ||
+	    h->hdr_type == HTTPREAD_HDR_TYPE_HEAD ||
+	    h->hdr_type == HTTPREAD_HDR_TYPE_GET) {
 		if (!h->got_body) {
 			wpa_printf(MSG_DEBUG, "httpread NO BODY for sp. type");
 		}
@@ -828,21 +888,35 @@ char * httpread_hdr_get(struct httpread *h)
 char * httpread_hdr_line_get(struct httpread *h, const char *tag)
 {
 	int tag_len = os_strlen(tag);
-	char *hdr = h->hdr;
-	hdr = os_strchr(hdr, '\n');
-	if (hdr == NULL)
+	char *hdr, *end;
+	int i;
+
+	if (!h->got_hdr)
 		return NULL;
-	hdr++;
+
+	/* Line starts were recorded while analyzing the header, so only
+	 * the lines past the index need to be searched for. */
+	for (i = 0; i < h->hdr_nlines; i++) {
+		hdr = h->hdr + h->hdr_line_offset[i];
+		if (!os_strncasecmp(hdr, tag, tag_len))
+			goto found;
+	}
+	if (h->hdr_nlines < HTTPREAD_HEADER_MAX_LINES)
+		return NULL;
+
+	hdr = h->hdr + h->hdr_line_offset[HTTPREAD_HEADER_MAX_LINES - 1];
+	end = h->hdr + h->hdr_lines_end;
 	for (;;) {
-		if (!os_strncasecmp(hdr, tag, tag_len)) {
-			hdr += tag_len;
-			while (*hdr == ' ' || *hdr == '\t')
-				hdr++;
-			return hdr;
-		}
 		hdr = os_strchr(hdr, '\n');
-		if (hdr == NULL)
+		if (hdr == NULL || ++hdr >= end)
 			return NULL;
-		hdr++;
+		if (!os_strncasecmp(hdr, tag, tag_len))
+			goto found;
 	}
+
+found:
+	hdr += tag_len;
+	while (*hdr == ' ' || *hdr == '\t')
+		hdr++;
+	return hdr;
 }
@@ -75,8 +75,12 @@ static struct wps_nfc_pw_token * wps_get_nfc_pw_token(struct dl_list *tokens,
 #endif /* CONFIG_WPS_NFC */
 
 
+#define WPS_PIN_HASH_SIZE 256
+#define WPS_PIN_HASH(uuid) ((uuid)[WPS_UUID_LEN - 1])
+
 struct wps_uuid_pin {
 	struct dl_list list;
+	struct wps_uuid_pin *hnext; /* next entry in UUID hash table list */
 	u8 uuid[WPS_UUID_LEN];
 	int wildcard_uuid;
 	u8 *pin;
@@ -96,21 +100,6 @@ static void wps_free_pin(struct wps_uuid_pin *pin)
 }
 
 
-static void wps_remove_pin(struct wps_uuid_pin *pin)
-{
-	dl_list_del(&pin->list);
-	wps_free_pin(pin);
-}
-
-
-static void wps_free_pins(struct dl_list *pins)
-{
-	struct wps_uuid_pin *pin, *prev;
-	dl_list_for_each_safe(pin, prev, pins, struct wps_uuid_pin, list)
-		wps_remove_pin(pin);
-}
-
-
 struct wps_pbc_session {
 	struct wps_pbc_session *next;
 	u8 addr[ETH_ALEN];
@@ -131,6 +120,21 @@ static void wps_free_pbc_sessions(struct wps_pbc_session *pbc)
 }
 
 
+#define WPS_PROBE_REQ_CACHE_SIZE 8
+
+/*
+ * Parsed WPS IE from a recently received Probe Request. Stations repeat the
+ * same WPS IE in every Probe Request of a scan, so this allows the attribute
+ * parsing to be skipped for them. The pointers in attr point to ie.
+ */
+struct wps_probe_req_cache {
+	u8 addr[ETH_ALEN];
+	struct wpabuf *ie;
+	struct wps_parse_attr attr;
+	struct os_reltime last_seen;
+};
+
+
 struct wps_registrar_device {
 	struct wps_registrar_device *next;
 	struct wps_device_data dev;
@@ -162,8 +166,13 @@ struct wps_registrar {
 	void *cb_ctx;
 
 	struct dl_list pins;
+	/* PINs with a known UUID (including assigned wildcard PINs) */
+	struct wps_uuid_pin *pin_hash[WPS_PIN_HASH_SIZE];
+	unsigned int num_wildcard_pins;
+	struct os_reltime pin_expire_next; /* earliest PIN expiration */
 	struct dl_list nfc_pw_tokens;
 	struct wps_pbc_session *pbc_sessions;
+	struct wps_probe_req_cache probe_req_cache[WPS_PROBE_REQ_CACHE_SIZE];
 
 	int skip_cred_build;
 	struct wpabuf *extra_cred;
@@ -199,6 +208,63 @@ static void wps_registrar_remove_pin(struct wps_registrar *reg,
 				     struct wps_uuid_pin *pin);
 
 
+static void wps_pin_hash_add(struct wps_registrar *reg,
+			     struct wps_uuid_pin *pin)
+{
+	pin->hnext = reg->pin_hash[WPS_PIN_HASH(pin->uuid)];
+	reg->pin_hash[WPS_PIN_HASH(pin->uuid)] = pin;
+}
+
+
+static void wps_pin_hash_del(struct wps_registrar *reg,
+			     struct wps_uuid_pin *pin)
+{
+	struct wps_uuid_pin **p;
+
+	for (p = &reg->pin_hash[WPS_PIN_HASH(pin->uuid)]; *p;
+	     p = &(*p)->hnext) {
+		if (*p == pin) {
+			*p = pin->hnext;
+			break;
+		}
+	}
+	pin->hnext = NULL;
+}
+
+
+static struct wps_uuid_pin * wps_pin_get_uuid(struct wps_registrar *reg,
+					      const u8 *uuid)
+{
+	struct wps_uuid_pin *pin;
+
+	pin = reg->pin_hash[WPS_PIN_HASH(uuid)];
+	while (pin && os_memcmp(pin->uuid, uuid, WPS_UUID_LEN) != 0)
+		pin = pin->hnext;
+	return pin;
+}
+
+
+static void wps_remove_pin(struct wps_registrar *reg,
+			   struct wps_uuid_pin *pin)
+{
+	if (pin->wildcard_uuid)
+		reg->num_wildcard_pins--;
+	wps_pin_hash_del(reg, pin);
+	dl_list_del(&pin->list);
+	wps_free_pin(pin);
+}
+
+
+static void wps_free_pins(struct wps_registrar *reg)
+{
+	struct wps_uuid_pin *pin, *prev;
+	dl_list_for_each_safe(pin, prev, &reg->pins, struct wps_uuid_pin, list)
+		wps_remove_pin(reg, pin);
+	reg->pin_expire_next.sec = 0;
+	reg->pin_expire_next.usec = 0;
+}
+
+
 static void wps_registrar_add_authorized_mac(struct wps_registrar *reg,
 					     const u8 *addr)
 {
@@ -320,31 +386,38 @@ static void wps_registrar_add_pbc_session(struct wps_registrar *reg,
 	os_get_reltime(&now);
 
 	pbc = reg->pbc_sessions;
-	while (pbc) {
-		if (os_memcmp(pbc->addr, addr, ETH_ALEN) == 0 &&
-		    os_memcmp(pbc->uuid_e, uuid_e, WPS_UUID_LEN) == 0) {
-			if (prev)
-				prev->next = pbc->next;
-			else
-				reg->pbc_sessions = pbc->next;
-			break;
+	if (pbc && os_memcmp(pbc->addr, addr, ETH_ALEN) == 0 &&
+	    os_memcmp(pbc->uuid_e, uuid_e, WPS_UUID_LEN) == 0) {
+		/* Repeated Probe Request from the most recently seen Enrollee;
+		 * the order of the list does not change. */
+		pbc->timestamp = now;
+	} else {
+		while (pbc) {
+			if (os_memcmp(pbc->addr, addr, ETH_ALEN) == 0 &&
+			    os_memcmp(pbc->uuid_e, uuid_e, WPS_UUID_LEN) == 0) {
+				if (prev)
+					prev->next = pbc->next;
+				else
+					reg->pbc_sessions = pbc->next;
+				break;
+			}
+			prev = pbc;
+			pbc = pbc->next;
 		}
-		prev = pbc;
-		pbc = pbc->next;
-	}
 
-	if (!pbc) {
-		pbc = os_zalloc(sizeof(*pbc));
-		if (pbc == NULL)
-			return;
-		os_memcpy(pbc->addr, addr, ETH_ALEN);
-		if (uuid_e)
-			os_memcpy(pbc->uuid_e, uuid_e, WPS_UUID_LEN);
-	}
+		if (!pbc) {
+			pbc = os_zalloc(sizeof(*pbc));
+			if (pbc == NULL)
+				return;
+			os_memcpy(pbc->addr, addr, ETH_ALEN);
+			if (uuid_e)
+				os_memcpy(pbc->uuid_e, uuid_e, WPS_UUID_LEN);
+		}
 
-	pbc->next = reg->pbc_sessions;
-	reg->pbc_sessions = pbc;
-	pbc->timestamp = now;
+		pbc->next = reg->pbc_sessions;
+		reg->pbc_sessions = pbc;
+		pbc->timestamp = now;
+	}
 
 	/* remove entries that have timed out */
 	prev = pbc;
@@ -676,14 +749,27 @@ wps_registrar_init(struct wps_context *wps,
 }
 
 
+static void wps_registrar_flush_probe_req_cache(struct wps_registrar *reg)
+{
+	size_t i;
+
+	for (i = 0; i < WPS_PROBE_REQ_CACHE_SIZE; i++) {
+		wpabuf_free(reg->probe_req_cache[i].ie);
+		os_memset(&reg->probe_req_cache[i], 0,
+			  sizeof(reg->probe_req_cache[i]));
+	}
+}
+
+
 void wps_registrar_flush(struct wps_registrar *reg)
 {
 	if (reg == NULL)
 		return;
-	wps_free_pins(&reg->pins);
+	wps_free_pins(reg);
 	wps_free_nfc_pw_tokens(&reg->nfc_pw_tokens, 0);
 	wps_free_pbc_sessions(reg->pbc_sessions);
 	reg->pbc_sessions = NULL;
+	wps_registrar_flush_probe_req_cache(reg);
 	wps_free_devices(reg->devices);
 	reg->devices = NULL;
 #ifdef WPS_WORKAROUNDS
@@ -712,6 +798,9 @@ static void wps_registrar_invalidate_unused(struct wps_registrar *reg)
 {
 	struct wps_uuid_pin *pin;
 
+	if (!reg->num_wildcard_pins)
+		return;
+
 	dl_list_for_each(pin, &reg->pins, struct wps_uuid_pin, list) {
 		if (pin->wildcard_uuid == 1 && !(pin->flags & PIN_LOCKED)) {
 			wpa_printf(MSG_DEBUG, "WPS: Invalidate previously "
@@ -760,10 +849,17 @@ int wps_registrar_add_pin(struct wps_registrar *reg, const u8 *addr,
 		p->flags |= PIN_EXPIRES;
 		os_get_reltime(&p->expiration);
 		p->expiration.sec += timeout;
+		if (!os_reltime_initialized(&reg->pin_expire_next) ||
+		    os_reltime_before(&p->expiration, &reg->pin_expire_next))
+			reg->pin_expire_next = p->expiration;
 	}
 
-	if (p->wildcard_uuid)
+	if (p->wildcard_uuid) {
 		wps_registrar_invalidate_unused(reg);
+		reg->num_wildcard_pins++;
+	} else {
+		wps_pin_hash_add(reg, p);
+	}
 
 	dl_list_add(&reg->pins, &p->list);
 
@@ -799,7 +895,7 @@ static void wps_registrar_remove_pin(struct wps_registrar *reg,
 	else
 		addr = pin->enrollee_addr;
 	wps_registrar_remove_authorized_mac(reg, addr);
-	wps_remove_pin(pin);
+	wps_remove_pin(reg, pin);
 	wps_registrar_selected_registrar_changed(reg, 0);
 }
 
@@ -807,18 +903,31 @@ static void wps_registrar_remove_pin(struct wps_registrar *reg,
 static void wps_registrar_expire_pins(struct wps_registrar *reg)
 {
 	struct wps_uuid_pin *pin, *prev;
-	struct os_reltime now;
+	struct os_reltime now, next;
 
+	/* Nothing can have expired before the earliest recorded expiration
+	 * time, so avoid walking through all the PINs on each lookup. */
+	if (!os_reltime_initialized(&reg->pin_expire_next))
+		return;
 	os_get_reltime(&now);
+	if (!os_reltime_before(&reg->pin_expire_next, &now))
+		return;
+
+	os_memset(&next, 0, sizeof(next));
 	dl_list_for_each_safe(pin, prev, &reg->pins, struct wps_uuid_pin, list)
 	{
-		if ((pin->flags & PIN_EXPIRES) &&
-		    os_reltime_before(&pin->expiration, &now)) {
+		if (!(pin->flags & PIN_EXPIRES))
+			continue;
+		if (os_reltime_before(&pin->expiration, &now)) {
 			wpa_hexdump(MSG_DEBUG, "WPS: Expired PIN for UUID",
 				    pin->uuid, WPS_UUID_LEN);
 			wps_registrar_remove_pin(reg, pin);
+		} else if (!os_reltime_initialized(&next) ||
+			   os_reltime_before(&pin->expiration, &next)) {
+			next = pin->expiration;
 		}
 	}
+	reg->pin_expire_next = next;
 }
 
 
@@ -835,6 +944,9 @@ static int wps_registrar_invalidate_wildcard_pin(struct wps_registrar *reg,
 {
 	struct wps_uuid_pin *pin, *prev;
 
+	if (!reg->num_wildcard_pins)
+		return -1;
+
 	dl_list_for_each_safe(pin, prev, &reg->pins, struct wps_uuid_pin, list)
 	{
 		if (dev_pw && pin->pin &&
@@ -861,19 +973,16 @@ static int wps_registrar_invalidate_wildcard_pin(struct wps_registrar *reg,
  */
 int wps_registrar_invalidate_pin(struct wps_registrar *reg, const u8 *uuid)
 {
-	struct wps_uuid_pin *pin, *prev;
+	struct wps_uuid_pin *pin;
 
-	dl_list_for_each_safe(pin, prev, &reg->pins, struct wps_uuid_pin, list)
-	{
-		if (os_memcmp(pin->uuid, uuid, WPS_UUID_LEN) == 0) {
-			wpa_hexdump(MSG_DEBUG, "WPS: Invalidated PIN for UUID",
-				    pin->uuid, WPS_UUID_LEN);
-			wps_registrar_remove_pin(reg, pin);
-			return 0;
-		}
-	}
+	pin = wps_pin_get_uuid(reg, uuid);
+	if (!pin)
+		return -1;
 
-	return -1;
+	wpa_hexdump(MSG_DEBUG, "WPS: Invalidated PIN for UUID",
+		    pin->uuid, WPS_UUID_LEN);
+	wps_registrar_remove_pin(reg, pin);
+	return 0;
 }
 
 
@@ -884,7 +993,7 @@ static const u8 * wps_registrar_get_pin(struct wps_registrar *reg,
 
 	wps_registrar_expire_pins(reg);
 
-	dl_list_for_each(pin, &reg->pins, struct wps_uuid_pin, list) {
+	for (pin = reg->pin_hash[WPS_PIN_HASH(uuid)]; pin; pin = pin->hnext) {
 		if (!pin->wildcard_uuid &&
 		    os_memcmp(pin->uuid, uuid, WPS_UUID_LEN) == 0) {
 			found = pin;
@@ -892,7 +1001,7 @@ static const u8 * wps_registrar_get_pin(struct wps_registrar *reg,
 		}
 	}
 
-	if (!found) {
+	if (!found && reg->num_wildcard_pins) {
 		/* Check for wildcard UUIDs since none of the UUID-specific
 		 * PINs matched */
 		dl_list_for_each(pin, &reg->pins, struct wps_uuid_pin, list) {
@@ -900,8 +1009,10 @@ static const u8 * wps_registrar_get_pin(struct wps_registrar *reg,
 			    pin->wildcard_uuid == 2) {
 				wpa_printf(MSG_DEBUG, "WPS: Found a wildcard "
 					   "PIN. Assigned it for this UUID-E");
+				wps_pin_hash_del(reg, pin);
 				pin->wildcard_uuid++;
 				os_memcpy(pin->uuid, uuid, WPS_UUID_LEN);
+				wps_pin_hash_add(reg, pin);
 				found = pin;
 				break;
 			}
@@ -940,19 +1051,16 @@ int wps_registrar_unlock_pin(struct wps_registrar *reg, const u8 *uuid)
 {
 	struct wps_uuid_pin *pin;
 
-	dl_list_for_each(pin, &reg->pins, struct wps_uuid_pin, list) {
-		if (os_memcmp(pin->uuid, uuid, WPS_UUID_LEN) == 0) {
-			if (pin->wildcard_uuid == 3) {
-				wpa_printf(MSG_DEBUG, "WPS: Invalidating used "
-					   "wildcard PIN");
-				return wps_registrar_invalidate_pin(reg, uuid);
-			}
-			pin->flags &= ~PIN_LOCKED;
-			return 0;
-		}
-	}
+	pin = wps_pin_get_uuid(reg, uuid);
+	if (!pin)
+		return -1;
 
-	return -1;
+	if (pin->wildcard_uuid == 3) {
+		wpa_printf(MSG_DEBUG, "WPS: Invalidating used wildcard PIN");
+		return wps_registrar_invalidate_pin(reg, uuid);
+	}
+	pin->flags &= ~PIN_LOCKED;
+	return 0;
 }
 
 
@@ -1082,6 +1190,52 @@ int wps_registrar_wps_cancel(struct wps_registrar *reg)
 }
 
 
+static const struct wps_parse_attr *
+wps_registrar_parse_probe_req(struct wps_registrar *reg, const u8 *addr,
+			      const struct wpabuf *wps_data,
+			      struct wps_parse_attr *tmp)
+{
+	struct wps_probe_req_cache *e, *entry = NULL;
+	struct wpabuf *ie;
+	size_t i;
+
+	for (i = 0; i < WPS_PROBE_REQ_CACHE_SIZE; i++) {
+		e = &reg->probe_req_cache[i];
+		if (e->ie && os_memcmp(e->addr, addr, ETH_ALEN) == 0) {
+			if (wpabuf_len(e->ie) == wpabuf_len(wps_data) &&
+			    os_memcmp(wpabuf_head(e->ie),
+				      wpabuf_head(wps_data),
+				      wpabuf_len(wps_data)) == 0) {
+				os_get_reltime(&e->last_seen);
+				return &e->attr;
+			}
+			/* Replace the previous WPS IE from this station */
+			entry = e;
+			break;
+		}
+		if (!entry ||
+		    (entry->ie &&
+		     (!e->ie ||
+		      os_reltime_before(&e->last_seen, &entry->last_seen))))
+			entry = e;
+	}
+
+	ie = wpabuf_dup(wps_data);
+	if (!ie)
+		return wps_parse_msg(wps_data, tmp) < 0 ? NULL : tmp;
+	wpabuf_free(entry->ie);
+	os_memset(entry, 0, sizeof(*entry));
+	if (wps_parse_msg(ie, &entry->attr) < 0) {
+		wpabuf_free(ie);
+		return NULL;
+	}
+	os_memcpy(entry->addr, addr, ETH_ALEN);
+	entry->ie = ie;
+	os_get_reltime(&entry->last_seen);
+	return &entry->attr;
+}
+
+
 /**
  * wps_registrar_probe_req_rx - Notify Registrar of Probe Request
  * @reg: Registrar data from wps_registrar_init()
@@ -1096,62 +1250,64 @@ void wps_registrar_probe_req_rx(struct wps_registrar *reg, const u8 *addr,
 				const struct wpabuf *wps_data,
 				int p2p_wildcard)
 {
-	struct wps_parse_attr attr;
+	struct wps_parse_attr tmp;
+	const struct wps_parse_attr *attr;
 	int skip_add = 0;
 
 	wpa_hexdump_buf(MSG_MSGDUMP,
 			"WPS: Probe Request with WPS data received",
 			wps_data);
 
-	if (wps_parse_msg(wps_data, &attr) < 0)
+	attr = wps_registrar_parse_probe_req(reg, addr, wps_data, &tmp);
+	if (!attr)
 		return;
 
-	if (attr.config_methods == NULL) {
+	if (attr->config_methods == NULL) {
 		wpa_printf(MSG_DEBUG, "WPS: No Config Methods attribute in "
 			   "Probe Request");
 		return;
 	}
 
-	if (attr.dev_password_id == NULL) {
+	if (attr->dev_password_id == NULL) {
 		wpa_printf(MSG_DEBUG, "WPS: No Device Password Id attribute "
 			   "in Probe Request");
 		return;
 	}
 
-	if (reg->enrollee_seen_cb && attr.uuid_e &&
-	    attr.primary_dev_type && attr.request_type && !p2p_wildcard) {
+	if (reg->enrollee_seen_cb && attr->uuid_e &&
+	    attr->primary_dev_type && attr->request_type && !p2p_wildcard) {
 		char *dev_name = NULL;
-		if (attr.dev_name) {
-			dev_name = os_zalloc(attr.dev_name_len + 1);
+		if (attr->dev_name) {
+			dev_name = os_zalloc(attr->dev_name_len + 1);
 			if (dev_name) {
-				os_memcpy(dev_name, attr.dev_name,
-					  attr.dev_name_len);
+				os_memcpy(dev_name, attr->dev_name,
+					  attr->dev_name_len);
 			}
 		}
-		reg->enrollee_seen_cb(reg->cb_ctx, addr, attr.uuid_e,
-				      attr.primary_dev_type,
-				      WPA_GET_BE16(attr.config_methods),
-				      WPA_GET_BE16(attr.dev_password_id),
-				      *attr.request_type, dev_name);
+		reg->enrollee_seen_cb(reg->cb_ctx, addr, attr->uuid_e,
+				      attr->primary_dev_type,
+				      WPA_GET_BE16(attr->config_methods),
+				      WPA_GET_BE16(attr->dev_password_id),
+				      *attr->request_type, dev_name);
 		os_free(dev_name);
 	}
 
-	if (WPA_GET_BE16(attr.dev_password_id) != DEV_PW_PUSHBUTTON)
+	if (WPA_GET_BE16(attr->dev_password_id) != DEV_PW_PUSHBUTTON)
 		return; /* Not PBC */
 
 	wpa_printf(MSG_DEBUG, "WPS: Probe Request for PBC received from "
 		   MACSTR, MAC2STR(addr));
-	if (attr.uuid_e == NULL) {
+	if (attr->uuid_e == NULL) {
 		wpa_printf(MSG_DEBUG, "WPS: Invalid Probe Request WPS IE: No "
 			   "UUID-E included");
 		return;
 	}
-	wpa_hexdump(MSG_DEBUG, "WPS: UUID-E from Probe Request", attr.uuid_e,
+	wpa_hexdump(MSG_DEBUG, "WPS: UUID-E from Probe Request", attr->uuid_e,
 		    WPS_UUID_LEN);
 
 #ifdef WPS_WORKAROUNDS
 	if (reg->pbc_ignore_start.sec &&
-	    os_memcmp(attr.uuid_e, reg->pbc_ignore_uuid, WPS_UUID_LEN) == 0) {
+	    os_memcmp(attr->uuid_e, reg->pbc_ignore_uuid, WPS_UUID_LEN) == 0) {
 		struct os_reltime now, dur;
 		os_get_reltime(&now);
 		os_reltime_sub(&now, &reg->pbc_ignore_start, &dur);
@@ -1166,8 +1322,8 @@ void wps_registrar_probe_req_rx(struct wps_registrar *reg, const u8 *addr,
 #endif /* WPS_WORKAROUNDS */
 
 	if (!skip_add)
-		wps_registrar_add_pbc_session(reg, addr, attr.uuid_e);
-	if (wps_registrar_pbc_overlap(reg, addr, attr.uuid_e)) {
+		wps_registrar_add_pbc_session(reg, addr, attr->uuid_e);
+	if (wps_registrar_pbc_overlap(reg, addr, attr->uuid_e)) {
 		wpa_printf(MSG_DEBUG, "WPS: PBC session overlap detected");
 		reg->force_pbc_overlap = 1;
 		wps_pbc_overlap_event(reg->wps);
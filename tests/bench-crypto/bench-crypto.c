@@ -0,0 +1,458 @@
+/*
+ * Crypto primitive benchmark
+ * Copyright (c) 2017, Jouni Malinen <j@w1.fi>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This times the primitives from src/crypto with whichever backend the program
+ * was linked against (CONFIG_TLS=internal/openssl/gnutls in the Makefile). Each
+ * case is run for a fixed amount of time and the result is printed as one CSV
+ * line per case so that runs with different backends or revisions can be
+ * compared directly.
+ */
+
+#include "utils/includes.h"
+
+#include "utils/common.h"
+#include "utils/wpabuf.h"
+#include "crypto/crypto.h"
+#include "crypto/sha1.h"
+#include "crypto/sha256.h"
+#include "crypto/md5.h"
+#include "crypto/aes_wrap.h"
+#include "crypto/aes_siv.h"
+#include "crypto/dh_groups.h"
+
+
+#define BENCH_MAX_LEN 8192
+
+static u8 key[32], nonce[16], data[BENCH_MAX_LEN], out[BENCH_MAX_LEN + 64];
+static u8 wrapped[2][40];
+
+struct bench_dh {
+	const struct dh_group *dh;
+	struct wpabuf *pub, *priv;
+};
+
+static struct bench_dh dh_state[3];
+
+#ifdef CONFIG_ECC
+/* Generator of the NIST P-256 curve (group 19) */
+static const u8 p256_gen[] = {
+	0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47,
+	0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+	0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0,
+	0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96,
+	0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b,
+	0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+	0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce,
+	0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5
+};
+
+static struct crypto_ec *ec;
+static struct crypto_ec_point *ec_gen, *ec_res;
+static struct crypto_bignum *bn_a, *bn_b, *bn_res;
+#endif /* CONFIG_ECC */
+
+
+static int run_md5(size_t len)
+{
+	const u8 *addr[1] = { data };
+
+	return md5_vector(1, addr, &len, out);
+}
+
+
+static int run_sha1(size_t len)
+{
+	const u8 *addr[1] = { data };
+
+	return sha1_vector(1, addr, &len, out);
+}
+
+
+static int run_sha256(size_t len)
+{
+	const u8 *addr[1] = { data };
+
+	return sha256_vector(1, addr, &len, out);
+}
+
+
+static int run_hmac_md5(size_t len)
+{
+	return hmac_md5(key, 16, data, len, out);
+}
+
+
+static int run_hmac_sha1(size_t len)
+{
+	return hmac_sha1(key, 32, data, len, out);
+}
+
+
+static int run_hmac_sha256(size_t len)
+{
+	return hmac_sha256(key, 32, data, len, out);
+}
+
+
+static int run_sha1_prf(size_t len)
+{
+	return sha1_prf(key, 32, "Pairwise key expansion", data, 76, out, len);
+}
+
+
+static int run_sha256_prf(size_t len)
+{
+	return sha256_prf(key, 32, "Pairwise key expansion", data, 76, out,
+			  len);
+}
+
+
+static int run_tls_prf_sha1_md5(size_t len)
+{
+	return tls_prf_sha1_md5(data, 48, "key expansion", data + 48, 64,
+				out, len);
+}
+
+
+static int run_tls_prf_sha256(size_t len)
+{
+	tls_prf_sha256(data, 48, "key expansion", data + 48, 64, out, len);
+	return 0;
+}
+
+
+static int run_pbkdf2_sha1(size_t len)
+{
+	return pbkdf2_sha1("benchmark passphrase", (const u8 *) "ssid", 4, 4096,
+			   out, len);
+}
+
+
+static int run_aes_wrap(size_t len)
+{
+	return aes_wrap(key, 16, len / 8, data, out);
+}
+
+
+static int run_aes_unwrap(size_t len)
+{
+	return aes_unwrap(key, 16, len / 8, wrapped[len == 32], out);
+}
+
+
+static int run_aes_cmac(size_t len)
+{
+	return omac1_aes_128(key, data, len, out);
+}
+
+
+static int run_aes_ctr(size_t len)
+{
+	return aes_128_ctr_encrypt(key, nonce, data, len);
+}
+
+
+static int run_aes_gcm(size_t len)
+{
+	return aes_gcm_ae(key, 16, nonce, 12, data, len, nonce, 16, out,
+			  out + len);
+}
+
+
+static int run_aes_ccm(size_t len)
+{
+	return aes_ccm_ae(key, 16, nonce, 8, data, len, nonce, 16, out,
+			  out + len);
+}
+
+
+static int run_aes_siv(size_t len)
+{
+	const u8 *addr[1] = { nonce };
+	size_t alen[1] = { sizeof(nonce) };
+
+	return aes_siv_encrypt(key, 32, data, len, 1, addr, alen, out);
+}
+
+
+static int bench_dh_init(struct bench_dh *state, int group)
+{
+	state->dh = dh_groups_get(group);
+	if (!state->dh)
+		return -1;
+	state->pub = dh_init(state->dh, &state->priv);
+	return state->pub ? 0 : -1;
+}
+
+
+static int run_dh(struct bench_dh *state)
+{
+	struct wpabuf *shared;
+
+	shared = dh_derive_shared(state->pub, state->priv, state->dh);
+	if (!shared)
+		return -1;
+	wpabuf_clear_free(shared);
+	return 0;
+}
+
+
+static int run_dh5(size_t len)
+{
+	return run_dh(&dh_state[0]);
+}
+
+
+static int run_dh14(size_t len)
+{
+	return run_dh(&dh_state[1]);
+}
+
+
+static int run_dh15(size_t len)
+{
+	return run_dh(&dh_state[2]);
+}
+
+
+static int run_dh14_keygen(size_t len)
+{
+	struct wpabuf *pub, *priv = NULL;
+
+	pub = dh_init(dh_state[1].dh, &priv);
+	wpabuf_free(pub);
+	wpabuf_clear_free(priv);
+	return pub ? 0 : -1;
+}
+
+
+#ifdef CONFIG_ECC
+
+static int run_ec_mul(size_t len)
+{
+	return crypto_ec_point_mul(ec, ec_gen, bn_a, ec_res);
+}
+
+
+static int run_bignum_mulmod(size_t len)
+{
+	return crypto_bignum_mulmod(bn_a, bn_b, crypto_ec_get_prime(ec),
+				    bn_res);
+}
+
+
+static int run_bignum_exptmod(size_t len)
+{
+	return crypto_bignum_exptmod(bn_a, bn_b, crypto_ec_get_prime(ec),
+				     bn_res);
+}
+
+
+static int run_bignum_inverse(size_t len)
+{
+	return crypto_bignum_inverse(bn_a, crypto_ec_get_prime(ec), bn_res);
+}
+
+#endif /* CONFIG_ECC */
+
+
+struct bench_case {
+	const char *name;
+	int (*run)(size_t len);
+	size_t len; /* input (or output) length for the primitive */
+	int bulk; /* report throughput */
+};
+
+static const struct bench_case cases[] = {
+	{ "md5", run_md5, 64, 1 },
+	{ "md5", run_md5, 1500, 1 },
+	{ "md5", run_md5, 8192, 1 },
+	{ "sha1", run_sha1, 64, 1 },
+	{ "sha1", run_sha1, 1500, 1 },
+	{ "sha1", run_sha1, 8192, 1 },
+	{ "sha256", run_sha256, 64, 1 },
+	{ "sha256", run_sha256, 1500, 1 },
+	{ "sha256", run_sha256, 8192, 1 },
+	{ "hmac-md5", run_hmac_md5, 64, 1 },
+	{ "hmac-md5", run_hmac_md5, 1500, 1 },
+	{ "hmac-sha1", run_hmac_sha1, 64, 1 },
+	{ "hmac-sha1", run_hmac_sha1, 1500, 1 },
+	{ "hmac-sha256", run_hmac_sha256, 64, 1 },
+	{ "hmac-sha256", run_hmac_sha256, 1500, 1 },
+	{ "sha1-prf", run_sha1_prf, 48, 0 },
+	{ "sha256-prf", run_sha256_prf, 48, 0 },
+	{ "tls-prf-sha1-md5", run_tls_prf_sha1_md5, 128, 0 },
+	{ "tls-prf-sha256", run_tls_prf_sha256, 128, 0 },
+	{ "pbkdf2-sha1-4096", run_pbkdf2_sha1, 32, 0 },
+	{ "aes-wrap", run_aes_wrap, 16, 0 },
+	{ "aes-wrap", run_aes_wrap, 32, 0 },
+	{ "aes-unwrap", run_aes_unwrap, 16, 0 },
+	{ "aes-unwrap", run_aes_unwrap, 32, 0 },
+	{ "aes-cmac", run_aes_cmac, 64, 1 },
+	{ "aes-cmac", run_aes_cmac, 1500, 1 },
+	{ "aes-ctr", run_aes_ctr, 1500, 1 },
+	{ "aes-gcm", run_aes_gcm, 1500, 1 },
+	{ "aes-ccm", run_aes_ccm, 1500, 1 },
+	{ "aes-siv", run_aes_siv, 64, 1 },
+	{ "dh-5", run_dh5, 192, 0 },
+	{ "dh-14", run_dh14, 256, 0 },
+	{ "dh-15", run_dh15, 384, 0 },
+	{ "dh-14-keygen", run_dh14_keygen, 256, 0 },
+#ifdef CONFIG_ECC
+	{ "ec-19-mul", run_ec_mul, 32, 0 },
+	{ "bignum-mulmod", run_bignum_mulmod, 32, 0 },
+	{ "bignum-exptmod", run_bignum_exptmod, 32, 0 },
+	{ "bignum-inverse", run_bignum_inverse, 32, 0 },
+#endif /* CONFIG_ECC */
+	{ NULL, NULL, 0, 0 }
+};
+
+
+static int bench_init(void)
+{
+	if (os_get_random(key, sizeof(key)) < 0 ||
+	    os_get_random(nonce, sizeof(nonce)) < 0 ||
+	    os_get_random(data, sizeof(data)) < 0)
+		return -1;
+
+	if (aes_wrap(key, 16, 2, data, wrapped[0]) < 0 ||
+	    aes_wrap(key, 16, 4, data, wrapped[1]) < 0)
+		return -1;
+
+	if (bench_dh_init(&dh_state[0], 5) < 0 ||
+	    bench_dh_init(&dh_state[1], 14) < 0 ||
+	    bench_dh_init(&dh_state[2], 15) < 0)
+		return -1;
+
+#ifdef CONFIG_ECC
+	ec = crypto_ec_init(19);
+	if (!ec)
+		return -1;
+	ec_gen = crypto_ec_point_from_bin(ec, p256_gen);
+	ec_res = crypto_ec_point_init(ec);
+	bn_a = crypto_bignum_init_set(data, 32);
+	bn_b = crypto_bignum_init_set(data + 32, 32);
+	bn_res = crypto_bignum_init();
+	if (!ec_gen || !ec_res || !bn_a || !bn_b || !bn_res)
+		return -1;
+#endif /* CONFIG_ECC */
+
+	return 0;
+}
+
+
+static void bench_deinit(void)
+{
+	int i;
+
+	for (i = 0; i < (int) ARRAY_SIZE(dh_state); i++) {
+		wpabuf_free(dh_state[i].pub);
+		wpabuf_clear_free(dh_state[i].priv);
+	}
+
+#ifdef CONFIG_ECC
+	crypto_bignum_deinit(bn_a, 0);
+	crypto_bignum_deinit(bn_b, 0);
+	crypto_bignum_deinit(bn_res, 0);
+	crypto_ec_point_deinit(ec_gen, 0);
+	crypto_ec_point_deinit(ec_res, 0);
+	crypto_ec_deinit(ec);
+#endif /* CONFIG_ECC */
+}
+
+
+static int bench_run(const struct bench_case *c, unsigned int msec)
+{
+	struct os_reltime start, now, diff;
+	unsigned int i, iter = 0, batch = 1;
+	double usec;
+
+	os_get_reltime(&start);
+	for (;;) {
+		for (i = 0; i < batch; i++) {
+			if (c->run(c->len) < 0) {
+				fprintf(stderr, "%s (%u bytes) failed\n",
+					c->name, (unsigned int) c->len);
+				return -1;
+			}
+		}
+		iter += batch;
+		os_get_reltime(&now);
+		os_reltime_sub(&now, &start, &diff);
+		if (diff.sec * 1000 + diff.usec / 1000 >= (long) msec)
+			break;
+		if (batch < 1024)
+			batch *= 2;
+	}
+
+	usec = diff.sec * 1000000.0 + diff.usec;
+	printf("%s,%s,%u,%u,%.3f,%.2f\n", BENCH_BACKEND, c->name,
+	       (unsigned int) c->len, iter, usec / iter,
+	       c->bulk ? (double) c->len * iter / usec : 0.0);
+	fflush(stdout);
+
+	return 0;
+}
+
+
+static void usage(void)
+{
+	printf("usage: bench-crypto [-t<msec per case>] [-f<name filter>]\n"
+	       "\n"
+	       "Output: backend,primitive,bytes,iterations,usec_per_op,"
+	       "mb_per_sec\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	const struct bench_case *c;
+	const char *filter = NULL;
+	unsigned int msec = 500;
+	int opt, ret = 0;
+
+	for (;;) {
+		opt = getopt(argc, argv, "f:ht:");
+		if (opt < 0)
+			break;
+		switch (opt) {
+		case 'f':
+			filter = optarg;
+			break;
+		case 't':
+			msec = atoi(optarg);
+			break;
+		default:
+			usage();
+			return opt == 'h' ? 0 : -1;
+		}
+	}
+
+	wpa_debug_level = MSG_ERROR;
+
+	if (os_program_init())
+		return -1;
+
+	if (bench_init() < 0) {
+		fprintf(stderr, "Failed to initialize benchmark\n");
+		ret = -1;
+		goto out;
+	}
+
+	printf("backend,primitive,bytes,iterations,usec_per_op,mb_per_sec\n");
+	for (c = cases; c->name; c++) {
+		if (filter && !os_strstr(c->name, filter))
+			continue;
+		if (bench_run(c, msec) < 0)
+			ret = -1;
+	}
+
+out:
+	bench_deinit();
+	os_program_deinit();
+	return ret;
+}
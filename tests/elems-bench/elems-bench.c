@@ -0,0 +1,207 @@
+/*
+ * IEEE 802.11 element parsing benchmark
+ * Copyright (c) 2017, Jouni Malinen <j@w1.fi>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+#include <time.h>
+
+#include "utils/common.h"
+#include "common/ieee802_11_defs.h"
+#include "common/ieee802_11_common.h"
+
+
+struct ie_blob {
+	const char *name;
+	const char *hex;
+};
+
+/* IE parts of captured Beacon, Probe Response, and Probe Request frames */
+static const struct ie_blob blobs[] = {
+	{ "beacon-wpa2-ht",
+	  "000a6578616d706c652d6170"
+	  "010882848b960c121824"
+	  "030106"
+	  "050400010000"
+	  "0706555320010b1e"
+	  "2a0100"
+	  "32043048606c"
+	  "30140100000fac040100000fac040100000fac020c00"
+	  "2d1aad0117ffff000000000000000000000000000000000000000000"
+	  "3d1606000000000000000000000000000000000000000000"
+	  "7f080400080000000040"
+	  "dd180050f2020101800003a4000027a4000042435e0062322f00"
+	  "dd220050f204104a0001101044000102104700108765432187654321"
+	  "8765432187654321"
+	  "dd0900037f01010000ff7f" },
+	{ "probe-resp-vht-hs20",
+	  "000b686f7473706f742d766874"
+	  "01088c129824b048606c"
+	  "03012c"
+	  "07105553202401172801172c01173001171e"
+	  "0b0501002f0000"
+	  "2d1aef0917ffffff0000000000000000000000000000000000000000"
+	  "3d162c050400000000000000000000000000000000000000"
+	  "30140100000fac040100000fac040100000fac010c00"
+	  "46057200000000"
+	  "6b0731ffffffffffff"
+	  "6c027f00"
+	  "6f0500506f9a10"
+	  "7f0a04000a82214000400001"
+	  "bf0cb259820feaff0000eaff0000"
+	  "c005012a000000"
+	  "c30402020202"
+	  "dd180050f2020101880003a4000027a4000042435e0062322f00"
+	  "dd06506f9a101400"
+	  "dd080010180200001000" },
+	{ "probe-req",
+	  "0000"
+	  "010802040b160c121824"
+	  "32043048606c"
+	  "2d1aef0917ffffff0000000000000000000000000000000000000000"
+	  "7f0a04004a02014000400001"
+	  "bf0cb259820feaff0000eaff0000"
+	  "dd070050f208002b00"
+	  "dd080010180200001000" },
+	{ NULL, NULL }
+};
+
+static const u8 lookups[] = {
+	WLAN_EID_SSID, WLAN_EID_SUPP_RATES, WLAN_EID_DS_PARAMS,
+	WLAN_EID_RSN, WLAN_EID_HT_CAP, WLAN_EID_HT_OPERATION,
+	WLAN_EID_EXT_SUPP_RATES, WLAN_EID_MOBILITY_DOMAIN,
+	WLAN_EID_INTERWORKING, WLAN_EID_EXT_CAPAB,
+	WLAN_EID_VHT_CAP, WLAN_EID_VENDOR_SPECIFIC
+};
+
+
+static double bench_parse_elems(const u8 *ies, size_t len, int iter)
+{
+	struct ieee802_11_elems elems;
+	clock_t start;
+	int i;
+
+	start = clock();
+	for (i = 0; i < iter; i++)
+		ieee802_11_parse_elems(ies, len, &elems, 0);
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+static double bench_get_ie(const u8 *ies, size_t len, int iter,
+			   unsigned int *found)
+{
+	clock_t start;
+	int i;
+	size_t j;
+
+	start = clock();
+	for (i = 0; i < iter; i++) {
+		for (j = 0; j < ARRAY_SIZE(lookups); j++) {
+			if (get_ie(ies, len, lookups[j]))
+				(*found)++;
+		}
+	}
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+static double bench_elem_index(const u8 *ies, size_t len, int iter,
+			       unsigned int *found)
+{
+	struct ieee802_11_elem_index idx;
+	clock_t start;
+	int i;
+	size_t j;
+
+	start = clock();
+	for (i = 0; i < iter; i++) {
+		ieee802_11_elem_index_build(&idx, ies, len);
+		for (j = 0; j < ARRAY_SIZE(lookups); j++) {
+			if (ieee802_11_elem_index_get(&idx, ies, len,
+						      lookups[j]))
+				(*found)++;
+		}
+	}
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+static double bench_elem_index_lookup(const u8 *ies, size_t len, int iter,
+				      unsigned int *found)
+{
+	struct ieee802_11_elem_index idx;
+	clock_t start;
+	int i;
+	size_t j;
+
+	/* Index built once, e.g., when a BSS table entry is updated */
+	ieee802_11_elem_index_build(&idx, ies, len);
+	start = clock();
+	for (i = 0; i < iter; i++) {
+		for (j = 0; j < ARRAY_SIZE(lookups); j++) {
+			if (ieee802_11_elem_index_get(&idx, ies, len,
+						      lookups[j]))
+				(*found)++;
+		}
+	}
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+static void print_result(const char *name, double secs, int iter)
+{
+	printf("  %-26s %8.1f ns/frame\n", name, secs * 1e9 / iter);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int iter = 1000000;
+	int i, ret = 0;
+	u8 ies[1000];
+
+	if (argc > 1)
+		iter = atoi(argv[1]);
+	if (iter < 1) {
+		printf("usage: elems-bench [iterations]\n");
+		return -1;
+	}
+
+	wpa_debug_level = MSG_ERROR + 1;
+
+	for (i = 0; blobs[i].name; i++) {
+		size_t len = os_strlen(blobs[i].hex) / 2;
+		unsigned int found_get_ie = 0, found_index = 0, found_lookup = 0;
+		double t;
+
+		if (len > sizeof(ies) ||
+		    hexstr2bin(blobs[i].hex, ies, len) < 0) {
+			printf("Invalid IE blob %s\n", blobs[i].name);
+			return -1;
+		}
+
+		printf("%s (%u octets, %u elements):\n", blobs[i].name,
+		       (unsigned int) len, ieee802_11_ie_count(ies, len));
+		t = bench_parse_elems(ies, len, iter);
+		print_result("ieee802_11_parse_elems", t, iter);
+		t = bench_get_ie(ies, len, iter, &found_get_ie);
+		print_result("get_ie x lookups", t, iter);
+		t = bench_elem_index(ies, len, iter, &found_index);
+		print_result("elem_index x lookups", t, iter);
+		t = bench_elem_index_lookup(ies, len, iter, &found_lookup);
+		print_result("lookups on prebuilt index", t, iter);
+
+		if (found_get_ie != found_index ||
+		    found_get_ie != found_lookup) {
+			printf("Lookup mismatch: get_ie=%u elem_index=%u/%u\n",
+			       found_get_ie, found_index, found_lookup);
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
@@ -0,0 +1,149 @@
+/*
+ * httpread fuzzer
+ * Copyright (c) 2016, Jouni Malinen <j@w1.fi>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "utils/includes.h"
+#include <sys/socket.h>
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "wps/httpread.h"
+
+
+struct arg_ctx {
+	char *data;
+	size_t len;
+	int count;
+	int done;
+	int fd[2];
+	struct httpread *hread;
+	struct os_reltime start;
+};
+
+
+static void test_start(void *eloop_data, void *user_ctx);
+
+
+static void test_hread_cb(struct httpread *handle, void *cookie,
+			  enum httpread_event e)
+{
+	struct arg_ctx *ctx = cookie;
+	char *val;
+
+	if (e == HTTPREAD_EVENT_FILE_READY) {
+		wpa_printf(MSG_DEBUG,
+			   "httpread-fuzzer: type=%d uri=%s reply_code=%d body_len=%d",
+			   httpread_hdr_type_get(handle),
+			   httpread_uri_get(handle) ?
+			   httpread_uri_get(handle) : "N/A",
+			   httpread_reply_code_get(handle),
+			   httpread_length_get(handle));
+		val = httpread_hdr_line_get(handle, "CONTENT-TYPE:");
+		wpa_printf(MSG_DEBUG, "httpread-fuzzer: Content-Type: %s",
+			   val ? val : "N/A");
+		val = httpread_hdr_line_get(handle, "SOAPAction:");
+		wpa_printf(MSG_DEBUG, "httpread-fuzzer: SOAPAction: %s",
+			   val ? val : "N/A");
+		wpa_hexdump_ascii(MSG_MSGDUMP, "httpread-fuzzer: body",
+				  httpread_data_get(handle),
+				  httpread_length_get(handle));
+	} else {
+		wpa_printf(MSG_DEBUG, "httpread-fuzzer: event %d", e);
+	}
+
+	httpread_destroy(ctx->hread);
+	ctx->hread = NULL;
+	close(ctx->fd[0]);
+	close(ctx->fd[1]);
+
+	if (++ctx->done < ctx->count) {
+		eloop_register_timeout(0, 0, test_start, ctx, NULL);
+		return;
+	}
+
+	if (ctx->count > 1) {
+		struct os_reltime now, diff;
+
+		os_get_reltime(&now);
+		os_reltime_sub(&now, &ctx->start, &diff);
+		printf("%d requests in %ld.%06ld seconds\n", ctx->count,
+		       (long) diff.sec, (long) diff.usec);
+	}
+	eloop_terminate();
+}
+
+
+static void test_start(void *eloop_data, void *user_ctx)
+{
+	struct arg_ctx *ctx = eloop_data;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, ctx->fd) < 0) {
+		wpa_printf(MSG_ERROR, "socketpair: %s", strerror(errno));
+		goto fail;
+	}
+	if (write(ctx->fd[1], ctx->data, ctx->len) != (ssize_t) ctx->len) {
+		wpa_printf(MSG_ERROR, "write: %s", strerror(errno));
+		goto fail;
+	}
+	shutdown(ctx->fd[1], SHUT_WR);
+
+	ctx->hread = httpread_create(ctx->fd[0], test_hread_cb, ctx, 100000,
+				     10);
+	if (ctx->hread)
+		return;
+fail:
+	eloop_terminate();
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct arg_ctx ctx;
+
+	if (argc < 2) {
+		printf("usage: %s <file> [count]\n", argv[0]);
+		return -1;
+	}
+
+	if (os_program_init())
+		return -1;
+
+	wpa_debug_level = 0;
+	wpa_debug_show_keys = 1;
+
+	if (eloop_init()) {
+		wpa_printf(MSG_ERROR, "Failed to initialize event loop");
+		return -1;
+	}
+
+	os_memset(&ctx, 0, sizeof(ctx));
+	ctx.count = argc > 2 ? atoi(argv[2]) : 1;
+	if (ctx.count > 1)
+		wpa_debug_level = MSG_INFO;
+	ctx.data = os_readfile(argv[1], &ctx.len);
+	if (!ctx.data) {
+		wpa_printf(MSG_ERROR, "Could not read '%s'", argv[1]);
+		goto fail;
+	}
+	/* Keep the whole input within the socket buffer */
+	if (ctx.len > 65536)
+		ctx.len = 65536;
+
+	os_get_reltime(&ctx.start);
+	eloop_register_timeout(0, 0, test_start, &ctx, NULL);
+
+	wpa_printf(MSG_DEBUG, "Starting eloop");
+	eloop_run();
+	wpa_printf(MSG_DEBUG, "eloop done");
+
+fail:
+	os_free(ctx.data);
+	eloop_destroy();
+	os_program_deinit();
+
+	return 0;
+}
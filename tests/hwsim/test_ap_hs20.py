@@ -267,6 +267,80 @@ def test_ap_anqp_no_sharing_missing_info(dev, apdev):
     dev[0].scan_for_bss(bssid2, freq="2412")
     interworking_select(dev[0], None, "home", freq="2412")
 
+def test_ap_anqp_no_sharing_diff_domain(dev, apdev):
+    """ANQP no sharing between ANQP domains within ESS"""
+    check_eap_capa(dev[0], "MSCHAPV2")
+    dev[0].flush_scan_cache()
+
+    bssid = apdev[0]['bssid']
+    params = hs20_ap_params()
+    params['hessid'] = bssid
+    params['anqp_domain_id'] = "1234"
+    hostapd.add_ap(apdev[0], params)
+
+    bssid2 = apdev[1]['bssid']
+    params = hs20_ap_params()
+    params['hessid'] = bssid
+    params['anqp_domain_id'] = "5678"
+    params['nai_realm'] = [ "0,example.com,13[5:6],21[2:4][5:7]" ]
+    hostapd.add_ap(apdev[1], params)
+
+    dev[0].hs20_enable()
+    id = dev[0].add_cred_values({ 'realm': "example.com", 'username': "test",
+                                  'password': "secret",
+                                  'domain': "example.com" })
+    dev[0].scan_for_bss(bssid, freq="2412")
+    dev[0].scan_for_bss(bssid2, freq="2412")
+    interworking_select(dev[0], None, "home", freq="2412")
+    dev[0].dump_monitor()
+
+    res1 = dev[0].get_bss(bssid)
+    res2 = dev[0].get_bss(bssid2)
+    if 'anqp_nai_realm' not in res1 or 'anqp_nai_realm' not in res2:
+        raise Exception("anqp_nai_realm not found")
+    if res1['anqp_nai_realm'] == res2['anqp_nai_realm']:
+        raise Exception("ANQP results were shared between ANQP domains")
+
+def test_ap_anqp_sharing_after_bss_expiry(dev, apdev):
+    """ANQP data retained over BSS entry expiration"""
+    check_eap_capa(dev[0], "MSCHAPV2")
+    dev[0].flush_scan_cache()
+
+    bssid = apdev[0]['bssid']
+    params = hs20_ap_params()
+    params['hessid'] = bssid
+    hostapd.add_ap(apdev[0], params)
+
+    dev[0].hs20_enable()
+    id = dev[0].add_cred_values({ 'realm': "example.com", 'username': "test",
+                                  'password': "secret",
+                                  'domain': "example.com" })
+    interworking_select(dev[0], bssid, "home", freq="2412")
+    dev[0].dump_monitor()
+
+    time.sleep(1.1)
+    dev[0].request("BSS_FLUSH 1")
+    if dev[0].get_bss(bssid):
+        raise Exception("BSS entry not removed")
+
+    dev[0].scan_for_bss(bssid, freq="2412")
+    dev[0].request("INTERWORKING_SELECT freq=2412")
+    ev = dev[0].wait_event(["INTERWORKING-AP", "INTERWORKING-NO-MATCH",
+                            "Starting ANQP fetch"], timeout=15)
+    if ev is None:
+        raise Exception("Network selection timed out")
+    if "Starting ANQP fetch" in ev:
+        raise Exception("Unexpected ANQP fetch for retained ANQP data")
+    if "INTERWORKING-AP" not in ev or "type=home" not in ev:
+        raise Exception("Unexpected network selection result: " + ev)
+
+    dev[0].request("BSS_FLUSH 0")
+    dev[0].scan_for_bss(bssid, freq="2412")
+    dev[0].request("INTERWORKING_SELECT freq=2412")
+    ev = dev[0].wait_event(["Starting ANQP fetch"], timeout=15)
+    if ev is None:
+        raise Exception("ANQP fetch not started after BSS table flush")
+
 def test_ap_anqp_sharing_oom(dev, apdev):
     """ANQP sharing within ESS and explicit unshare OOM"""
     check_eap_capa(dev[0], "MSCHAPV2")
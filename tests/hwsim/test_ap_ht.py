@@ -787,6 +787,44 @@ def test_olbc_5ghz(dev, apdev):
             hapd2.request("DISABLE")
         set_world_reg(apdev[0], apdev[1], None)
 
+def test_ap_ht_beacon_update_coalesce(dev, apdev):
+    """HT protection changes coalesced into a single Beacon update"""
+    clear_scan_cache(apdev[0])
+    params = { "ssid": "test-ht40",
+               "channel": "5",
+               "ht_capab": "[HT40-]"}
+    hapd = hostapd.add_ap(apdev[0], params, wait_enabled=False)
+    ev = hapd.wait_event(["AP-ENABLED"], timeout=10)
+    if not ev:
+        raise Exception("AP setup timed out")
+    sec = hapd.get_status_field("secondary_channel")
+    if sec != "-1":
+        raise Exception("Unexpected secondary channel")
+
+    # 20 MHz-only HT STA first, then a non-HT STA, so that removing them in
+    # reverse order changes the HT operation mode twice
+    dev[1].connect("test-ht40", key_mgmt="NONE", scan_freq="2432",
+                   disable_ht40="1")
+    dev[0].connect("test-ht40", key_mgmt="NONE", scan_freq="2432",
+                   disable_ht="1")
+    if hapd.get_status_field("num_sta_no_ht") != "1":
+        raise Exception("Unexpected num_sta_no_ht")
+    if hapd.get_status_field("num_sta_ht_20_mhz") != "1":
+        raise Exception("Unexpected num_sta_ht_20_mhz")
+    time.sleep(0.1)
+    count = int(hapd.get_status_field("beacon_set_count[0]"))
+
+    hapd.request("DEAUTHENTICATE ff:ff:ff:ff:ff:ff")
+    dev[0].wait_disconnected()
+    dev[1].wait_disconnected()
+    time.sleep(0.1)
+    if hapd.get_status_field("ht_op_mode") != "0x0":
+        raise Exception("HT operation mode not restored")
+    count2 = int(hapd.get_status_field("beacon_set_count[0]"))
+    if count2 != count + 1:
+        raise Exception("Unexpected number of Beacon updates: %d" %
+                        (count2 - count))
+
 def test_ap_require_ht(dev, apdev):
     """Require HT"""
     params = { "ssid": "require-ht",
@@ -8,6 +8,7 @@ from remotehost import remote_compatible
 import logging
 logger = logging.getLogger()
 import os
+import time
 
 import hwsim_utils
 import hostapd
@@ -155,6 +156,86 @@ def test_ap_acl_deny(dev, apdev):
     if ev is not None:
         raise Exception("Unexpected association")
 
+def probe_resp_received(dev, bssid, ssid, scan_id, attempts=1):
+    """Check whether an active scan for a hidden SSID got a Probe Response"""
+    for i in range(attempts):
+        dev.dump_monitor()
+        if "FAIL" in dev.request("SCAN TYPE=ONLY freq=2412 scan_id=%d" % scan_id):
+            raise Exception("Failed to start scan")
+        ev = dev.wait_event(["CTRL-EVENT-SCAN-RESULTS"], 15)
+        if ev is None:
+            raise Exception("Scan timed out")
+        for line in dev.request("SCAN_RESULTS").splitlines()[1:]:
+            vals = line.split('\t')
+            if vals[0] == bssid and len(vals) > 4 and vals[4] == ssid:
+                return True
+    return False
+
+def test_ap_no_probe_resp_if_denied(dev, apdev):
+    """No Probe Response frames to STAs on the MAC ACL deny list"""
+    ssid = "acl"
+    params = {}
+    params['ssid'] = ssid
+    params['ignore_broadcast_ssid'] = "1"
+    params['deny_mac_file'] = "hostapd.macaddr"
+    params['no_probe_resp_if_denied'] = "1"
+    hapd = hostapd.add_ap(apdev[0], params)
+    bssid = apdev[0]['bssid']
+
+    # The SSID is hidden, so it is learned only from a Probe Response frame
+    id = dev[1].connect(ssid, key_mgmt="NONE", scan_ssid="1",
+                        only_add_network=True)
+    if not probe_resp_received(dev[1], bssid, ssid, id, attempts=10):
+        raise Exception("Allowed STA did not receive Probe Response")
+
+    id = dev[0].connect(ssid, key_mgmt="NONE", scan_ssid="1",
+                        only_add_network=True)
+    if probe_resp_received(dev[0], bssid, ssid, id, attempts=3):
+        raise Exception("Probe Response sent to denied STA")
+    if int(hapd.get_status_field("probe_req_drop_acl[0]")) == 0:
+        raise Exception("Probe Request from denied STA not dropped")
+
+    # Probe Request frames for a foreign SSID are dropped before parsing
+    id = dev[1].connect("foreign", key_mgmt="NONE", scan_ssid="1",
+                        only_add_network=True)
+    if probe_resp_received(dev[1], bssid, "foreign", id):
+        raise Exception("Probe Response sent for a foreign SSID")
+    if int(hapd.get_status_field("probe_req_drop_ssid[0]")) == 0:
+        raise Exception("Probe Request for a foreign SSID not dropped")
+
+def test_ap_probe_resp_rate_limit(dev, apdev):
+    """Probe Request rate limit per STA"""
+    ssid = "rate-limit"
+    params = {}
+    params['ssid'] = ssid
+    params['ignore_broadcast_ssid'] = "1"
+    params['probe_resp_rate_limit'] = "1"
+    hapd = hostapd.add_ap(apdev[0], params)
+    bssid = apdev[0]['bssid']
+
+    id = dev[0].connect(ssid, key_mgmt="NONE", scan_ssid="1",
+                        only_add_network=True)
+    if not probe_resp_received(dev[0], bssid, ssid, id, attempts=10):
+        raise Exception("No Probe Response before rate limit was reached")
+
+    # Further Probe Request frames within the same second are dropped
+    dev[0].request("BSS_FLUSH 0")
+    for i in range(3):
+        dev[0].scan(freq=2412, type="ONLY")
+    if int(hapd.get_status_field("probe_req_drop_rate[0]")) == 0:
+        raise Exception("Probe Request frames not rate limited")
+
+    # Other STAs are not affected and the limit applies only per second
+    id = dev[1].connect(ssid, key_mgmt="NONE", scan_ssid="1",
+                        only_add_network=True)
+    if not probe_resp_received(dev[1], bssid, ssid, id, attempts=10):
+        raise Exception("Other STA did not receive Probe Response")
+    time.sleep(1.1)
+    id = dev[0].connect(ssid, key_mgmt="NONE", scan_ssid="1",
+                        only_add_network=True)
+    if not probe_resp_received(dev[0], bssid, ssid, id, attempts=10):
+        raise Exception("No Probe Response after rate limit period")
+
 @remote_compatible
 def test_ap_wds_sta(dev, apdev):
     """WPA2-PSK AP with STA using 4addr mode"""
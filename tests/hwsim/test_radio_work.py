@@ -101,3 +101,75 @@ def test_radio_work_cancel(dev, apdev):
     wpas.interface_remove("wlan5")
     # add to allow log file renaming
     wpas.interface_add("wlan5")
+
+def get_radio_work_stats(dev):
+    stats = {}
+    for line in dev.request("RADIO_WORK stats").splitlines():
+        vals = line.split(' ')
+        stats[vals[0]] = dict(v.split('=') for v in vals[1:])
+    logger.info("Radio work statistics: " + str(stats))
+    return stats
+
+def test_ext_radio_work_stats(dev, apdev):
+    """Radio work wait/run time statistics"""
+    if "OK" not in dev[0].request("RADIO_WORK stats_flush"):
+        raise Exception("Failed to flush radio work statistics")
+    if dev[0].request("RADIO_WORK stats") != "":
+        raise Exception("Unexpected radio work statistics after flush")
+
+    id = dev[0].request("RADIO_WORK add test-work-a")
+    if "FAIL" in id:
+        raise Exception("Failed to add radio work")
+    id2 = dev[0].request("RADIO_WORK add test-work-b")
+    if "FAIL" in id2:
+        raise Exception("Failed to add radio work")
+    ev = dev[0].wait_event(["EXT-RADIO-WORK-START"])
+    if ev is None:
+        raise Exception("Timeout while waiting radio work to start")
+    dev[0].request("RADIO_WORK done " + id2)
+    time.sleep(0.1)
+    dev[0].request("RADIO_WORK done " + id)
+
+    stats = get_radio_work_stats(dev[0])
+    if "ext" not in stats:
+        raise Exception("External radio works missing from statistics")
+    if "ext:test-work-a" in stats or "ext:test-work-b" in stats:
+        raise Exception("External radio work types not grouped")
+    ext = stats["ext"]
+    if ext['started'] != '1' or ext['canceled'] != '1':
+        raise Exception("Unexpected external radio work counters")
+    run = [int(x) for x in ext['run'].split(',')]
+    if len(run) != 16 or sum(run) != 1 or sum(run[0:7]) != 0:
+        raise Exception("Unexpected external radio work run time histogram")
+
+def test_radio_work_preempt_scan(dev, apdev):
+    """Connect radio work preempting a scan on another interface"""
+    hapd = hostapd.add_ap(apdev[0], { "ssid": "open" })
+    ifname = "test-" + dev[0].ifname
+    dev[0].interface_add(ifname, create=True, if_type='sta')
+    try:
+        wpas = WpaSupplicant(ifname=ifname)
+        dev[0].request("RADIO_WORK stats_flush")
+        dev[0].scan_for_bss(apdev[0]['bssid'], freq="2412")
+
+        # Scanning for a network that is not present keeps the other
+        # interface running full scans on the shared radio
+        wpas.connect("not-found", key_mgmt="NONE", wait_connect=False)
+        ev = wpas.wait_event(["CTRL-EVENT-SCAN-STARTED"], timeout=5)
+        if ev is None:
+            raise Exception("Scan did not start")
+
+        # Recent scan results allow the connection without a new scan, so
+        # the connect radio work is queued behind the ongoing scan
+        dev[0].connect("open", key_mgmt="NONE", scan_freq="2412")
+
+        stats = get_radio_work_stats(dev[0])
+        if "scan" not in stats or int(stats["scan"]["preempted"]) < 1:
+            raise Exception("Scan not preempted")
+
+        ev = wpas.wait_event(["CTRL-EVENT-SCAN-STARTED"], timeout=10)
+        if ev is None:
+            raise Exception("Preempted scan not requested again")
+        wpas.request("DISCONNECT")
+    finally:
+        dev[0].global_request("INTERFACE_REMOVE " + ifname)
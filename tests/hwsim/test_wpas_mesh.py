@@ -739,6 +739,50 @@ def test_wpas_mesh_max_peering(dev, apdev, params):
     if zero[1] > 0 or zero[2] > 0 or one[1] == 0 or one[2] == 0:
         raise Exception("Unexpected value in Accepting Additional Mesh Peerings from other STAs")
 
+def test_wpas_mesh_max_new_peers(dev, apdev):
+    """Mesh new peer admission rate limit"""
+    check_mesh_support(dev[0], secure=True)
+    try:
+        for i in range(3):
+            dev[i].request("SET sae_groups ")
+
+        # first, connect dev[1] and dev[2]
+        for i in range(1, 3):
+            id = add_mesh_secure_net(dev[i])
+            dev[i].mesh_group_add(id)
+        for i in range(1, 3):
+            check_mesh_group_added(dev[i])
+            check_mesh_peer_connected(dev[i])
+
+        # dev[0] sees both peers at about the same time, but can add only one
+        # of them per second
+        if "OK" not in dev[0].request("SET mesh_max_new_peers 1"):
+            raise Exception("Failed to set mesh_max_new_peers")
+        id = add_mesh_secure_net(dev[0])
+        dev[0].mesh_group_add(id)
+        check_mesh_group_added(dev[0])
+        peers = []
+        times = []
+        for i in range(2):
+            ev = dev[0].wait_event(["MESH-PEER-CONNECTED"], timeout=10)
+            if ev is None:
+                raise Exception("dev0 did not connect peer %d" % (i + 1))
+            peers.append(ev.split(' ')[1])
+            times.append(time.time())
+        if peers[0] == peers[1]:
+            raise Exception("Same peer reported twice")
+        logger.info("Time between peer connections: %f" % (times[1] - times[0]))
+        if times[1] - times[0] < 0.5:
+            raise Exception("Second peer was not deferred")
+
+        hwsim_utils.test_connectivity(dev[0], dev[1])
+        hwsim_utils.test_connectivity(dev[0], dev[2])
+        for i in range(3):
+            dev[i].mesh_group_remove()
+            check_mesh_group_removed(dev[i])
+    finally:
+        dev[0].request("SET mesh_max_new_peers 10")
+
 def test_wpas_mesh_open_5ghz(dev, apdev):
     """wpa_supplicant open MESH network on 5 GHz band"""
     try:
@@ -0,0 +1,393 @@
+/*
+ * MKA (IEEE 802.1X-2010 KaY) load benchmark
+ * Copyright (c) 2016, Jouni Malinen <j@w1.fi>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This runs a number of KaY instances (stations) on a simulated LAN segment.
+ * Each station creates the same set of MKA participants (CAs) with PSK CAKs,
+ * so every participant ends up with all the other stations as live peers.
+ * MKPDUs are delivered through an in-process l2_packet implementation and
+ * SecY operations are handled by a mock driver that only counts the calls.
+ */
+
+#include "utils/includes.h"
+#include <time.h>
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "l2_packet/l2_packet.h"
+#include "pae/ieee802_1x_kay.h"
+#include "pae/ieee802_1x_kay_i.h"
+
+
+struct mka_station {
+	int idx;
+	u8 addr[ETH_ALEN];
+	struct ieee802_1x_kay *kay;
+	unsigned int secy_ops;
+};
+
+struct l2_packet_data {
+	struct l2_packet_data *next;
+	u8 own_addr[ETH_ALEN];
+	void (*rx_callback)(void *ctx, const u8 *src_addr,
+			    const u8 *buf, size_t len);
+	void *rx_callback_ctx;
+};
+
+static struct l2_packet_data *lan;
+static unsigned int frames_tx, frames_rx;
+
+
+/* Simulated LAN segment */
+
+struct l2_packet_data * l2_packet_init(
+	const char *ifname, const u8 *own_addr, unsigned short protocol,
+	void (*rx_callback)(void *ctx, const u8 *src_addr,
+			    const u8 *buf, size_t len),
+	void *rx_callback_ctx, int l2_hdr)
+{
+	struct l2_packet_data *l2;
+
+	l2 = os_zalloc(sizeof(*l2));
+	if (!l2)
+		return NULL;
+	if (own_addr)
+		os_memcpy(l2->own_addr, own_addr, ETH_ALEN);
+	l2->rx_callback = rx_callback;
+	l2->rx_callback_ctx = rx_callback_ctx;
+	l2->next = lan;
+	lan = l2;
+	return l2;
+}
+
+
+void l2_packet_deinit(struct l2_packet_data *l2)
+{
+	struct l2_packet_data **pos;
+
+	for (pos = &lan; *pos; pos = &(*pos)->next) {
+		if (*pos == l2) {
+			*pos = l2->next;
+			break;
+		}
+	}
+	os_free(l2);
+}
+
+
+int l2_packet_send(struct l2_packet_data *l2, const u8 *dst_addr, u16 proto,
+		   const u8 *buf, size_t len)
+{
+	struct l2_packet_data *dst;
+	const u8 *src;
+
+	if (len < ETH_HLEN)
+		return -1;
+	src = buf + ETH_ALEN;
+	frames_tx++;
+
+	for (dst = lan; dst; dst = dst->next) {
+		if (dst == l2)
+			continue;
+		frames_rx++;
+		dst->rx_callback(dst->rx_callback_ctx, src, buf, len);
+	}
+
+	return 0;
+}
+
+
+/* Mock SecY */
+
+static int mock_secy_op(void *ctx)
+{
+	struct mka_station *sta = ctx;
+
+	sta->secy_ops++;
+	return 0;
+}
+
+static int mock_macsec_init(void *ctx, struct macsec_init_params *params)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_macsec_deinit(void *ctx)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_macsec_get_capability(void *ctx, enum macsec_cap *cap)
+{
+	*cap = MACSEC_CAP_INTEG_AND_CONF;
+	return mock_secy_op(ctx);
+}
+
+static int mock_enable_protect_frames(void *ctx, Boolean enabled)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_set_replay_protect(void *ctx, Boolean enabled, u32 window)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_set_current_cipher_suite(void *ctx, u64 cs)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_enable_controlled_port(void *ctx, Boolean enabled)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_get_receive_lowest_pn(void *ctx, struct receive_sa *sa)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_transmit_pn(void *ctx, struct transmit_sa *sa)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_get_available_sc(void *ctx, u32 *channel)
+{
+	*channel = 0;
+	return mock_secy_op(ctx);
+}
+
+static int mock_create_receive_sc(void *ctx, struct receive_sc *sc,
+				  enum validate_frames vf,
+				  enum confidentiality_offset co)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_receive_sc(void *ctx, struct receive_sc *sc)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_receive_sa(void *ctx, struct receive_sa *sa)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_create_transmit_sc(void *ctx, struct transmit_sc *sc,
+				   enum confidentiality_offset co)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_delete_transmit_sc(void *ctx, struct transmit_sc *sc)
+{
+	return mock_secy_op(ctx);
+}
+
+static int mock_transmit_sa(void *ctx, struct transmit_sa *sa)
+{
+	return mock_secy_op(ctx);
+}
+
+
+static struct ieee802_1x_kay * mka_station_init(struct mka_station *sta)
+{
+	struct ieee802_1x_kay_ctx *kay_ctx;
+	struct ieee802_1x_kay *kay;
+	char ifname[IFNAMSIZ];
+
+	kay_ctx = os_zalloc(sizeof(*kay_ctx));
+	if (!kay_ctx)
+		return NULL;
+
+	kay_ctx->ctx = sta;
+	kay_ctx->macsec_init = mock_macsec_init;
+	kay_ctx->macsec_deinit = mock_macsec_deinit;
+	kay_ctx->macsec_get_capability = mock_macsec_get_capability;
+	kay_ctx->enable_protect_frames = mock_enable_protect_frames;
+	kay_ctx->set_replay_protect = mock_set_replay_protect;
+	kay_ctx->set_current_cipher_suite = mock_set_current_cipher_suite;
+	kay_ctx->enable_controlled_port = mock_enable_controlled_port;
+	kay_ctx->get_receive_lowest_pn = mock_get_receive_lowest_pn;
+	kay_ctx->get_transmit_next_pn = mock_transmit_pn;
+	kay_ctx->set_transmit_next_pn = mock_transmit_pn;
+	kay_ctx->get_available_receive_sc = mock_get_available_sc;
+	kay_ctx->create_receive_sc = mock_create_receive_sc;
+	kay_ctx->delete_receive_sc = mock_receive_sc;
+	kay_ctx->create_receive_sa = mock_receive_sa;
+	kay_ctx->enable_receive_sa = mock_receive_sa;
+	kay_ctx->disable_receive_sa = mock_receive_sa;
+	kay_ctx->get_available_transmit_sc = mock_get_available_sc;
+	kay_ctx->create_transmit_sc = mock_create_transmit_sc;
+	kay_ctx->delete_transmit_sc = mock_delete_transmit_sc;
+	kay_ctx->create_transmit_sa = mock_transmit_sa;
+	kay_ctx->enable_transmit_sa = mock_transmit_sa;
+	kay_ctx->disable_transmit_sa = mock_transmit_sa;
+
+	os_snprintf(ifname, sizeof(ifname), "mka%d", sta->idx);
+	kay = ieee802_1x_kay_init(kay_ctx, SHOULD_SECURE, ifname, sta->addr);
+	if (!kay)
+		os_free(kay_ctx);
+	return kay;
+}
+
+
+static int mka_station_add_participants(struct mka_station *sta,
+					int num_participants)
+{
+	struct mka_key_name ckn;
+	struct mka_key cak;
+	int i;
+
+	for (i = 0; i < num_participants; i++) {
+		/* CKN and CAK are shared by all stations for each CA */
+		ckn.len = 16;
+		os_memset(ckn.name, 0, sizeof(ckn.name));
+		WPA_PUT_BE32(ckn.name, 0x6d6b6100);
+		WPA_PUT_BE32(&ckn.name[12], i);
+		ckn.name[0] = i & 0xff;
+		cak.len = 16;
+		os_memset(cak.key, 0x11, cak.len);
+		WPA_PUT_BE32(cak.key, i);
+
+		if (!ieee802_1x_kay_create_mka(sta->kay, &ckn, &cak, 0, PSK,
+					       FALSE))
+			return -1;
+	}
+
+	return 0;
+}
+
+
+static unsigned int mka_station_live_peers(struct mka_station *sta)
+{
+	struct ieee802_1x_mka_participant *participant;
+	unsigned int count = 0;
+
+	dl_list_for_each(participant, &sta->kay->participant_list,
+			 struct ieee802_1x_mka_participant, list)
+		count += dl_list_len(&participant->live_peers);
+
+	return count;
+}
+
+
+static void test_done(void *eloop_data, void *user_ctx)
+{
+	eloop_terminate();
+}
+
+
+static void usage(void)
+{
+	printf("usage: mka-bench [-s<stations>] [-p<participants>] "
+	       "[-t<seconds>] [-d]\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	struct mka_station *sta;
+	int num_stations = 4, num_participants = 64, duration = 10;
+	int i, c, ret = -1;
+	unsigned int live = 0, secy_ops = 0;
+	clock_t cpu_start, cpu_used;
+
+	for (;;) {
+		c = getopt(argc, argv, "dp:s:t:");
+		if (c < 0)
+			break;
+		switch (c) {
+		case 'd':
+			wpa_debug_level = 0;
+			break;
+		case 'p':
+			num_participants = atoi(optarg);
+			break;
+		case 's':
+			num_stations = atoi(optarg);
+			break;
+		case 't':
+			duration = atoi(optarg);
+			break;
+		default:
+			usage();
+			return -1;
+		}
+	}
+
+	if (num_stations < 2 || num_participants < 1 || duration < 1) {
+		usage();
+		return -1;
+	}
+
+	/* Only the summary is printed unless debugging was requested */
+	if (wpa_debug_level > 0)
+		wpa_debug_level = MSG_ERROR + 1;
+
+	if (os_program_init())
+		return -1;
+
+	if (eloop_init()) {
+		wpa_printf(MSG_ERROR, "Failed to initialize event loop");
+		return -1;
+	}
+
+	sta = os_calloc(num_stations, sizeof(*sta));
+	if (!sta)
+		goto fail;
+
+	for (i = 0; i < num_stations; i++) {
+		sta[i].idx = i;
+		sta[i].addr[0] = 0x02;
+		WPA_PUT_BE32(&sta[i].addr[2], i + 1);
+		sta[i].kay = mka_station_init(&sta[i]);
+		if (!sta[i].kay ||
+		    mka_station_add_participants(&sta[i], num_participants) < 0)
+		{
+			printf("Failed to initialize station %d\n", i);
+			goto fail;
+		}
+	}
+
+	eloop_register_timeout(duration, 0, test_done, NULL, NULL);
+	cpu_start = clock();
+	eloop_run();
+	cpu_used = clock() - cpu_start;
+
+	for (i = 0; i < num_stations; i++) {
+		live += mka_station_live_peers(&sta[i]);
+		secy_ops += sta[i].secy_ops;
+	}
+
+	printf("stations=%d participants=%d duration=%d s\n",
+	       num_stations, num_participants, duration);
+	printf("MKPDUs: tx=%u rx=%u\n", frames_tx, frames_rx);
+	printf("live peers: %u/%u\n", live,
+	       num_stations * num_participants * (num_stations - 1));
+	printf("SecY operations: %u\n", secy_ops);
+	printf("CPU time: %.3f s (%.2f us per received MKPDU)\n",
+	       (double) cpu_used / CLOCKS_PER_SEC,
+	       frames_rx ? (double) cpu_used * 1000000.0 / CLOCKS_PER_SEC /
+	       frames_rx : 0.0);
+
+	ret = live == (unsigned int) (num_stations * num_participants *
+				      (num_stations - 1)) ? 0 : -1;
+
+fail:
+	if (sta) {
+		for (i = 0; i < num_stations; i++)
+			ieee802_1x_kay_deinit(sta[i].kay);
+		os_free(sta);
+	}
+	eloop_destroy();
+	os_program_deinit();
+
+	return ret;
+}
@@ -0,0 +1,139 @@
+/*
+ * Test program for modular exponentiation in the internal bignum
+ * Copyright (c) 2017, Jouni Malinen <j@w1.fi>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This verifies that bignum_exptmod_ct() matches bignum_exptmod() for random
+ * operands and reports the time used by both for 1024-3072 bit moduli.
+ */
+
+#include "includes.h"
+#include <time.h>
+
+#include "common.h"
+#include "tls/bignum.h"
+
+
+static int set_random(struct bignum *n, size_t len, int odd)
+{
+	u8 buf[384];
+
+	if (len > sizeof(buf) || os_get_random(buf, len) < 0)
+		return -1;
+	buf[0] |= 0x80;
+	if (odd)
+		buf[len - 1] |= 0x01;
+	else
+		buf[len - 1] &= ~0x01;
+	return bignum_set_unsigned_bin(n, buf, len);
+}
+
+
+static int test_small(void)
+{
+	struct bignum *a, *b, *c, *d;
+	const u8 base = 4, exp = 13, mod[2] = { 0x01, 0xf1 }; /* 497 */
+	u8 res[2];
+	size_t res_len = sizeof(res);
+	int ret = -1;
+
+	a = bignum_init();
+	b = bignum_init();
+	c = bignum_init();
+	d = bignum_init();
+	if (!a || !b || !c || !d ||
+	    bignum_set_unsigned_bin(a, &base, 1) < 0 ||
+	    bignum_set_unsigned_bin(b, &exp, 1) < 0 ||
+	    bignum_set_unsigned_bin(c, mod, 2) < 0 ||
+	    bignum_exptmod_ct(a, b, c, d) < 0 ||
+	    bignum_get_unsigned_bin(d, res, &res_len) < 0)
+		goto fail;
+
+	/* 4^13 mod 497 = 445 */
+	if (res_len != 2 || WPA_GET_BE16(res) != 445) {
+		printf("4^13 mod 497 returned wrong value\n");
+		goto fail;
+	}
+	ret = 0;
+fail:
+	bignum_deinit(a);
+	bignum_deinit(b);
+	bignum_deinit(c);
+	bignum_deinit(d);
+	return ret;
+}
+
+
+static int test_modexp(size_t bits, int odd, int iterations)
+{
+	struct bignum *a, *b, *c, *d, *e;
+	size_t len = bits / 8;
+	clock_t t, t_var = 0, t_ct = 0;
+	int i, ret = -1;
+
+	a = bignum_init();
+	b = bignum_init();
+	c = bignum_init();
+	d = bignum_init();
+	e = bignum_init();
+	if (!a || !b || !c || !d || !e)
+		goto fail;
+
+	for (i = 0; i < iterations; i++) {
+		if (set_random(c, len, odd) < 0 ||
+		    set_random(a, len - 1, 0) < 0 ||
+		    set_random(b, len - 1, 1) < 0)
+			goto fail;
+
+		t = clock();
+		if (bignum_exptmod(a, b, c, d) < 0)
+			goto fail;
+		t_var += clock() - t;
+
+		t = clock();
+		if (bignum_exptmod_ct(a, b, c, e) < 0)
+			goto fail;
+		t_ct += clock() - t;
+
+		if (bignum_cmp(d, e) != 0) {
+			printf("%u-bit %s modulus: result mismatch\n",
+			       (unsigned int) bits, odd ? "odd" : "even");
+			goto fail;
+		}
+	}
+
+	printf("%u-bit %s modulus: exptmod %.2f ms exptmod_ct %.2f ms\n",
+	       (unsigned int) bits, odd ? "odd" : "even",
+	       (double) t_var * 1000 / CLOCKS_PER_SEC / iterations,
+	       (double) t_ct * 1000 / CLOCKS_PER_SEC / iterations);
+	ret = 0;
+fail:
+	bignum_deinit(a);
+	bignum_deinit(b);
+	bignum_deinit(c);
+	bignum_deinit(d);
+	bignum_deinit(e);
+	return ret;
+}
+
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+
+	if (test_small() < 0 ||
+	    test_modexp(1024, 1, 10) < 0 ||
+	    test_modexp(1024, 0, 5) < 0 ||
+	    test_modexp(2048, 1, 5) < 0 ||
+	    test_modexp(3072, 1, 2) < 0)
+		ret = 1;
+
+	if (ret)
+		printf("FAILED!\n");
+	else
+		printf("OK\n");
+
+	return ret;
+}
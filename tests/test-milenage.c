@@ -697,8 +697,11 @@ int main(int argc, char *argv[])
 {
 	u8 buf[16], buf2[16], buf3[16], buf4[16], buf5[16], opc[16];
 	u8 auts[14], sqn[6], _rand[16];
-	int ret = 0, res, i;
+	u8 bsqn[2 * 6], brand[2 * 16], bautn[2 * 16], bik[2 * 16], bck[2 * 16];
+	u8 bres[2 * 8];
+	int ret = 0, res, i, j, k;
 	const struct milenage_test_set *t;
+	struct milenage_ctx *ctx;
 	size_t res_len;
 
 	wpa_debug_level = 0;
@@ -746,6 +749,55 @@ int main(int argc, char *argv[])
 			printf("- milenage_f5* failed\n");
 			ret++;
 		}
+
+		ctx = milenage_init(opc, t->k);
+		if (!ctx) {
+			printf("- milenage_init failed\n");
+			ret++;
+			continue;
+		}
+		/* The second vector uses SQN and RAND from the next test set */
+		for (j = 0; j < 2; j++) {
+			const struct milenage_test_set *v =
+				&test_sets[(i + j) % NUM_TESTS];
+
+			os_memcpy(bsqn + j * 6, v->sqn, 6);
+			os_memcpy(brand + j * 16, v->rand, 16);
+		}
+		milenage_generate_bulk(ctx, t->amf, bsqn, brand, 2, bautn, bik,
+				       bck, bres);
+		milenage_deinit(ctx);
+		for (j = 0; j < 2; j++) {
+			const u8 *v_sqn = bsqn + j * 6, *v_rand = brand + j * 16;
+
+			if (milenage_f1(opc, t->k, v_rand, v_sqn, t->amf,
+					buf + 8, NULL) ||
+			    milenage_f2345(opc, t->k, v_rand, buf2, buf3, buf4,
+					   buf5, NULL)) {
+				printf("- milenage_generate_bulk reference failed\n");
+				ret++;
+				continue;
+			}
+			/* AUTN = (SQN ^ AK) || AMF || MAC */
+			for (k = 0; k < 6; k++)
+				buf[k] = v_sqn[k] ^ buf5[k];
+			os_memcpy(buf + 6, t->amf, 2);
+			if (memcmp(bautn + j * 16, buf, 16) != 0 ||
+			    memcmp(bik + j * 16, buf4, 16) != 0 ||
+			    memcmp(bck + j * 16, buf3, 16) != 0 ||
+			    memcmp(bres + j * 8, buf2, 8) != 0) {
+				printf("- milenage_generate_bulk vector %d failed\n",
+				       j);
+				ret++;
+			}
+		}
+		/* The first vector must also match the published test set */
+		if (memcmp(bres, t->f2, 8) != 0 ||
+		    memcmp(bck, t->f3, 16) != 0 ||
+		    memcmp(bik, t->f4, 16) != 0) {
+			printf("- milenage_generate_bulk test set mismatch\n");
+			ret++;
+		}
 	}
 
 	printf("milenage_auts test:\n");
@@ -792,6 +844,29 @@ int main(int argc, char *argv[])
 			printf("- gsm_milenage Kc failed\n");
 			ret++;
 		}
+		ctx = milenage_init(g->opc, g->ki);
+		if (ctx) {
+			u8 bsres[2 * 4], bkc[2 * 8], sres2[4], kc2[8];
+			const u8 *rand2 =
+				gsm_test_sets[(i + 1) % NUM_GSM_TESTS].rand;
+
+			/* The second vector uses RAND from the next test set */
+			os_memcpy(brand, g->rand, 16);
+			os_memcpy(brand + 16, rand2, 16);
+			gsm_milenage_bulk(ctx, brand, 2, bsres, bkc);
+			milenage_deinit(ctx);
+			gsm_milenage(g->opc, g->ki, rand2, sres2, kc2);
+			if (memcmp(bsres, sres, 4) != 0 ||
+			    memcmp(bsres + 4, sres2, 4) != 0 ||
+			    memcmp(bkc, g->kc, 8) != 0 ||
+			    memcmp(bkc + 8, kc2, 8) != 0) {
+				printf("- gsm_milenage_bulk failed\n");
+				ret++;
+			}
+		} else {
+			printf("- milenage_init failed\n");
+			ret++;
+		}
 #ifdef GSM_MILENAGE_ALT_SRES
 		if (memcmp(g->sres2, sres, 4) != 0) {
 			printf("- gsm_milenage SRES#2 failed\n");
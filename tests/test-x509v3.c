@@ -19,6 +19,7 @@ int main(int argc, char *argv[])
 	size_t len;
 	struct x509_certificate *certs = NULL, *last = NULL, *cert;
 	int i, reason;
+	unsigned int hits, misses;
 
 	wpa_debug_level = 0;
 
@@ -57,5 +58,17 @@ int main(int argc, char *argv[])
 	}
 	printf("\nCertificate chain is valid\n");
 
+	printf("\n\nValidating certificate chain again\n");
+	if (x509_certificate_chain_validate(last, certs, &reason, 0) < 0) {
+		printf("\nCertificate chain validation failed: %d\n", reason);
+		return -1;
+	}
+	x509_sig_cache_stats(&hits, &misses);
+	printf("\nSignature cache: hits=%u misses=%u\n", hits, misses);
+	if (hits == 0) {
+		printf("Signature cache was not used\n");
+		return -1;
+	}
+
 	return 0;
 }
@@ -0,0 +1,1139 @@
+/*
+ * WPA authenticator/supplicant handshake benchmark
+ * Copyright (c) 2017, Jouni Malinen <j@w1.fi>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This connects a number of supplicant state machines (stations) to a single
+ * authenticator through an in-memory EAPOL frame queue and runs complete
+ * association rounds: 4-way handshake for every station, a group key
+ * handshake after a GTK rekey, an FT reassociation for FT-PSK, and
+ * disassociation. SAE authentication is run with the shared SAE code. For
+ * 802.1X the EAP exchange itself is not run; the authenticator and the
+ * EAPOL supplicant stand-in below both provide a per-station MSK from which
+ * the PMK is derived.
+ */
+
+#include "utils/includes.h"
+#include <time.h>
+
+#include "utils/common.h"
+#include "utils/eloop.h"
+#include "common/defs.h"
+#include "common/ieee802_11_defs.h"
+#include "common/eapol_common.h"
+#include "common/wpa_common.h"
+#include "common/sae.h"
+#include "crypto/sha1.h"
+#include "eapol_supp/eapol_supp_sm.h"
+#include "rsn_supp/wpa.h"
+#include "rsn_supp/preauth.h"
+#include "radius/radius.h"
+#include "ap/wpa_auth.h"
+
+
+#define BENCH_FRAME_MAX 512
+#define BENCH_IES_MAX 512
+
+static const char *bench_passphrase = "benchmark passphrase";
+static const u8 bench_ssid[] = "wpa-bench";
+static const u8 bench_mdid[MOBILITY_DOMAIN_ID_LEN] = { 0xa1, 0xb2 };
+static const char *bench_r0kh_id = "r0kh.wpa-bench.example.com";
+
+enum bench_stage {
+	STAGE_SAE,
+	STAGE_ASSOC,
+	STAGE_M1,
+	STAGE_M2,
+	STAGE_M3,
+	STAGE_M4,
+	STAGE_GTK_REKEY,
+	STAGE_G1,
+	STAGE_G2,
+	STAGE_FT_AUTH,
+	STAGE_FT_REASSOC,
+	STAGE_DISASSOC,
+	STAGE_OTHER,
+	NUM_STAGES
+};
+
+static const char *stage_names[NUM_STAGES] = {
+	"sae", "assoc", "msg1", "msg2", "msg3", "msg4", "gtk-rekey",
+	"group1", "group2", "ft-auth", "ft-reassoc", "disassoc", "other"
+};
+
+struct bench_mode {
+	const char *name;
+	int key_mgmt;
+};
+
+static const struct bench_mode modes[] = {
+	{ "psk", WPA_KEY_MGMT_PSK },
+#ifdef CONFIG_SAE
+	{ "sae", WPA_KEY_MGMT_SAE },
+#endif /* CONFIG_SAE */
+	{ "ft-psk", WPA_KEY_MGMT_FT_PSK },
+	{ "8021x", WPA_KEY_MGMT_IEEE8021X },
+	{ NULL, 0 }
+};
+
+/* Minimal EAPOL supplicant: EAP is considered to have completed */
+struct eapol_sm {
+	u8 msk[64];
+};
+
+struct bench_sta {
+	int idx;
+	u8 addr[ETH_ALEN];
+	struct wpa_sm *wpa;
+	struct eapol_sm eapol;
+	struct wpa_state_machine *auth;
+	enum wpa_states state;
+	int authorized;
+	u8 sae_pmk[PMK_LEN];
+	int ft_status;
+	u8 ft_req[BENCH_IES_MAX];
+	size_t ft_req_len;
+	u8 ft_resp[BENCH_IES_MAX];
+	size_t ft_resp_len;
+};
+
+struct bench_frame {
+	struct bench_sta *sta;
+	int to_ap;
+	size_t len;
+	u8 buf[BENCH_FRAME_MAX];
+};
+
+struct bench_stats {
+	unsigned long count[NUM_STAGES];
+	u64 cpu[NUM_STAGES];
+	unsigned long allocs[NUM_STAGES];
+	unsigned long handshakes;
+};
+
+struct stage_mark {
+	u64 cpu;
+	unsigned long allocs;
+};
+
+static const struct bench_mode *mode;
+static struct bench_stats stats;
+static unsigned long alloc_count;
+
+static u8 ap_addr[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+static u8 ap_mdie[2 + MOBILITY_DOMAIN_ID_LEN + 1];
+static u8 psk[PMK_LEN];
+static struct wpa_authenticator *wpa_auth;
+static struct bench_sta *stas;
+static int num_stas;
+
+static struct bench_frame *queue;
+static size_t queue_size, queue_head, queue_len;
+
+
+/* Heap allocation counting (see --wrap in Makefile) */
+
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t nmemb, size_t size);
+void * __real_realloc(void *ptr, size_t size);
+char * __real_strdup(const char *s);
+
+void * __wrap_malloc(size_t size)
+{
+	alloc_count++;
+	return __real_malloc(size);
+}
+
+
+void * __wrap_calloc(size_t nmemb, size_t size)
+{
+	alloc_count++;
+	return __real_calloc(nmemb, size);
+}
+
+
+void * __wrap_realloc(void *ptr, size_t size)
+{
+	alloc_count++;
+	return __real_realloc(ptr, size);
+}
+
+
+char * __wrap_strdup(const char *s)
+{
+	alloc_count++;
+	return __real_strdup(s);
+}
+
+
+static u64 cpu_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (u64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static void stage_begin(struct stage_mark *mark)
+{
+	mark->allocs = alloc_count;
+	mark->cpu = cpu_time_ns();
+}
+
+
+static void stage_end(enum bench_stage stage, const struct stage_mark *mark)
+{
+	stats.cpu[stage] += cpu_time_ns() - mark->cpu;
+	stats.allocs[stage] += alloc_count - mark->allocs;
+	stats.count[stage]++;
+}
+
+
+static struct bench_sta * get_sta(const u8 *addr)
+{
+	int idx;
+
+	if (!addr)
+		return NULL;
+	idx = WPA_GET_BE32(&addr[2]) - 1;
+	if (idx < 0 || idx >= num_stas)
+		return NULL;
+	return &stas[idx];
+}
+
+
+/* In-memory EAPOL frame queue */
+
+static int queue_frame(struct bench_sta *sta, int to_ap, const u8 *buf,
+		       size_t len)
+{
+	struct bench_frame *frame;
+
+	if (queue_len == queue_size || len > BENCH_FRAME_MAX) {
+		wpa_printf(MSG_ERROR, "wpa-bench: Could not queue %u octet frame",
+			   (unsigned int) len);
+		return -1;
+	}
+
+	frame = &queue[(queue_head + queue_len) % queue_size];
+	frame->sta = sta;
+	frame->to_ap = to_ap;
+	frame->len = len;
+	os_memcpy(frame->buf, buf, len);
+	queue_len++;
+	return 0;
+}
+
+
+static enum bench_stage eapol_key_stage(const u8 *buf, size_t len)
+{
+	const struct ieee802_1x_hdr *hdr;
+	const struct wpa_eapol_key *key;
+	u16 key_info;
+
+	hdr = (const struct ieee802_1x_hdr *) buf;
+	key = (const struct wpa_eapol_key *) (hdr + 1);
+	if (len < sizeof(*hdr) + sizeof(*key) ||
+	    hdr->type != IEEE802_1X_TYPE_EAPOL_KEY)
+		return STAGE_OTHER;
+
+	key_info = WPA_GET_BE16(key->key_info);
+	if (!(key_info & WPA_KEY_INFO_KEY_TYPE))
+		return (key_info & WPA_KEY_INFO_ACK) ? STAGE_G1 : STAGE_G2;
+	if (key_info & WPA_KEY_INFO_ACK)
+		return (key_info & WPA_KEY_INFO_MIC) ? STAGE_M3 : STAGE_M1;
+	return (key_info & WPA_KEY_INFO_SECURE) ? STAGE_M4 : STAGE_M2;
+}
+
+
+static void run_queue(void)
+{
+	struct bench_frame frame;
+	struct stage_mark mark;
+
+	while (queue_len) {
+		os_memcpy(&frame, &queue[queue_head], sizeof(frame));
+		queue_head = (queue_head + 1) % queue_size;
+		queue_len--;
+
+		stage_begin(&mark);
+		if (frame.to_ap)
+			wpa_receive(wpa_auth, frame.sta->auth, frame.buf,
+				    frame.len);
+		else
+			wpa_sm_rx_eapol(frame.sta->wpa, ap_addr, frame.buf,
+					frame.len);
+		stage_end(eapol_key_stage(frame.buf, frame.len), &mark);
+	}
+}
+
+
+/* Authenticator callbacks */
+
+static void auth_logger(void *ctx, const u8 *addr, logger_level level,
+			const char *txt)
+{
+	if (addr)
+		wpa_printf(MSG_DEBUG, "AUTH: " MACSTR " - %s",
+			   MAC2STR(addr), txt);
+	else
+		wpa_printf(MSG_DEBUG, "AUTH: %s", txt);
+}
+
+
+static void auth_disconnect(void *ctx, const u8 *addr, u16 reason)
+{
+	wpa_printf(MSG_INFO, "wpa-bench: Authenticator disconnected " MACSTR
+		   " (reason %u)", MAC2STR(addr), reason);
+}
+
+
+static void auth_set_eapol(void *ctx, const u8 *addr, wpa_eapol_variable var,
+			   int value)
+{
+	struct bench_sta *sta = get_sta(addr);
+
+	if (sta && var == WPA_EAPOL_portValid)
+		sta->authorized = value;
+}
+
+
+static int auth_get_eapol(void *ctx, const u8 *addr, wpa_eapol_variable var)
+{
+	switch (var) {
+	case WPA_EAPOL_keyRun:
+	case WPA_EAPOL_keyAvailable:
+		return wpa_key_mgmt_wpa_ieee8021x(mode->key_mgmt);
+	default:
+		return -1;
+	}
+}
+
+
+static const u8 * auth_get_psk(void *ctx, const u8 *addr,
+			       const u8 *p2p_dev_addr, const u8 *prev_psk)
+{
+	struct bench_sta *sta = get_sta(addr);
+
+	if (prev_psk)
+		return NULL;
+	if (mode->key_mgmt == WPA_KEY_MGMT_SAE)
+		return sta ? sta->sae_pmk : NULL;
+	return psk;
+}
+
+
+static int auth_get_msk(void *ctx, const u8 *addr, u8 *msk, size_t *len)
+{
+	struct bench_sta *sta = get_sta(addr);
+
+	if (!sta || *len < sizeof(sta->eapol.msk))
+		return -1;
+	os_memcpy(msk, sta->eapol.msk, sizeof(sta->eapol.msk));
+	*len = sizeof(sta->eapol.msk);
+	return 0;
+}
+
+
+static int auth_set_key(void *ctx, int vlan_id, enum wpa_alg alg,
+			const u8 *addr, int idx, u8 *key, size_t key_len)
+{
+	return 0;
+}
+
+
+static int auth_get_seqnum(void *ctx, const u8 *addr, int idx, u8 *seq)
+{
+	os_memset(seq, 0, WPA_KEY_RSC_LEN);
+	return 0;
+}
+
+
+static int auth_send_eapol(void *ctx, const u8 *addr, const u8 *data,
+			   size_t data_len, int encrypt)
+{
+	return queue_frame(get_sta(addr), 0, data, data_len);
+}
+
+
+static int auth_for_each_sta(void *ctx,
+			     int (*cb)(struct wpa_state_machine *sm, void *ctx),
+			     void *cb_ctx)
+{
+	int i;
+
+	for (i = 0; i < num_stas; i++) {
+		if (stas[i].auth && cb(stas[i].auth, cb_ctx))
+			return 1;
+	}
+	return 0;
+}
+
+
+static int auth_for_each_auth(void *ctx,
+			      int (*cb)(struct wpa_authenticator *a, void *ctx),
+			      void *cb_ctx)
+{
+	return cb(wpa_auth, cb_ctx);
+}
+
+
+static int auth_send_ether(void *ctx, const u8 *dst, u16 proto,
+			   const u8 *data, size_t data_len)
+{
+	return 0;
+}
+
+
+/* Supplicant callbacks */
+
+static void supp_set_state(void *ctx, enum wpa_states state)
+{
+	struct bench_sta *sta = ctx;
+
+	sta->state = state;
+}
+
+
+static enum wpa_states supp_get_state(void *ctx)
+{
+	struct bench_sta *sta = ctx;
+
+	return sta->state;
+}
+
+
+static void supp_deauthenticate(void *ctx, int reason_code)
+{
+	struct bench_sta *sta = ctx;
+
+	wpa_printf(MSG_INFO, "wpa-bench: Station " MACSTR
+		   " deauthenticated (reason %d)", MAC2STR(sta->addr),
+		   reason_code);
+	sta->state = WPA_DISCONNECTED;
+}
+
+
+static int supp_set_key(void *ctx, enum wpa_alg alg, const u8 *addr,
+			int key_idx, int set_tx, const u8 *seq, size_t seq_len,
+			const u8 *key, size_t key_len)
+{
+	return 0;
+}
+
+
+static void * supp_get_network_ctx(void *ctx)
+{
+	return ctx;
+}
+
+
+static int supp_get_bssid(void *ctx, u8 *bssid)
+{
+	os_memcpy(bssid, ap_addr, ETH_ALEN);
+	return 0;
+}
+
+
+static int supp_ether_send(void *ctx, const u8 *dest, u16 proto,
+			   const u8 *buf, size_t len)
+{
+	return queue_frame(ctx, 1, buf, len);
+}
+
+
+static int supp_get_beacon_ie(void *ctx)
+{
+	return -1;
+}
+
+
+static void supp_cancel_auth_timeout(void *ctx)
+{
+}
+
+
+static u8 * supp_alloc_eapol(void *ctx, u8 type, const void *data,
+			     u16 data_len, size_t *msg_len, void **data_pos)
+{
+	struct ieee802_1x_hdr *hdr;
+
+	*msg_len = sizeof(*hdr) + data_len;
+	hdr = os_malloc(*msg_len);
+	if (hdr == NULL)
+		return NULL;
+
+	hdr->version = 2;
+	hdr->type = type;
+	hdr->length = host_to_be16(data_len);
+
+	if (data)
+		os_memcpy(hdr + 1, data, data_len);
+	else
+		os_memset(hdr + 1, 0, data_len);
+
+	if (data_pos)
+		*data_pos = hdr + 1;
+
+	return (u8 *) hdr;
+}
+
+
+static int supp_pmkid(void *ctx, const u8 *bssid, const u8 *pmkid)
+{
+	return 0;
+}
+
+
+static int supp_mlme_setprotection(void *ctx, const u8 *addr,
+				   int protection_type, int key_type)
+{
+	return 0;
+}
+
+
+static int supp_update_ft_ies(void *ctx, const u8 *md, const u8 *ies,
+			      size_t ies_len)
+{
+	struct bench_sta *sta = ctx;
+
+	if (ies_len > sizeof(sta->ft_req))
+		return -1;
+	os_memcpy(sta->ft_req, ies, ies_len);
+	sta->ft_req_len = ies_len;
+	return 0;
+}
+
+
+/* EAPOL supplicant and preauthentication stand-ins */
+
+int eapol_sm_get_key(struct eapol_sm *sm, u8 *key, size_t len)
+{
+	if (!sm || len > sizeof(sm->msk))
+		return -1;
+	os_memcpy(key, sm->msk, len);
+	return 0;
+}
+
+
+void eapol_sm_notify_tx_eapol_key(struct eapol_sm *sm)
+{
+}
+
+
+void eapol_sm_notify_portValid(struct eapol_sm *sm, Boolean valid)
+{
+}
+
+
+void eapol_sm_notify_eap_success(struct eapol_sm *sm, Boolean success)
+{
+}
+
+
+void eapol_sm_notify_cached(struct eapol_sm *sm)
+{
+}
+
+
+void eapol_sm_register_scard_ctx(struct eapol_sm *sm, void *ctx)
+{
+}
+
+
+void eapol_sm_request_reauth(struct eapol_sm *sm)
+{
+}
+
+
+void eapol_sm_notify_lower_layer_success(struct eapol_sm *sm, int in_eapol_sm)
+{
+}
+
+
+void rsn_preauth_deinit(struct wpa_sm *sm)
+{
+}
+
+
+void rsn_preauth_candidate_process(struct wpa_sm *sm)
+{
+}
+
+
+/* Authenticator PMKSA cache entries are never created from RADIUS */
+
+void radius_free_class(struct radius_class_data *c)
+{
+}
+
+
+int radius_copy_class(struct radius_class_data *dst,
+		      const struct radius_class_data *src)
+{
+	return 0;
+}
+
+
+struct hostapd_data;
+struct sta_info;
+struct vlan_description;
+
+int ap_sta_set_vlan(struct hostapd_data *hapd, struct sta_info *sta,
+		    struct vlan_description *vlan_desc)
+{
+	return 0;
+}
+
+
+/* Authenticator and station setup */
+
+static int bench_ap_init(void)
+{
+	struct wpa_auth_config conf;
+	struct wpa_auth_callbacks cb;
+
+	os_memset(&conf, 0, sizeof(conf));
+	conf.wpa = WPA_PROTO_RSN;
+	conf.wpa_key_mgmt = mode->key_mgmt;
+	conf.wpa_pairwise = WPA_CIPHER_CCMP;
+	conf.rsn_pairwise = WPA_CIPHER_CCMP;
+	conf.wpa_group = WPA_CIPHER_CCMP;
+	conf.eapol_version = 2;
+	conf.ap_mlme = 1;
+	if (wpa_key_mgmt_ft(mode->key_mgmt)) {
+		os_memcpy(conf.ssid, bench_ssid, sizeof(bench_ssid) - 1);
+		conf.ssid_len = sizeof(bench_ssid) - 1;
+		os_memcpy(conf.mobility_domain, bench_mdid,
+			  MOBILITY_DOMAIN_ID_LEN);
+		conf.r0_key_holder_len = os_strlen(bench_r0kh_id);
+		os_memcpy(conf.r0_key_holder, bench_r0kh_id,
+			  conf.r0_key_holder_len);
+		os_memcpy(conf.r1_key_holder, ap_addr, FT_R1KH_ID_LEN);
+		conf.r0_key_lifetime = 10000;
+		conf.reassociation_deadline = 1000;
+	}
+
+	os_memset(&cb, 0, sizeof(cb));
+	cb.logger = auth_logger;
+	cb.disconnect = auth_disconnect;
+	cb.set_eapol = auth_set_eapol;
+	cb.get_eapol = auth_get_eapol;
+	cb.get_psk = auth_get_psk;
+	cb.get_msk = auth_get_msk;
+	cb.set_key = auth_set_key;
+	cb.get_seqnum = auth_get_seqnum;
+	cb.send_eapol = auth_send_eapol;
+	cb.for_each_sta = auth_for_each_sta;
+	cb.for_each_auth = auth_for_each_auth;
+	cb.send_ether = auth_send_ether;
+
+	wpa_auth = wpa_init(ap_addr, &conf, &cb);
+	if (!wpa_auth || wpa_init_keys(wpa_auth) < 0)
+		return -1;
+
+	ap_mdie[0] = WLAN_EID_MOBILITY_DOMAIN;
+	ap_mdie[1] = MOBILITY_DOMAIN_ID_LEN + 1;
+	os_memcpy(&ap_mdie[2], bench_mdid, MOBILITY_DOMAIN_ID_LEN);
+	ap_mdie[2 + MOBILITY_DOMAIN_ID_LEN] = 0; /* FT over-the-air */
+
+	return 0;
+}
+
+
+static int bench_sta_init(struct bench_sta *sta)
+{
+	struct wpa_sm_ctx *ctx;
+	struct rsn_supp_config conf;
+	const u8 *ie;
+	size_t ie_len;
+
+	ctx = os_zalloc(sizeof(*ctx));
+	if (!ctx)
+		return -1;
+
+	ctx->ctx = sta;
+	ctx->msg_ctx = sta;
+	ctx->set_state = supp_set_state;
+	ctx->get_state = supp_get_state;
+	ctx->deauthenticate = supp_deauthenticate;
+	ctx->set_key = supp_set_key;
+	ctx->get_network_ctx = supp_get_network_ctx;
+	ctx->get_bssid = supp_get_bssid;
+	ctx->ether_send = supp_ether_send;
+	ctx->get_beacon_ie = supp_get_beacon_ie;
+	ctx->cancel_auth_timeout = supp_cancel_auth_timeout;
+	ctx->alloc_eapol = supp_alloc_eapol;
+	ctx->add_pmkid = supp_pmkid;
+	ctx->remove_pmkid = supp_pmkid;
+	ctx->mlme_setprotection = supp_mlme_setprotection;
+	ctx->update_ft_ies = supp_update_ft_ies;
+
+	sta->wpa = wpa_sm_init(ctx);
+	if (!sta->wpa)
+		return -1;
+
+	os_memset(&conf, 0, sizeof(conf));
+	conf.network_ctx = sta;
+	conf.allowed_pairwise_cipher = WPA_CIPHER_CCMP;
+	conf.ssid = bench_ssid;
+	conf.ssid_len = sizeof(bench_ssid) - 1;
+	wpa_sm_set_config(sta->wpa, &conf);
+	wpa_sm_set_own_addr(sta->wpa, sta->addr);
+	if (wpa_key_mgmt_wpa_ieee8021x(mode->key_mgmt)) {
+		if (os_get_random(sta->eapol.msk, sizeof(sta->eapol.msk)) < 0)
+			return -1;
+		wpa_sm_set_eapol(sta->wpa, &sta->eapol);
+	}
+
+	wpa_sm_set_param(sta->wpa, WPA_PARAM_PROTO, WPA_PROTO_RSN);
+	wpa_sm_set_param(sta->wpa, WPA_PARAM_RSN_ENABLED, 1);
+	wpa_sm_set_param(sta->wpa, WPA_PARAM_KEY_MGMT, mode->key_mgmt);
+	wpa_sm_set_param(sta->wpa, WPA_PARAM_PAIRWISE, WPA_CIPHER_CCMP);
+	wpa_sm_set_param(sta->wpa, WPA_PARAM_GROUP, WPA_CIPHER_CCMP);
+
+	/* The Beacon frame IEs start with the RSN IE; MDIE follows for FT */
+	ie = wpa_auth_get_wpa_ie(wpa_auth, &ie_len);
+	if (!ie || ie_len < 2 || ie[0] != WLAN_EID_RSN ||
+	    wpa_sm_set_ap_rsn_ie(sta->wpa, ie, 2 + ie[1]) < 0)
+		return -1;
+
+	return 0;
+}
+
+
+/* Association round */
+
+#ifdef CONFIG_SAE
+static int bench_sae(struct bench_sta *sta)
+{
+	struct sae_data sta_sae, ap_sae;
+	struct wpabuf *sta_buf, *ap_buf;
+	size_t pw_len = os_strlen(bench_passphrase);
+	int ret = -1;
+
+	os_memset(&sta_sae, 0, sizeof(sta_sae));
+	os_memset(&ap_sae, 0, sizeof(ap_sae));
+	sta_buf = wpabuf_alloc(SAE_COMMIT_MAX_LEN);
+	ap_buf = wpabuf_alloc(SAE_COMMIT_MAX_LEN);
+	if (!sta_buf || !ap_buf ||
+	    sae_set_group(&sta_sae, 19) < 0 ||
+	    sae_set_group(&ap_sae, 19) < 0 ||
+	    sae_prepare_commit(sta->addr, ap_addr,
+			       (const u8 *) bench_passphrase, pw_len,
+			       &sta_sae) < 0 ||
+	    sae_prepare_commit(ap_addr, sta->addr,
+			       (const u8 *) bench_passphrase, pw_len,
+			       &ap_sae) < 0)
+		goto fail;
+
+	/* Commit exchange */
+	sae_write_commit(&sta_sae, sta_buf, NULL);
+	sae_write_commit(&ap_sae, ap_buf, NULL);
+	if (sae_parse_commit(&ap_sae, wpabuf_head(sta_buf),
+			     wpabuf_len(sta_buf), NULL, NULL, NULL) !=
+	    WLAN_STATUS_SUCCESS ||
+	    sae_process_commit(&ap_sae) < 0 ||
+	    sae_parse_commit(&sta_sae, wpabuf_head(ap_buf),
+			     wpabuf_len(ap_buf), NULL, NULL, NULL) !=
+	    WLAN_STATUS_SUCCESS ||
+	    sae_process_commit(&sta_sae) < 0)
+		goto fail;
+
+	/* Confirm exchange */
+	wpabuf_free(sta_buf);
+	wpabuf_free(ap_buf);
+	sta_buf = wpabuf_alloc(SAE_CONFIRM_MAX_LEN);
+	ap_buf = wpabuf_alloc(SAE_CONFIRM_MAX_LEN);
+	if (!sta_buf || !ap_buf)
+		goto fail;
+	sae_write_confirm(&sta_sae, sta_buf);
+	sae_write_confirm(&ap_sae, ap_buf);
+	if (sae_check_confirm(&ap_sae, wpabuf_head(sta_buf),
+			      wpabuf_len(sta_buf)) < 0 ||
+	    sae_check_confirm(&sta_sae, wpabuf_head(ap_buf),
+			      wpabuf_len(ap_buf)) < 0)
+		goto fail;
+
+	os_memcpy(sta->sae_pmk, ap_sae.pmk, PMK_LEN);
+	wpa_auth_pmksa_add_sae(wpa_auth, sta->addr, ap_sae.pmk, ap_sae.pmkid);
+	wpa_sm_set_pmk(sta->wpa, sta_sae.pmk, PMK_LEN, sta_sae.pmkid, ap_addr);
+	ret = 0;
+fail:
+	sae_clear_data(&sta_sae);
+	sae_clear_data(&ap_sae);
+	wpabuf_free(sta_buf);
+	wpabuf_free(ap_buf);
+	return ret;
+}
+#endif /* CONFIG_SAE */
+
+
+static int bench_assoc(struct bench_sta *sta)
+{
+	u8 ie[80], resp[BENCH_IES_MAX], *pos;
+	size_t ie_len = sizeof(ie);
+	int ft = wpa_key_mgmt_ft(mode->key_mgmt);
+
+	/* Station: initial (mobility domain) association */
+	wpa_reset_ft_completed(sta->wpa);
+	if (mode->key_mgmt == WPA_KEY_MGMT_PSK ||
+	    mode->key_mgmt == WPA_KEY_MGMT_FT_PSK)
+		wpa_sm_set_pmk(sta->wpa, psk, PMK_LEN, NULL, NULL);
+	if (ft && wpa_sm_set_ft_params(sta->wpa, ap_mdie, sizeof(ap_mdie)) < 0)
+		return -1;
+	if (wpa_sm_set_assoc_wpa_ie_default(sta->wpa, ie, &ie_len) < 0)
+		return -1;
+
+	/* Authenticator: (Re)Association Request processing */
+	sta->authorized = 0;
+	sta->auth = wpa_auth_sta_init(wpa_auth, sta->addr, NULL);
+	if (!sta->auth ||
+	    wpa_validate_wpa_ie(wpa_auth, sta->auth, ie, ie_len,
+				ft ? &ap_mdie[2] : NULL,
+				ft ? ap_mdie[1] : 0) != WPA_IE_OK)
+		return -1;
+	if (ft) {
+		pos = wpa_sm_write_assoc_resp_ies(sta->auth, resp, sizeof(resp),
+						  WLAN_AUTH_OPEN, ie, ie_len);
+		if (!pos ||
+		    wpa_sm_set_ft_params(sta->wpa, resp, pos - resp) < 0)
+			return -1;
+	}
+
+	sta->state = WPA_ASSOCIATED;
+	wpa_sm_notify_assoc(sta->wpa, ap_addr);
+
+	/* Authenticator: start 4-way handshake */
+	wpa_auth_sm_event(sta->auth, WPA_ASSOC);
+	return wpa_auth_sta_associated(wpa_auth, sta->auth);
+}
+
+
+static void ft_auth_resp(void *ctx, const u8 *dst, const u8 *bssid,
+			 u16 auth_transaction, u16 status, const u8 *ies,
+			 size_t ies_len)
+{
+	struct bench_sta *sta = ctx;
+
+	sta->ft_status = status;
+	sta->ft_resp_len = 0;
+	if (ies_len <= sizeof(sta->ft_resp)) {
+		os_memcpy(sta->ft_resp, ies, ies_len);
+		sta->ft_resp_len = ies_len;
+	}
+}
+
+
+static int bench_ft(struct bench_sta *sta)
+{
+	struct stage_mark mark;
+	struct wpa_ft_ies parse;
+	u8 resp[BENCH_IES_MAX], *pos;
+
+	/*
+	 * FT over-the-air back to the same AP using the PMK-R1 derived during
+	 * the initial mobility domain association.
+	 */
+	stage_begin(&mark);
+	sta->ft_req_len = 0;
+	if (wpa_ft_prepare_auth_request(sta->wpa, ap_mdie) < 0 ||
+	    !sta->ft_req_len)
+		return -1;
+
+	wpa_auth_sta_deinit(sta->auth);
+	sta->authorized = 0;
+	sta->auth = wpa_auth_sta_init(wpa_auth, sta->addr, NULL);
+	if (!sta->auth)
+		return -1;
+	sta->ft_status = -1;
+	wpa_ft_process_auth(sta->auth, ap_addr, WLAN_AUTH_FT, sta->ft_req,
+			    sta->ft_req_len, ft_auth_resp, sta);
+	if (sta->ft_status != WLAN_STATUS_SUCCESS)
+		return -1;
+
+	sta->ft_req_len = 0;
+	if (wpa_ft_process_response(sta->wpa, sta->ft_resp, sta->ft_resp_len,
+				    0, ap_addr, NULL, 0) < 0 ||
+	    !sta->ft_req_len)
+		return -1;
+	stage_end(STAGE_FT_AUTH, &mark);
+
+	stage_begin(&mark);
+	if (wpa_ft_parse_ies(sta->ft_req, sta->ft_req_len, &parse) < 0 ||
+	    !parse.rsn || !parse.mdie ||
+	    wpa_validate_wpa_ie(wpa_auth, sta->auth, parse.rsn - 2,
+				parse.rsn_len + 2, parse.mdie,
+				parse.mdie_len) != WPA_IE_OK ||
+	    wpa_ft_validate_reassoc(sta->auth, sta->ft_req, sta->ft_req_len) !=
+	    WLAN_STATUS_SUCCESS)
+		return -1;
+	pos = wpa_sm_write_assoc_resp_ies(sta->auth, resp, sizeof(resp),
+					  WLAN_AUTH_FT, sta->ft_req,
+					  sta->ft_req_len);
+	if (!pos)
+		return -1;
+	wpa_auth_sm_event(sta->auth, WPA_ASSOC_FT);
+	wpa_auth_sta_associated(wpa_auth, sta->auth);
+
+	if (wpa_ft_validate_reassoc_resp(sta->wpa, resp, pos - resp,
+					 ap_addr) < 0)
+		return -1;
+	sta->state = WPA_ASSOCIATED;
+	wpa_sm_notify_assoc(sta->wpa, ap_addr);
+	stage_end(STAGE_FT_REASSOC, &mark);
+
+	return sta->state == WPA_COMPLETED ? 0 : -1;
+}
+
+
+static int bench_round(void)
+{
+	struct stage_mark mark;
+	unsigned long group;
+	int i;
+
+	for (i = 0; i < num_stas; i++) {
+		struct bench_sta *sta = &stas[i];
+
+#ifdef CONFIG_SAE
+		if (mode->key_mgmt == WPA_KEY_MGMT_SAE) {
+			stage_begin(&mark);
+			if (bench_sae(sta) < 0) {
+				printf("SAE failed for station %d\n", i);
+				return -1;
+			}
+			stage_end(STAGE_SAE, &mark);
+		}
+#endif /* CONFIG_SAE */
+
+		stage_begin(&mark);
+		if (bench_assoc(sta) < 0) {
+			printf("Association failed for station %d\n", i);
+			return -1;
+		}
+		stage_end(STAGE_ASSOC, &mark);
+	}
+
+	/* 4-way handshakes for all stations are interleaved in the queue */
+	run_queue();
+	for (i = 0; i < num_stas; i++) {
+		if (!stas[i].authorized || stas[i].state != WPA_COMPLETED) {
+			printf("4-way handshake failed for station %d\n", i);
+			return -1;
+		}
+	}
+	stats.handshakes += num_stas;
+
+	/* Group key handshake with every station */
+	group = stats.count[STAGE_G2];
+	stage_begin(&mark);
+	wpa_auth_force_gtk_rekey(wpa_auth);
+	stage_end(STAGE_GTK_REKEY, &mark);
+	run_queue();
+	if (stats.count[STAGE_G2] - group != (unsigned long) num_stas) {
+		printf("Group key handshake failed\n");
+		return -1;
+	}
+
+	if (wpa_key_mgmt_ft(mode->key_mgmt)) {
+		for (i = 0; i < num_stas; i++) {
+			if (bench_ft(&stas[i]) < 0) {
+				printf("FT failed for station %d\n", i);
+				return -1;
+			}
+		}
+	}
+
+	for (i = 0; i < num_stas; i++) {
+		stage_begin(&mark);
+		wpa_sm_notify_disassoc(stas[i].wpa);
+		stas[i].state = WPA_DISCONNECTED;
+		wpa_auth_sm_event(stas[i].auth, WPA_DISASSOC);
+		wpa_auth_sta_deinit(stas[i].auth);
+		stas[i].auth = NULL;
+		stage_end(STAGE_DISASSOC, &mark);
+	}
+
+	return 0;
+}
+
+
+static void bench_deinit(void)
+{
+	int i;
+
+	for (i = 0; stas && i < num_stas; i++) {
+		wpa_auth_sta_deinit(stas[i].auth);
+		wpa_sm_deinit(stas[i].wpa);
+	}
+	os_free(stas);
+	stas = NULL;
+	wpa_deinit(wpa_auth);
+	wpa_auth = NULL;
+	os_free(queue);
+	queue = NULL;
+}
+
+
+static void print_stats(unsigned int rounds, double wall, u64 cpu,
+			unsigned long allocs)
+{
+	int i;
+
+	printf("%s: %d stations, %u rounds, %lu handshakes in %.3f s\n",
+	       mode->name, num_stas, rounds, stats.handshakes, wall);
+	printf("  %.1f handshakes/s, %.2f us CPU and %.1f allocations per handshake\n",
+	       wall > 0 ? stats.handshakes / wall : 0.0,
+	       stats.handshakes ?
+	       (double) cpu / 1000.0 / stats.handshakes : 0.0,
+	       stats.handshakes ? (double) allocs / stats.handshakes : 0.0);
+	printf("  %-12s %10s %12s %10s\n", "stage", "count", "usec/op",
+	       "allocs/op");
+	for (i = 0; i < NUM_STAGES; i++) {
+		if (!stats.count[i])
+			continue;
+		printf("  %-12s %10lu %12.2f %10.1f\n", stage_names[i],
+		       stats.count[i],
+		       (double) stats.cpu[i] / 1000.0 / stats.count[i],
+		       (double) stats.allocs[i] / stats.count[i]);
+	}
+}
+
+
+static int bench_run(int duration)
+{
+	struct os_reltime start, now, diff;
+	unsigned int rounds = 0;
+	unsigned long allocs;
+	u64 cpu;
+	int i, ret = -1;
+
+	os_memset(&stats, 0, sizeof(stats));
+	queue_size = 4 * num_stas;
+	queue_head = queue_len = 0;
+	queue = os_calloc(queue_size, sizeof(*queue));
+	stas = os_calloc(num_stas, sizeof(*stas));
+	if (!queue || !stas || bench_ap_init() < 0) {
+		printf("Failed to initialize authenticator\n");
+		goto fail;
+	}
+
+	for (i = 0; i < num_stas; i++) {
+		stas[i].idx = i;
+		stas[i].addr[0] = 0x02;
+		WPA_PUT_BE32(&stas[i].addr[2], i + 1);
+		if (bench_sta_init(&stas[i]) < 0) {
+			printf("Failed to initialize station %d\n", i);
+			goto fail;
+		}
+	}
+
+	allocs = alloc_count;
+	cpu = cpu_time_ns();
+	os_get_reltime(&start);
+	do {
+		if (bench_round() < 0)
+			goto fail;
+		rounds++;
+		os_get_reltime(&now);
+		os_reltime_sub(&now, &start, &diff);
+	} while (diff.sec * 1000 + diff.usec / 1000 < duration);
+	cpu = cpu_time_ns() - cpu;
+	allocs = alloc_count - allocs;
+
+	print_stats(rounds, diff.sec + diff.usec / 1000000.0, cpu, allocs);
+	ret = 0;
+fail:
+	bench_deinit();
+	return ret;
+}
+
+
+static void usage(void)
+{
+	const struct bench_mode *m;
+
+	printf("usage: wpa-bench [-d] [-m<mode>] [-s<stations>] [-t<msec>]\n"
+	       "modes:");
+	for (m = modes; m->name; m++)
+		printf(" %s", m->name);
+	printf("\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	const char *mode_name = NULL;
+	int num = 16, duration = 1000;
+	int c, found = 0, ret = 0;
+
+	for (;;) {
+		c = getopt(argc, argv, "dm:s:t:");
+		if (c < 0)
+			break;
+		switch (c) {
+		case 'd':
+			wpa_debug_level = 0;
+			break;
+		case 'm':
+			mode_name = optarg;
+			break;
+		case 's':
+			num = atoi(optarg);
+			break;
+		case 't':
+			duration = atoi(optarg);
+			break;
+		default:
+			usage();
+			return -1;
+		}
+	}
+
+	if (num < 1 || num > 0xffff || duration < 1) {
+		usage();
+		return -1;
+	}
+
+	/* Only the summary is printed unless debugging was requested */
+	if (wpa_debug_level > 0)
+		wpa_debug_level = MSG_ERROR + 1;
+
+	if (os_program_init())
+		return -1;
+
+	if (eloop_init()) {
+		wpa_printf(MSG_ERROR, "Failed to initialize event loop");
+		return -1;
+	}
+
+	if (pbkdf2_sha1(bench_passphrase, bench_ssid, sizeof(bench_ssid) - 1,
+			4096, psk, PMK_LEN) < 0)
+		goto fail;
+
+	num_stas = num;
+	for (mode = modes; mode->name; mode++) {
+		if (mode_name && os_strcmp(mode_name, mode->name) != 0)
+			continue;
+		found = 1;
+		if (bench_run(duration) < 0) {
+			printf("%s: FAILED\n", mode->name);
+			ret = 1;
+		}
+	}
+
+	if (!found) {
+		usage();
+		ret = -1;
+	}
+
+fail:
+	eloop_destroy();
+	os_program_deinit();
+
+	return ret;
+}
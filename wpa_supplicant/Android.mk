@@ -92,6 +92,7 @@ OBJS += eap_register.c
 OBJS += src/utils/common.c
 OBJS += src/utils/wpa_debug.c
 OBJS += src/utils/wpabuf.c
+OBJS += src/utils/metrics.c
 OBJS += wmm_ac.c
 OBJS_p = wpa_passphrase.c
 OBJS_p += src/utils/common.c
@@ -1055,6 +1056,9 @@ L_CFLAGS += -DCONFIG_INTERNAL_LIBTOMMATH
 ifdef CONFIG_INTERNAL_LIBTOMMATH_FAST
 L_CFLAGS += -DLTM_FAST
 endif
+ifdef CONFIG_INTERNAL_LIBTOMMATH_CT
+L_CFLAGS += -DLTM_CT
+endif
 else
 LIBS += -ltommath
 LIBS_p += -ltommath
@@ -30,6 +30,31 @@
 #define WPA_BSS_RATES_CHANGED_FLAG	BIT(7)
 #define WPA_BSS_IES_CHANGED_FLAG	BIT(8)
 
+/* Maximum number of ANQP data instances retained from removed BSS entries */
+#define WPA_BSS_ANQP_CACHE_MAX_ENTRIES	16
+/* Maximum age (in seconds) of ANQP data retained from a removed BSS entry */
+#define WPA_BSS_ANQP_CACHE_MAX_AGE	300
+
+
+#ifdef CONFIG_INTERWORKING
+/**
+ * struct wpa_bss_anqp_cache_entry - ANQP data retained from a removed BSS
+ *
+ * ANQP information is shared by all APs in the same ANQP domain within a
+ * homogeneous ESS, so it remains valid for a while after the specific BSS
+ * entry that was used to fetch it has expired from the BSS table.
+ */
+struct wpa_bss_anqp_cache_entry {
+	struct dl_list list;
+	u8 hessid[ETH_ALEN];
+	u8 ssid[SSID_MAX_LEN];
+	size_t ssid_len;
+	u16 domain_id;
+	struct os_reltime added;
+	struct wpa_bss_anqp *anqp;
+};
+#endif /* CONFIG_INTERWORKING */
+
 
 static void wpa_bss_set_hessid(struct wpa_bss *bss)
 {
@@ -189,6 +214,171 @@ static void wpa_bss_anqp_free(struct wpa_bss_anqp *anqp)
 }
 
 
+/**
+ * wpa_bss_anqp_domain_id - Get the ANQP Domain ID advertised by a BSS
+ * @bss: BSS entry
+ * Returns: ANQP Domain ID from the Hotspot 2.0 Indication element or 0 if
+ *	not advertised
+ */
+u16 wpa_bss_anqp_domain_id(const struct wpa_bss *bss)
+{
+#ifdef CONFIG_HS20
+	const u8 *ie, *pos, *end;
+
+	ie = wpa_bss_get_vendor_ie(bss, HS20_IE_VENDOR_TYPE);
+	if (ie == NULL || ie[1] < 5)
+		return 0;
+	end = ie + 2 + ie[1];
+	pos = ie + 6; /* Hotspot Configuration */
+	if (!(*pos & HS20_ANQP_DOMAIN_ID_PRESENT))
+		return 0;
+	if (*pos++ & HS20_PPS_MO_ID_PRESENT)
+		pos += 2;
+	if (end - pos < 2)
+		return 0;
+	return WPA_GET_LE16(pos);
+#else /* CONFIG_HS20 */
+	return 0;
+#endif /* CONFIG_HS20 */
+}
+
+
+#ifdef CONFIG_INTERWORKING
+
+static void wpa_bss_anqp_cache_entry_free(struct wpa_bss_anqp_cache_entry *e)
+{
+	dl_list_del(&e->list);
+	wpa_bss_anqp_free(e->anqp);
+	os_free(e);
+}
+
+
+static void wpa_bss_anqp_cache_expire(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_bss_anqp_cache_entry *e, *n;
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	dl_list_for_each_safe(e, n, &wpa_s->anqp_cache,
+			      struct wpa_bss_anqp_cache_entry, list) {
+		if (os_reltime_expired(&now, &e->added,
+				       WPA_BSS_ANQP_CACHE_MAX_AGE))
+			wpa_bss_anqp_cache_entry_free(e);
+	}
+}
+
+
+static struct wpa_bss_anqp_cache_entry *
+wpa_bss_anqp_cache_find(struct wpa_supplicant *wpa_s, const struct wpa_bss *bss,
+			u16 domain_id)
+{
+	struct wpa_bss_anqp_cache_entry *e;
+
+	dl_list_for_each(e, &wpa_s->anqp_cache,
+			 struct wpa_bss_anqp_cache_entry, list) {
+		if (e->domain_id == domain_id &&
+		    os_memcmp(e->hessid, bss->hessid, ETH_ALEN) == 0 &&
+		    e->ssid_len == bss->ssid_len &&
+		    os_memcmp(e->ssid, bss->ssid, bss->ssid_len) == 0)
+			return e;
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Take over the ANQP data reference from a BSS entry that is being removed if
+ * no other BSS entry shares it and it contains credential matching information.
+ */
+static void wpa_bss_anqp_cache_add(struct wpa_supplicant *wpa_s,
+				  struct wpa_bss *bss)
+{
+	struct wpa_bss_anqp *anqp = bss->anqp;
+	struct wpa_bss_anqp_cache_entry *e;
+	u16 domain_id;
+
+	if (anqp == NULL || anqp->users > 1 || is_zero_ether_addr(bss->hessid))
+		return;
+	if (anqp->roaming_consortium == NULL && anqp->nai_realm == NULL &&
+	    anqp->anqp_3gpp == NULL && anqp->domain_name == NULL)
+		return;
+
+	wpa_bss_anqp_cache_expire(wpa_s);
+	domain_id = wpa_bss_anqp_domain_id(bss);
+	e = wpa_bss_anqp_cache_find(wpa_s, bss, domain_id);
+	if (e)
+		wpa_bss_anqp_cache_entry_free(e);
+	else if (dl_list_len(&wpa_s->anqp_cache) >=
+		 WPA_BSS_ANQP_CACHE_MAX_ENTRIES)
+		wpa_bss_anqp_cache_entry_free(
+			dl_list_last(&wpa_s->anqp_cache,
+				     struct wpa_bss_anqp_cache_entry, list));
+
+	e = os_zalloc(sizeof(*e));
+	if (e == NULL)
+		return;
+	os_memcpy(e->hessid, bss->hessid, ETH_ALEN);
+	os_memcpy(e->ssid, bss->ssid, bss->ssid_len);
+	e->ssid_len = bss->ssid_len;
+	e->domain_id = domain_id;
+	os_get_reltime(&e->added);
+	e->anqp = anqp;
+	bss->anqp = NULL;
+	dl_list_add(&wpa_s->anqp_cache, &e->list);
+
+	wpa_dbg(wpa_s, MSG_DEBUG, "BSS: Retain ANQP data for HESSID " MACSTR
+		" ANQP Domain ID %u", MAC2STR(e->hessid), e->domain_id);
+}
+
+
+static void wpa_bss_anqp_cache_flush(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_bss_anqp_cache_entry *e, *n;
+
+	dl_list_for_each_safe(e, n, &wpa_s->anqp_cache,
+			      struct wpa_bss_anqp_cache_entry, list)
+		wpa_bss_anqp_cache_entry_free(e);
+}
+
+#endif /* CONFIG_INTERWORKING */
+
+
+/**
+ * wpa_bss_anqp_cache_get - Get retained ANQP data for a BSS entry
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @bss: BSS entry without ANQP data
+ * Returns: ANQP data from an expired BSS entry in the same HESSID and ANQP
+ *	domain or %NULL if not available
+ *
+ * The caller takes over the reference to the returned ANQP data and is
+ * expected to store it in bss->anqp.
+ */
+struct wpa_bss_anqp * wpa_bss_anqp_cache_get(struct wpa_supplicant *wpa_s,
+					     const struct wpa_bss *bss)
+{
+#ifdef CONFIG_INTERWORKING
+	struct wpa_bss_anqp_cache_entry *e;
+	struct wpa_bss_anqp *anqp;
+
+	if (is_zero_ether_addr(bss->hessid))
+		return NULL;
+
+	wpa_bss_anqp_cache_expire(wpa_s);
+	e = wpa_bss_anqp_cache_find(wpa_s, bss, wpa_bss_anqp_domain_id(bss));
+	if (e == NULL)
+		return NULL;
+
+	anqp = e->anqp;
+	e->anqp = NULL;
+	wpa_bss_anqp_cache_entry_free(e);
+	return anqp;
+#else /* CONFIG_INTERWORKING */
+	return NULL;
+#endif /* CONFIG_INTERWORKING */
+}
+
+
 static void wpa_bss_update_pending_connect(struct wpa_supplicant *wpa_s,
 					   struct wpa_bss *old_bss,
 					   struct wpa_bss *new_bss)
@@ -238,6 +428,9 @@ void wpa_bss_remove(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 		" SSID '%s' due to %s", bss->id, MAC2STR(bss->bssid),
 		wpa_ssid_txt(bss->ssid, bss->ssid_len), reason);
 	wpas_notify_bss_removed(wpa_s, bss->bssid, bss->id);
+#ifdef CONFIG_INTERWORKING
+	wpa_bss_anqp_cache_add(wpa_s, bss);
+#endif /* CONFIG_INTERWORKING */
 	wpa_bss_anqp_free(bss->anqp);
 	os_free(bss);
 }
@@ -419,6 +612,13 @@ static int wpa_bss_remove_oldest(struct wpa_supplicant *wpa_s)
 }
 
 
+static void wpa_bss_index_ies(struct wpa_bss *bss)
+{
+	ieee802_11_elem_index_build(&bss->ie_index, (const u8 *) (bss + 1),
+				    bss->ie_len);
+}
+
+
 static struct wpa_bss * wpa_bss_add(struct wpa_supplicant *wpa_s,
 				    const u8 *ssid, size_t ssid_len,
 				    struct wpa_scan_res *res,
@@ -437,6 +637,7 @@ static struct wpa_bss * wpa_bss_add(struct wpa_supplicant *wpa_s,
 	bss->ie_len = res->ie_len;
 	bss->beacon_ie_len = res->beacon_ie_len;
 	os_memcpy(bss + 1, res + 1, res->ie_len + res->beacon_ie_len);
+	wpa_bss_index_ies(bss);
 	wpa_bss_set_hessid(bss);
 
 	if (wpa_s->num_bss + 1 > wpa_s->conf->bss_max_count &&
@@ -625,6 +826,7 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 		os_memcpy(bss + 1, res + 1, res->ie_len + res->beacon_ie_len);
 		bss->ie_len = res->ie_len;
 		bss->beacon_ie_len = res->beacon_ie_len;
+		wpa_bss_index_ies(bss);
 	} else {
 		struct wpa_bss *nbss;
 		struct dl_list *prev = bss->list_id.prev;
@@ -647,6 +849,7 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 				  res->ie_len + res->beacon_ie_len);
 			bss->ie_len = res->ie_len;
 			bss->beacon_ie_len = res->beacon_ie_len;
+			wpa_bss_index_ies(bss);
 		}
 		dl_list_add(prev, &bss->list_id);
 	}
@@ -905,6 +1108,9 @@ int wpa_bss_init(struct wpa_supplicant *wpa_s)
 {
 	dl_list_init(&wpa_s->bss);
 	dl_list_init(&wpa_s->bss_id);
+#ifdef CONFIG_INTERWORKING
+	dl_list_init(&wpa_s->anqp_cache);
+#endif /* CONFIG_INTERWORKING */
 	return 0;
 }
 
@@ -927,6 +1133,10 @@ void wpa_bss_flush(struct wpa_supplicant *wpa_s)
 			continue;
 		wpa_bss_remove(wpa_s, bss, __func__);
 	}
+
+#ifdef CONFIG_INTERWORKING
+	wpa_bss_anqp_cache_flush(wpa_s);
+#endif /* CONFIG_INTERWORKING */
 }
 
 
@@ -1062,7 +1272,9 @@ struct wpa_bss * wpa_bss_get_id_range(struct wpa_supplicant *wpa_s,
  */
 const u8 * wpa_bss_get_ie(const struct wpa_bss *bss, u8 ie)
 {
-	return get_ie((const u8 *) (bss + 1), bss->ie_len, ie);
+	return ieee802_11_elem_index_get(&bss->ie_index,
+					 (const u8 *) (bss + 1), bss->ie_len,
+					 ie);
 }
 
 
@@ -1079,8 +1291,11 @@ const u8 * wpa_bss_get_vendor_ie(const struct wpa_bss *bss, u32 vendor_type)
 {
 	const u8 *end, *pos;
 
-	pos = (const u8 *) (bss + 1);
-	end = pos + bss->ie_len;
+	/* Start from the first Vendor Specific element, if any */
+	pos = wpa_bss_get_ie(bss, WLAN_EID_VENDOR_SPECIFIC);
+	if (!pos)
+		return NULL;
+	end = (const u8 *) (bss + 1) + bss->ie_len;
 
 	while (end - pos > 1) {
 		if (2 + pos[1] > end - pos)
@@ -1148,13 +1363,15 @@ struct wpabuf * wpa_bss_get_vendor_ie_multi(const struct wpa_bss *bss,
 	struct wpabuf *buf;
 	const u8 *end, *pos;
 
+	pos = wpa_bss_get_ie(bss, WLAN_EID_VENDOR_SPECIFIC);
+	if (!pos)
+		return NULL;
+	end = (const u8 *) (bss + 1) + bss->ie_len;
+
 	buf = wpabuf_alloc(bss->ie_len);
 	if (buf == NULL)
 		return NULL;
 
-	pos = (const u8 *) (bss + 1);
-	end = pos + bss->ie_len;
-
 	while (end - pos > 1) {
 		if (2 + pos[1] > end - pos)
 			break;
@@ -9,6 +9,8 @@
 #ifndef BSS_H
 #define BSS_H
 
+#include "common/ieee802_11_common.h"
+
 struct wpa_scan_res;
 
 #define WPA_BSS_QUAL_INVALID		BIT(0)
@@ -101,6 +103,8 @@ struct wpa_bss {
 	int snr;
 	/** ANQP data */
 	struct wpa_bss_anqp *anqp;
+	/** Index of the elements in the following IE field */
+	struct ieee802_11_elem_index ie_index;
 	/** Length of the following IE field in octets (from Probe Response) */
 	size_t ie_len;
 	/** Length of the following Beacon IE field in octets */
@@ -144,6 +148,9 @@ int wpa_bss_get_max_rate(const struct wpa_bss *bss);
 int wpa_bss_get_bit_rates(const struct wpa_bss *bss, u8 **rates);
 struct wpa_bss_anqp * wpa_bss_anqp_alloc(void);
 int wpa_bss_anqp_unshare_alloc(struct wpa_bss *bss);
+u16 wpa_bss_anqp_domain_id(const struct wpa_bss *bss);
+struct wpa_bss_anqp * wpa_bss_anqp_cache_get(struct wpa_supplicant *wpa_s,
+					     const struct wpa_bss *bss);
 
 static inline int bss_is_dmg(const struct wpa_bss *bss)
 {
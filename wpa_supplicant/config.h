@@ -18,6 +18,7 @@
 #define DEFAULT_USER_MPM 1
 #define DEFAULT_MAX_PEER_LINKS 99
 #define DEFAULT_MESH_MAX_INACTIVITY 300
+#define DEFAULT_MESH_MAX_NEW_PEERS 10
 /*
  * The default dot11RSNASAERetransPeriod is defined as 40 ms in the standard,
  * but use 1000 ms in practice to avoid issues on low power CPUs.
@@ -41,6 +42,7 @@
 #define DEFAULT_P2P_GO_CTWINDOW 0
 #define DEFAULT_WPA_RSC_RELAXATION 1
 #define DEFAULT_MBO_CELL_CAPA MBO_CELL_CAPA_NOT_SUPPORTED
+#define DEFAULT_DBUS_PROP_CHANGED_DELAY 5
 
 #include "config_ssid.h"
 #include "wps/wps.h"
@@ -334,6 +336,7 @@ struct wpa_cred {
 #define CFG_CHANGED_NFC_PASSWORD_TOKEN BIT(15)
 #define CFG_CHANGED_P2P_PASSPHRASE_LEN BIT(16)
 #define CFG_CHANGED_SCHED_SCAN_PLANS BIT(17)
+#define CFG_CHANGED_DBUS BIT(18)
 
 /**
  * struct wpa_config - wpa_supplicant configuration data
@@ -1207,6 +1210,17 @@ struct wpa_config {
 	 */
 	int mesh_max_inactivity;
 
+	/**
+	 * mesh_max_new_peers - Maximum number of new mesh peers per second
+	 *
+	 * This limits how many new peer candidates reported by the driver are
+	 * added per second. Deferred candidates are added when the driver
+	 * reports them again on their following Beacon frames. This spreads
+	 * the SAE exchanges of a dense mesh bring-up over time. 0 = no limit.
+	 * By default: 10.
+	 */
+	int mesh_max_new_peers;
+
 	/**
 	 * dot11RSNASAERetransPeriod - Timeout to retransmit SAE Auth frame
 	 *
@@ -1328,6 +1342,17 @@ struct wpa_config {
 	 * wpa_supplicant.
 	 */
 	int ftm_initiator;
+
+	/**
+	 * dbus_prop_changed_delay - D-Bus PropertiesChanged coalescing interval
+	 *
+	 * Property changes marked within this many milliseconds from the first
+	 * pending change are sent together. Valid range is 0..1000 ms; the
+	 * default is 5 ms (DEFAULT_DBUS_PROP_CHANGED_DELAY). There is a single
+	 * D-Bus connection for all interfaces, so the value from the interface
+	 * that was most recently added or reconfigured is used.
+	 */
+	int dbus_prop_changed_delay;
 };
 
 
@@ -1308,6 +1308,10 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 		fprintf(f, "mesh_max_inactivity=%d\n",
 			config->mesh_max_inactivity);
 
+	if (config->mesh_max_new_peers != DEFAULT_MESH_MAX_NEW_PEERS)
+		fprintf(f, "mesh_max_new_peers=%d\n",
+			config->mesh_max_new_peers);
+
 	if (config->dot11RSNASAERetransPeriod !=
 	    DEFAULT_DOT11_RSNA_SAE_RETRANS_PERIOD)
 		fprintf(f, "dot11RSNASAERetransPeriod=%d\n",
@@ -1344,6 +1348,9 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 		fprintf(f, "ftm_responder=%d\n", config->ftm_responder);
 	if (config->ftm_initiator)
 		fprintf(f, "ftm_initiator=%d\n", config->ftm_initiator);
+	if (config->dbus_prop_changed_delay != DEFAULT_DBUS_PROP_CHANGED_DELAY)
+		fprintf(f, "dbus_prop_changed_delay=%d\n",
+			config->dbus_prop_changed_delay);
 }
 
 #endif /* CONFIG_NO_CONFIG_WRITE */
@@ -7468,6 +7468,12 @@ static int wpas_ctrl_radio_work(struct wpa_supplicant *wpa_s, char *cmd,
 {
 	if (os_strcmp(cmd, "show") == 0)
 		return wpas_ctrl_radio_work_show(wpa_s, buf, buflen);
+	if (os_strcmp(cmd, "stats") == 0)
+		return radio_work_stats(wpa_s->radio, buf, buflen);
+	if (os_strcmp(cmd, "stats_flush") == 0) {
+		radio_work_stats_flush(wpa_s->radio);
+		return 3; /* "OK\n" */
+	}
 	if (os_strncmp(cmd, "add ", 4) == 0)
 		return wpas_ctrl_radio_work_add(wpa_s, cmd + 4, buf, buflen);
 	if (os_strncmp(cmd, "done ", 5) == 0)
@@ -12,6 +12,7 @@
 #define DBUS_COMMON_I_H
 
 #include <dbus/dbus.h>
+#include "utils/list.h"
 
 struct wpa_dbus_property_desc;
 
@@ -25,6 +26,10 @@ struct wpas_dbus_priv {
 #if defined(CONFIG_CTRL_IFACE_DBUS_NEW)
 	struct wpa_dbus_property_desc *all_interface_properties;
 	int globals_start;
+	/* objects with properties marked changed, but not yet signaled */
+	struct dl_list prop_changed_objs;
+	/* PropertiesChanged coalescing interval in milliseconds */
+	unsigned int prop_changed_delay;
 #if defined(CONFIG_AP)
 	int dbus_noc_refcnt;
 #endif /* CONFIG_AP */
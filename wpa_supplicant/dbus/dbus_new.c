@@ -1955,6 +1955,10 @@ void wpas_dbus_signal_p2p_invitation_received(struct wpa_supplicant *wpa_s,
 #endif /* CONFIG_P2P */
 
 
+static int wpas_dbus_bss_prop_idx(enum wpas_dbus_bss_prop property,
+				  const char *prop);
+
+
 /**
  * wpas_dbus_signal_prop_changed - Signals change of property
  * @wpa_s: %wpa_supplicant network interface data
@@ -1966,6 +1970,8 @@ void wpas_dbus_signal_p2p_invitation_received(struct wpa_supplicant *wpa_s,
 void wpas_dbus_signal_prop_changed(struct wpa_supplicant *wpa_s,
 				   enum wpas_dbus_prop property)
 {
+	static int prop_idx[WPAS_DBUS_PROP_ASSOC_STATUS_CODE + 1];
+	struct wpas_dbus_priv *iface = wpa_s->global->dbus;
 	char *prop;
 	dbus_bool_t flush;
 
@@ -2009,9 +2015,22 @@ void wpas_dbus_signal_prop_changed(struct wpa_supplicant *wpa_s,
 		return;
 	}
 
-	wpa_dbus_mark_property_changed(wpa_s->global->dbus,
-				       wpa_s->dbus_new_path,
-				       WPAS_DBUS_NEW_IFACE_INTERFACE, prop);
+	if (!iface)
+		return;
+
+	/* All interface objects share the same property table */
+	if (!prop_idx[property])
+		prop_idx[property] = wpa_dbus_property_index(
+			iface->all_interface_properties,
+			WPAS_DBUS_NEW_IFACE_INTERFACE, prop) + 1;
+	if (!prop_idx[property]) {
+		wpa_printf(MSG_ERROR, "dbus: %s: No property %s",
+			   __func__, prop);
+		return;
+	}
+
+	wpa_dbus_mark_property_changed_idx(iface, wpa_s->dbus_new_path,
+					   prop_idx[property] - 1);
 	if (flush) {
 		wpa_dbus_flush_object_changed_properties(
 			wpa_s->global->dbus->con, wpa_s->dbus_new_path);
@@ -2034,6 +2053,7 @@ void wpas_dbus_bss_signal_prop_changed(struct wpa_supplicant *wpa_s,
 {
 	char path[WPAS_DBUS_OBJECT_PATH_MAX];
 	char *prop;
+	int idx;
 
 	if (!wpa_s->dbus_new_path)
 		return;
@@ -2075,12 +2095,18 @@ void wpas_dbus_bss_signal_prop_changed(struct wpa_supplicant *wpa_s,
 		return;
 	}
 
+	idx = wpas_dbus_bss_prop_idx(property, prop);
+	if (idx < 0) {
+		wpa_printf(MSG_ERROR, "dbus: %s: No property %s",
+			   __func__, prop);
+		return;
+	}
+
 	os_snprintf(path, WPAS_DBUS_OBJECT_PATH_MAX,
 		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
 		    wpa_s->dbus_new_path, id);
 
-	wpa_dbus_mark_property_changed(wpa_s->global->dbus, path,
-				       WPAS_DBUS_NEW_IFACE_BSS, prop);
+	wpa_dbus_mark_property_changed_idx(wpa_s->global->dbus, path, idx);
 }
 
 
@@ -2126,6 +2152,19 @@ void wpas_dbus_signal_debug_show_keys_changed(struct wpa_global *global)
 }
 
 
+/**
+ * wpas_dbus_update_config - Apply D-Bus related configuration parameters
+ * @wpa_s: %wpa_supplicant network interface data
+ */
+void wpas_dbus_update_config(struct wpa_supplicant *wpa_s)
+{
+	struct wpas_dbus_priv *priv = wpa_s->global->dbus;
+
+	if (priv)
+		priv->prop_changed_delay = wpa_s->conf->dbus_prop_changed_delay;
+}
+
+
 static void wpas_dbus_register(struct wpa_dbus_object_desc *obj_desc,
 			       void *priv,
 			       WPADBusArgumentFreeFunction priv_free,
@@ -2133,21 +2172,13 @@ static void wpas_dbus_register(struct wpa_dbus_object_desc *obj_desc,
 			       const struct wpa_dbus_property_desc *properties,
 			       const struct wpa_dbus_signal_desc *signals)
 {
-	int n;
-
 	obj_desc->user_data = priv;
 	obj_desc->user_data_free_func = priv_free;
 	obj_desc->methods = methods;
 	obj_desc->properties = properties;
 	obj_desc->signals = signals;
 
-	for (n = 0; properties && properties->dbus_property; properties++)
-		n++;
-
-	obj_desc->prop_changed_flags = os_zalloc(n);
-	if (!obj_desc->prop_changed_flags)
-		wpa_printf(MSG_DEBUG, "dbus: %s: can't register handlers",
-			   __func__);
+	wpa_dbus_alloc_prop_changed_flags(obj_desc);
 }
 
 
@@ -2301,6 +2332,9 @@ int wpas_dbus_ctrl_iface_init(struct wpas_dbus_priv *priv)
 	struct wpa_dbus_object_desc *obj_desc;
 	int ret;
 
+	dl_list_init(&priv->prop_changed_objs);
+	priv->prop_changed_delay = DEFAULT_DBUS_PROP_CHANGED_DELAY;
+
 	ret = wpa_dbus_ctrl_iface_props_init(priv);
 	if (ret < 0) {
 		wpa_printf(MSG_ERROR,
@@ -2576,6 +2610,20 @@ static const struct wpa_dbus_property_desc wpas_dbus_bss_properties[] = {
 };
 
 
+static int wpas_dbus_bss_prop_idx(enum wpas_dbus_bss_prop property,
+				  const char *prop)
+{
+	/* All BSS objects share the same property table */
+	static int prop_idx[WPAS_DBUS_BSS_PROP_AGE + 1];
+
+	if (!prop_idx[property])
+		prop_idx[property] = wpa_dbus_property_index(
+			wpas_dbus_bss_properties, WPAS_DBUS_NEW_IFACE_BSS,
+			prop) + 1;
+	return prop_idx[property] - 1;
+}
+
+
 static const struct wpa_dbus_signal_desc wpas_dbus_bss_signals[] = {
 	/* Deprecated: use org.freedesktop.DBus.Properties.PropertiesChanged */
 	{ "PropertiesChanged", WPAS_DBUS_NEW_IFACE_BSS,
@@ -3653,6 +3701,7 @@ int wpas_dbus_register_interface(struct wpa_supplicant *wpa_s)
 	wpas_dbus_register(obj_desc, wpa_s, NULL, wpas_dbus_interface_methods,
 			   ctrl_iface->all_interface_properties,
 			   wpas_dbus_interface_signals);
+	wpas_dbus_update_config(wpa_s);
 
 	wpa_printf(MSG_DEBUG, "dbus: Register interface object '%s'",
 		   wpa_s->dbus_new_path);
@@ -168,6 +168,7 @@ void wpas_dbus_signal_blob_removed(struct wpa_supplicant *wpa_s,
 void wpas_dbus_signal_debug_level_changed(struct wpa_global *global);
 void wpas_dbus_signal_debug_timestamp_changed(struct wpa_global *global);
 void wpas_dbus_signal_debug_show_keys_changed(struct wpa_global *global);
+void wpas_dbus_update_config(struct wpa_supplicant *wpa_s);
 
 int wpas_dbus_register_peer(struct wpa_supplicant *wpa_s, const u8 *dev_addr);
 void wpas_dbus_signal_p2p_find_stopped(struct wpa_supplicant *wpa_s);
@@ -348,6 +349,10 @@ static inline void wpas_dbus_signal_debug_level_changed(
 {
 }
 
+static inline void wpas_dbus_update_config(struct wpa_supplicant *wpa_s)
+{
+}
+
 static inline void wpas_dbus_signal_debug_timestamp_changed(
 	struct wpa_global *global)
 {
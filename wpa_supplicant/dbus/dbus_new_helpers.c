@@ -374,6 +374,7 @@ static DBusHandlerResult message_handler(DBusConnection *connection,
 					 DBusMessage *message, void *user_data)
 {
 	struct wpa_dbus_object_desc *obj_dsc = user_data;
+	struct wpas_dbus_priv *ctrl_iface = obj_dsc->ctrl_iface;
 	const char *method;
 	const char *path;
 	const char *msg_interface;
@@ -419,12 +420,75 @@ static DBusHandlerResult message_handler(DBusConnection *connection,
 		dbus_message_unref(reply);
 	}
 
-	wpa_dbus_flush_all_changed_properties(connection);
+	wpa_dbus_flush_all_changed_properties(ctrl_iface);
 
 	return DBUS_HANDLER_RESULT_HANDLED;
 }
 
 
+static int prop_changed_get(const struct wpa_dbus_object_desc *obj_desc,
+			    unsigned int i)
+{
+	return obj_desc->prop_changed_flags &&
+		(obj_desc->prop_changed_flags[i / 32] & BIT(i % 32));
+}
+
+
+static void prop_changed_set(struct wpa_dbus_object_desc *obj_desc,
+			     unsigned int i)
+{
+	if (obj_desc->prop_changed_flags)
+		obj_desc->prop_changed_flags[i / 32] |= BIT(i % 32);
+}
+
+
+static void prop_changed_clear(const struct wpa_dbus_object_desc *obj_desc,
+			       unsigned int i)
+{
+	if (obj_desc->prop_changed_flags)
+		obj_desc->prop_changed_flags[i / 32] &= ~BIT(i % 32);
+}
+
+
+static void flush_changed_timeout_handler(void *eloop_ctx, void *timeout_ctx);
+
+
+static void prop_changed_unlink(struct wpa_dbus_object_desc *obj_desc)
+{
+	struct wpas_dbus_priv *iface = obj_desc->ctrl_iface;
+
+	if (!obj_desc->prop_changed_pending)
+		return;
+	dl_list_del(&obj_desc->prop_changed_list);
+	obj_desc->prop_changed_pending = 0;
+	if (dl_list_empty(&iface->prop_changed_objs))
+		eloop_cancel_timeout(flush_changed_timeout_handler, iface,
+				     NULL);
+}
+
+
+/**
+ * wpa_dbus_alloc_prop_changed_flags - Allocate property changed bitmap
+ * @obj_desc: Object description with properties already set
+ *
+ * Allocates one change flag bit for each entry in obj_desc->properties.
+ */
+void wpa_dbus_alloc_prop_changed_flags(struct wpa_dbus_object_desc *obj_desc)
+{
+	const struct wpa_dbus_property_desc *dsc;
+	unsigned int n = 0;
+
+	for (dsc = obj_desc->properties; dsc && dsc->dbus_property; dsc++)
+		n++;
+
+	obj_desc->num_properties = n;
+	obj_desc->prop_changed_flags = os_calloc((n + 31) / 32, sizeof(u32));
+	if (!obj_desc->prop_changed_flags)
+		wpa_printf(MSG_DEBUG, "dbus: %s: can't register handlers",
+			   __func__);
+}
+
+
 /**
  * free_dbus_object_desc - Frees object description data structure
  * @connection: DBus connection
@@ -442,6 +506,8 @@ void free_dbus_object_desc(struct wpa_dbus_object_desc *obj_dsc)
 	if (obj_dsc->user_data_free_func)
 		obj_dsc->user_data_free_func(obj_dsc->user_data);
 
+	prop_changed_unlink(obj_dsc);
+
 	os_free(obj_dsc->path);
 	os_free(obj_dsc->prop_changed_flags);
 	os_free(obj_dsc);
@@ -478,6 +544,7 @@ int wpa_dbus_ctrl_iface_init(struct wpas_dbus_priv *iface,
 	};
 
 	obj_desc->connection = iface->con;
+	obj_desc->ctrl_iface = iface;
 	obj_desc->path = os_strdup(dbus_path);
 
 	/* Register the message handler for the global dbus interface */
@@ -543,6 +610,7 @@ int wpa_dbus_register_object_per_iface(struct wpas_dbus_priv *ctrl_iface,
 
 	con = ctrl_iface->con;
 	obj_desc->connection = con;
+	obj_desc->ctrl_iface = ctrl_iface;
 	obj_desc->path = os_strdup(path);
 
 	dbus_error_init(&error);
@@ -565,9 +633,6 @@ int wpa_dbus_register_object_per_iface(struct wpas_dbus_priv *ctrl_iface,
 }
 
 
-static void flush_object_timeout_handler(void *eloop_ctx, void *timeout_ctx);
-
-
 /**
  * wpa_dbus_unregister_object_per_iface - Unregisters DBus object
  * @ctrl_iface: Pointer to dbus private data
@@ -590,7 +655,7 @@ int wpa_dbus_unregister_object_per_iface(
 		return 0;
 	}
 
-	eloop_cancel_timeout(flush_object_timeout_handler, con, obj_desc);
+	prop_changed_unlink(obj_desc);
 
 	if (!dbus_connection_unregister_object_path(con, path))
 		return -1;
@@ -605,18 +670,17 @@ static dbus_bool_t put_changed_properties(
 {
 	DBusMessageIter entry_iter;
 	const struct wpa_dbus_property_desc *dsc;
-	int i;
+	unsigned int i;
 	DBusError error;
 
 	for (dsc = obj_dsc->properties, i = 0; dsc && dsc->dbus_property;
 	     dsc++, i++) {
-		if (obj_dsc->prop_changed_flags == NULL ||
-		    !obj_dsc->prop_changed_flags[i])
+		if (!prop_changed_get(obj_dsc, i))
 			continue;
 		if (os_strcmp(dsc->dbus_interface, interface) != 0)
 			continue;
 		if (clear_changed)
-			obj_dsc->prop_changed_flags[i] = 0;
+			prop_changed_clear(obj_dsc, i);
 
 		if (!dbus_message_iter_open_container(dict_iter,
 						      DBUS_TYPE_DICT_ENTRY,
@@ -736,51 +800,55 @@ static void send_prop_changed_signal(
 }
 
 
-static void flush_object_timeout_handler(void *eloop_ctx, void *timeout_ctx)
-{
-	DBusConnection *con = eloop_ctx;
-	struct wpa_dbus_object_desc *obj_desc = timeout_ctx;
-
-	wpa_printf(MSG_DEBUG,
-		   "dbus: %s: Timeout - sending changed properties of object %s",
-		   __func__, obj_desc->path);
-	wpa_dbus_flush_object_changed_properties(con, obj_desc->path);
-}
-
-
-static void recursive_flush_changed_properties(DBusConnection *con,
-					       const char *path)
+static void flush_object_changed_properties(
+	DBusConnection *con, struct wpa_dbus_object_desc *obj_desc)
 {
-	char **objects = NULL;
-	char subobj_path[WPAS_DBUS_OBJECT_PATH_MAX];
-	int i;
-
-	wpa_dbus_flush_object_changed_properties(con, path);
+	const struct wpa_dbus_property_desc *dsc;
+	unsigned int i;
 
-	if (!dbus_connection_list_registered(con, path, &objects))
-		goto out;
+	prop_changed_unlink(obj_desc);
 
-	for (i = 0; objects[i]; i++) {
-		os_snprintf(subobj_path, WPAS_DBUS_OBJECT_PATH_MAX,
-			    "%s/%s", path, objects[i]);
-		recursive_flush_changed_properties(con, subobj_path);
+	for (dsc = obj_desc->properties, i = 0; dsc && dsc->dbus_property;
+	     dsc++, i++) {
+		if (!prop_changed_get(obj_desc, i))
+			continue;
+		send_prop_changed_signal(con, obj_desc->path,
+					 dsc->dbus_interface, obj_desc);
 	}
-
-out:
-	dbus_free_string_array(objects);
 }
 
 
 /**
  * wpa_dbus_flush_all_changed_properties - Send all PropertiesChanged signals
- * @con: DBus connection
+ * @iface: dbus priv struct
  *
- * Traverses through all registered objects and sends PropertiesChanged for
- * each properties.
+ * Sends PropertiesChanged for each object that has properties marked as
+ * changed. Only the objects queued by wpa_dbus_mark_property_changed() are
+ * visited, so the cost does not depend on the number of registered objects
+ * (e.g., one per BSS).
  */
-void wpa_dbus_flush_all_changed_properties(DBusConnection *con)
+void wpa_dbus_flush_all_changed_properties(struct wpas_dbus_priv *iface)
 {
-	recursive_flush_changed_properties(con, WPAS_DBUS_NEW_PATH);
+	struct wpa_dbus_object_desc *obj_desc;
+
+	if (!iface)
+		return;
+
+	while ((obj_desc = dl_list_first(&iface->prop_changed_objs,
+					 struct wpa_dbus_object_desc,
+					 prop_changed_list)))
+		flush_object_changed_properties(iface->con, obj_desc);
+}
+
+
+static void flush_changed_timeout_handler(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpas_dbus_priv *iface = eloop_ctx;
+
+	wpa_printf(MSG_DEBUG,
+		   "dbus: %s: Timeout - sending changed properties (%u objects)",
+		   __func__, dl_list_len(&iface->prop_changed_objs));
+	wpa_dbus_flush_all_changed_properties(iface);
 }
 
 
@@ -805,26 +873,85 @@ void wpa_dbus_flush_object_changed_properties(DBusConnection *con,
 					      const char *path)
 {
 	struct wpa_dbus_object_desc *obj_desc = NULL;
-	const struct wpa_dbus_property_desc *dsc;
-	int i;
 
 	dbus_connection_get_object_path_data(con, path, (void **) &obj_desc);
 	if (!obj_desc)
 		return;
-	eloop_cancel_timeout(flush_object_timeout_handler, con, obj_desc);
+	flush_object_changed_properties(con, obj_desc);
+}
 
-	for (dsc = obj_desc->properties, i = 0; dsc && dsc->dbus_property;
-	     dsc++, i++) {
-		if (obj_desc->prop_changed_flags == NULL ||
-		    !obj_desc->prop_changed_flags[i])
-			continue;
-		send_prop_changed_signal(con, path, dsc->dbus_interface,
-					 obj_desc);
+
+static struct wpa_dbus_object_desc *
+prop_changed_obj_desc(struct wpas_dbus_priv *iface, const char *path)
+{
+	struct wpa_dbus_object_desc *obj_desc = NULL;
+
+	if (iface == NULL)
+		return NULL;
+
+	dbus_connection_get_object_path_data(iface->con, path,
+					     (void **) &obj_desc);
+	if (!obj_desc) {
+		wpa_printf(MSG_ERROR,
+			   "dbus: wpa_dbus_property_changed: could not obtain object's private data: %s",
+			   path);
+		return NULL;
 	}
+
+	return obj_desc;
 }
 
 
-#define WPA_DBUS_SEND_PROP_CHANGED_TIMEOUT 5000
+static void prop_changed_mark(struct wpas_dbus_priv *iface,
+			      struct wpa_dbus_object_desc *obj_desc,
+			      unsigned int idx)
+{
+	unsigned int delay = iface->prop_changed_delay;
+
+	prop_changed_set(obj_desc, idx);
+	if (obj_desc->prop_changed_pending)
+		return;
+
+	/*
+	 * A single timeout covers all objects with pending changes, so that
+	 * changes to many objects (e.g., BSSs updated by a scan) get flushed
+	 * together instead of each object scheduling its own flush.
+	 */
+	if (dl_list_empty(&iface->prop_changed_objs))
+		eloop_register_timeout(delay / 1000, (delay % 1000) * 1000,
+				       flush_changed_timeout_handler,
+				       iface, NULL);
+	obj_desc->ctrl_iface = iface;
+	obj_desc->prop_changed_pending = 1;
+	dl_list_add_tail(&iface->prop_changed_objs,
+			 &obj_desc->prop_changed_list);
+}
+
+
+/**
+ * wpa_dbus_property_index - Find the index of a property
+ * @props: Property table of an object
+ * @interface: Interface containing the property
+ * @property: Property name
+ * Returns: Index of the property in @props or -1 if not found
+ *
+ * The index can be used with wpa_dbus_mark_property_changed_idx() for all
+ * objects registered with the same property table.
+ */
+int wpa_dbus_property_index(const struct wpa_dbus_property_desc *props,
+			    const char *interface, const char *property)
+{
+	const struct wpa_dbus_property_desc *dsc;
+	int i = 0;
+
+	for (dsc = props; dsc && dsc->dbus_property; dsc++, i++) {
+		if (os_strcmp(property, dsc->dbus_property) == 0 &&
+		    os_strcmp(interface, dsc->dbus_interface) == 0)
+			return i;
+	}
+
+	return -1;
+}
 
 
 /**
@@ -844,43 +971,52 @@ void wpa_dbus_mark_property_changed(struct wpas_dbus_priv *iface,
 				    const char *path, const char *interface,
 				    const char *property)
 {
-	struct wpa_dbus_object_desc *obj_desc = NULL;
-	const struct wpa_dbus_property_desc *dsc;
-	int i = 0;
+	struct wpa_dbus_object_desc *obj_desc;
+	int idx;
 
-	if (iface == NULL)
+	obj_desc = prop_changed_obj_desc(iface, path);
+	if (!obj_desc)
 		return;
 
-	dbus_connection_get_object_path_data(iface->con, path,
-					     (void **) &obj_desc);
-	if (!obj_desc) {
+	idx = wpa_dbus_property_index(obj_desc->properties, interface,
+				      property);
+	if (idx < 0) {
 		wpa_printf(MSG_ERROR,
-			   "dbus: wpa_dbus_property_changed: could not obtain object's private data: %s",
-			   path);
+			   "dbus: wpa_dbus_property_changed: no property %s in object %s",
+			   property, path);
 		return;
 	}
 
-	for (dsc = obj_desc->properties; dsc && dsc->dbus_property; dsc++, i++)
-		if (os_strcmp(property, dsc->dbus_property) == 0 &&
-		    os_strcmp(interface, dsc->dbus_interface) == 0) {
-			if (obj_desc->prop_changed_flags)
-				obj_desc->prop_changed_flags[i] = 1;
-			break;
-		}
+	prop_changed_mark(iface, obj_desc, idx);
+}
+
 
-	if (!dsc || !dsc->dbus_property) {
+/**
+ * wpa_dbus_mark_property_changed_idx - Mark a property as changed by index
+ * @iface: dbus priv struct
+ * @path: path to DBus object which property has changed
+ * @idx: index of the property from wpa_dbus_property_index()
+ *
+ * This is the same as wpa_dbus_mark_property_changed(), but avoids the
+ * property name lookup for frequently changing properties.
+ */
+void wpa_dbus_mark_property_changed_idx(struct wpas_dbus_priv *iface,
+					const char *path, unsigned int idx)
+{
+	struct wpa_dbus_object_desc *obj_desc;
+
+	obj_desc = prop_changed_obj_desc(iface, path);
+	if (!obj_desc)
+		return;
+
+	if (idx >= obj_desc->num_properties) {
 		wpa_printf(MSG_ERROR,
-			   "dbus: wpa_dbus_property_changed: no property %s in object %s",
-			   property, path);
+			   "dbus: wpa_dbus_property_changed: no property %u in object %s",
+			   idx, path);
 		return;
 	}
 
-	if (!eloop_is_timeout_registered(flush_object_timeout_handler,
-					 iface->con, obj_desc)) {
-		eloop_register_timeout(0, WPA_DBUS_SEND_PROP_CHANGED_TIMEOUT,
-				       flush_object_timeout_handler,
-				       iface->con, obj_desc);
-	}
+	prop_changed_mark(iface, obj_desc, idx);
 }
 
 
@@ -11,6 +11,7 @@
 #define WPA_DBUS_CTRL_H
 
 #include <dbus/dbus.h>
+#include "utils/list.h"
 
 typedef DBusMessage * (*WPADBusMethodHandler)(DBusMessage *message,
 					      void *user_data);
@@ -26,6 +27,7 @@ dbus_bool_t f(const struct wpa_dbus_property_desc *property_desc, \
 
 struct wpa_dbus_object_desc {
 	DBusConnection *connection;
+	struct wpas_dbus_priv *ctrl_iface;
 	char *path;
 
 	/* list of methods, properties and signals registered with object */
@@ -33,8 +35,12 @@ struct wpa_dbus_object_desc {
 	const struct wpa_dbus_signal_desc *signals;
 	const struct wpa_dbus_property_desc *properties;
 
-	/* property changed flags */
-	u8 *prop_changed_flags;
+	/* property changed flags (bitmap indexed by property) */
+	u32 *prop_changed_flags;
+	unsigned int num_properties;
+	/* entry in ctrl_iface->prop_changed_objs while flags are pending */
+	struct dl_list prop_changed_list;
+	int prop_changed_pending;
 
 	/* argument for method handlers and properties
 	 * getter and setter functions */
@@ -112,6 +118,8 @@ struct wpa_dbus_property_desc {
 
 void free_dbus_object_desc(struct wpa_dbus_object_desc *obj_dsc);
 
+void wpa_dbus_alloc_prop_changed_flags(struct wpa_dbus_object_desc *obj_desc);
+
 int wpa_dbus_ctrl_iface_init(struct wpas_dbus_priv *iface, char *dbus_path,
 			     char *dbus_service,
 			     struct wpa_dbus_object_desc *obj_desc);
@@ -131,7 +139,7 @@ dbus_bool_t wpa_dbus_get_object_properties(struct wpas_dbus_priv *iface,
 					   DBusMessageIter *iter);
 
 
-void wpa_dbus_flush_all_changed_properties(DBusConnection *con);
+void wpa_dbus_flush_all_changed_properties(struct wpas_dbus_priv *iface);
 
 void wpa_dbus_flush_object_changed_properties(DBusConnection *con,
 					      const char *path);
@@ -140,6 +148,12 @@ void wpa_dbus_mark_property_changed(struct wpas_dbus_priv *iface,
 				    const char *path, const char *interface,
 				    const char *property);
 
+int wpa_dbus_property_index(const struct wpa_dbus_property_desc *props,
+			    const char *interface, const char *property);
+
+void wpa_dbus_mark_property_changed_idx(struct wpas_dbus_priv *iface,
+					const char *path, unsigned int idx);
+
 DBusMessage * wpa_dbus_introspect(DBusMessage *message,
 				  struct wpa_dbus_object_desc *obj_dsc);
 
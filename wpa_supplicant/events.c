@@ -1767,15 +1767,19 @@ static int wpas_select_network_from_last_scan(struct wpa_supplicant *wpa_s,
 static int wpa_supplicant_event_scan_results(struct wpa_supplicant *wpa_s,
 					     union wpa_event_data *data)
 {
+	struct wpa_global *global = wpa_s->global;
 	struct wpa_supplicant *ifs;
 	int res;
 
+	wpas_scan_res_share_start(wpa_s);
+
 	res = _wpa_supplicant_event_scan_results(wpa_s, data, 1, 0);
 	if (res == 2) {
 		/*
 		 * Interface may have been removed, so must not dereference
 		 * wpa_s after this.
 		 */
+		wpas_scan_res_share_end(global);
 		return 1;
 	}
 
@@ -1787,6 +1791,7 @@ static int wpa_supplicant_event_scan_results(struct wpa_supplicant *wpa_s,
 		 * interface, do not notify other interfaces to avoid concurrent
 		 * operations during a connection attempt.
 		 */
+		wpas_scan_res_share_end(global);
 		return 0;
 	}
 
@@ -1802,10 +1807,11 @@ static int wpa_supplicant_event_scan_results(struct wpa_supplicant *wpa_s,
 			res = _wpa_supplicant_event_scan_results(ifs, data, 0,
 								 res > 0);
 			if (res < 0)
-				return 0;
+				break;
 		}
 	}
 
+	wpas_scan_res_share_end(global);
 	return 0;
 }
 
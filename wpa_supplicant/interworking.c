@@ -119,6 +119,77 @@ static struct wpabuf * anqp_build_req(u16 info_ids[], size_t num_ids,
 }
 
 
+static struct interworking_anqp_query *
+interworking_anqp_query_get(struct wpa_supplicant *wpa_s, const u8 *dst,
+			    u8 dialog_token)
+{
+	unsigned int i;
+
+	for (i = 0; i < INTERWORKING_MAX_ANQP_QUERIES; i++) {
+		struct interworking_anqp_query *query = &wpa_s->anqp_queries[i];
+
+		if (query->in_use && query->dialog_token == dialog_token &&
+		    os_memcmp(query->bssid, dst, ETH_ALEN) == 0)
+			return query;
+	}
+
+	return NULL;
+}
+
+
+static void interworking_anqp_query_add(struct wpa_supplicant *wpa_s,
+					struct wpa_bss *bss, u8 dialog_token)
+{
+	unsigned int i;
+
+	for (i = 0; i < INTERWORKING_MAX_ANQP_QUERIES; i++) {
+		struct interworking_anqp_query *query = &wpa_s->anqp_queries[i];
+
+		if (query->in_use)
+			continue;
+		query->bss = bss;
+		os_memcpy(query->bssid, bss->bssid, ETH_ALEN);
+		os_memcpy(query->hessid, bss->hessid, ETH_ALEN);
+		os_memcpy(query->ssid, bss->ssid, bss->ssid_len);
+		query->ssid_len = bss->ssid_len;
+		query->domain_id = wpa_bss_anqp_domain_id(bss);
+		query->dialog_token = dialog_token;
+		query->in_use = 1;
+		wpa_s->num_anqp_queries++;
+		return;
+	}
+}
+
+
+/*
+ * Check whether an ANQP query is already in progress to another BSS in the
+ * same homogeneous ESS and ANQP domain. If so, the response to that query can
+ * be shared instead of sending another query.
+ */
+static int interworking_anqp_query_same_domain(struct wpa_supplicant *wpa_s,
+					       struct wpa_bss *bss)
+{
+	unsigned int i;
+	u16 domain_id;
+
+	if (is_zero_ether_addr(bss->hessid) || !wpa_s->num_anqp_queries)
+		return 0;
+
+	domain_id = wpa_bss_anqp_domain_id(bss);
+	for (i = 0; i < INTERWORKING_MAX_ANQP_QUERIES; i++) {
+		struct interworking_anqp_query *query = &wpa_s->anqp_queries[i];
+
+		if (query->in_use && query->domain_id == domain_id &&
+		    os_memcmp(query->hessid, bss->hessid, ETH_ALEN) == 0 &&
+		    query->ssid_len == bss->ssid_len &&
+		    os_memcmp(query->ssid, bss->ssid, bss->ssid_len) == 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+
 static void interworking_anqp_resp_cb(void *ctx, const u8 *dst,
 				      u8 dialog_token,
 				      enum gas_query_result result,
@@ -127,10 +198,19 @@ static void interworking_anqp_resp_cb(void *ctx, const u8 *dst,
 				      u16 status_code)
 {
 	struct wpa_supplicant *wpa_s = ctx;
+	struct interworking_anqp_query *query;
 
 	wpa_printf(MSG_DEBUG, "ANQP: Response callback dst=" MACSTR
 		   " dialog_token=%u result=%d status_code=%u",
 		   MAC2STR(dst), dialog_token, result, status_code);
+	query = interworking_anqp_query_get(wpa_s, dst, dialog_token);
+	if (query) {
+		wpa_s->interworking_gas_bss = query->bss;
+		query->in_use = 0;
+		wpa_s->num_anqp_queries--;
+	} else {
+		wpa_s->interworking_gas_bss = NULL;
+	}
 	anqp_resp_cb(wpa_s, dst, dialog_token, result, adv_proto, resp,
 		     status_code);
 	interworking_next_anqp_fetch(wpa_s);
@@ -253,7 +333,6 @@ static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
 
 	wpa_msg(wpa_s, MSG_DEBUG, "Interworking: ANQP Query Request to " MACSTR,
 		MAC2STR(bss->bssid));
-	wpa_s->interworking_gas_bss = bss;
 
 	info_ids[num_info_ids++] = ANQP_CAPABILITY_LIST;
 	if (all) {
@@ -318,9 +397,11 @@ static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
 		ret = -1;
 		eloop_register_timeout(0, 0, interworking_continue_anqp, wpa_s,
 				       NULL);
-	} else
+	} else {
 		wpa_msg(wpa_s, MSG_DEBUG,
 			"ANQP: Query started with dialog token %u", res);
+		interworking_anqp_query_add(wpa_s, bss, res);
+	}
 
 	return ret;
 }
@@ -2538,10 +2619,12 @@ static struct wpa_bss_anqp *
 interworking_match_anqp_info(struct wpa_supplicant *wpa_s, struct wpa_bss *bss)
 {
 	struct wpa_bss *other;
+	u16 domain_id;
 
 	if (is_zero_ether_addr(bss->hessid))
 		return NULL; /* Cannot be in the same homegenous ESS */
 
+	domain_id = wpa_bss_anqp_domain_id(bss);
 	dl_list_for_each(other, &wpa_s->bss, struct wpa_bss, list) {
 		if (other == bss)
 			continue;
@@ -2559,6 +2642,8 @@ interworking_match_anqp_info(struct wpa_supplicant *wpa_s, struct wpa_bss *bss)
 		if (bss->ssid_len != other->ssid_len ||
 		    os_memcmp(bss->ssid, other->ssid, bss->ssid_len) != 0)
 			continue;
+		if (wpa_bss_anqp_domain_id(other) != domain_id)
+			continue; /* Different ANQP domain */
 
 		wpa_msg(wpa_s, MSG_DEBUG,
 			"Interworking: Share ANQP data with already fetched BSSID "
@@ -2596,7 +2681,14 @@ static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
 	}
 #endif /* CONFIG_HS20 */
 
+	/*
+	 * Keep up to INTERWORKING_MAX_ANQP_QUERIES queries queued in gas_query
+	 * so that the next query can be started as soon as the previous one
+	 * completes instead of waiting for the response to be processed here.
+	 */
 	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
+		if (wpa_s->num_anqp_queries >= INTERWORKING_MAX_ANQP_QUERIES)
+			break;
 		if (!(bss->caps & IEEE80211_CAP_ESS))
 			continue;
 		ie = wpa_bss_get_ie(bss, WLAN_EID_EXT_CAPAB);
@@ -2607,11 +2699,26 @@ static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
 			continue; /* Disallowed BSS */
 
 		if (!(bss->flags & WPA_BSS_ANQP_FETCH_TRIED)) {
+			if (!wpa_s->fetch_all_anqp &&
+			    interworking_anqp_query_same_domain(wpa_s, bss))
+				continue; /* Share results of the pending query */
 			if (bss->anqp == NULL) {
 				bss->anqp = interworking_match_anqp_info(wpa_s,
 									 bss);
+				if (bss->anqp == NULL && !wpa_s->fetch_all_anqp) {
+					bss->anqp = wpa_bss_anqp_cache_get(
+						wpa_s, bss);
+					if (bss->anqp)
+						wpa_msg(wpa_s, MSG_DEBUG,
+							"Interworking: Use retained ANQP data for BSSID "
+							MACSTR,
+							MAC2STR(bss->bssid));
+				}
 				if (bss->anqp) {
 					/* Shared data already fetched */
+					if (!wpa_s->fetch_all_anqp)
+						bss->flags |=
+							WPA_BSS_ANQP_FETCH_TRIED;
 					continue;
 				}
 				bss->anqp = wpa_bss_anqp_alloc();
@@ -2622,12 +2729,12 @@ static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
 			bss->flags |= WPA_BSS_ANQP_FETCH_TRIED;
 			wpa_msg(wpa_s, MSG_INFO, "Starting ANQP fetch for "
 				MACSTR, MAC2STR(bss->bssid));
-			interworking_anqp_send_req(wpa_s, bss);
-			break;
+			if (interworking_anqp_send_req(wpa_s, bss) < 0)
+				break;
 		}
 	}
 
-	if (found == 0) {
+	if (found == 0 && wpa_s->num_anqp_queries == 0) {
 #ifdef CONFIG_HS20
 		if (wpa_s->fetch_osu_info) {
 			if (wpa_s->num_prov_found == 0 &&
@@ -2684,6 +2791,14 @@ int interworking_fetch_anqp(struct wpa_supplicant *wpa_s)
 
 void interworking_stop_fetch_anqp(struct wpa_supplicant *wpa_s)
 {
+	/*
+	 * Forget the outstanding queries so that a following fetch does not
+	 * see a full pipeline or skip BSSs based on the domain of a query
+	 * whose response is no longer waited for.
+	 */
+	os_memset(wpa_s->anqp_queries, 0, sizeof(wpa_s->anqp_queries));
+	wpa_s->num_anqp_queries = 0;
+
 	if (!wpa_s->fetch_anqp_in_progress)
 		return;
 
@@ -15,6 +15,7 @@
 #include "ap/sta_info.h"
 #include "ap/ieee802_11.h"
 #include "ap/wpa_auth.h"
+#include "config.h"
 #include "wpa_supplicant_i.h"
 #include "driver_i.h"
 #include "mesh_mpm.h"
@@ -163,11 +164,15 @@ static Boolean matches_local(struct wpa_supplicant *wpa_s,
 }
 
 
+#define MESH_LLID_MAP_LEN (65536 / 8)
+
 /* check if local link id is already used with another peer */
-static Boolean llid_in_use(struct wpa_supplicant *wpa_s, u16 llid)
+static Boolean llid_in_use(struct hostapd_data *hapd, u16 llid)
 {
 	struct sta_info *sta;
-	struct hostapd_data *hapd = wpa_s->ifmsh->bss[0];
+
+	if (hapd->mesh_llid_map)
+		return !!(hapd->mesh_llid_map[llid / 8] & BIT(llid % 8));
 
 	for (sta = hapd->sta_list; sta; sta = sta->next) {
 		if (sta->my_lid == llid)
@@ -182,13 +187,28 @@ static Boolean llid_in_use(struct wpa_supplicant *wpa_s, u16 llid)
 static void mesh_mpm_init_link(struct wpa_supplicant *wpa_s,
 			       struct sta_info *sta)
 {
+	struct hostapd_data *hapd = wpa_s->ifmsh->bss[0];
+	struct sta_info *tmp;
 	u16 llid;
 
+	if (!hapd->mesh_llid_map) {
+		/* Fall back to walking the STA list if this fails */
+		hapd->mesh_llid_map = os_zalloc(MESH_LLID_MAP_LEN);
+		for (tmp = hapd->sta_list; hapd->mesh_llid_map && tmp;
+		     tmp = tmp->next) {
+			if (tmp->my_lid)
+				hapd->mesh_llid_map[tmp->my_lid / 8] |=
+					BIT(tmp->my_lid % 8);
+		}
+	}
+
 	do {
 		if (os_get_random((u8 *) &llid, sizeof(llid)) < 0)
 			continue;
-	} while (!llid || llid_in_use(wpa_s, llid));
+	} while (!llid || llid_in_use(hapd, llid));
 
+	if (hapd->mesh_llid_map)
+		hapd->mesh_llid_map[llid / 8] |= BIT(llid % 8);
 	sta->my_lid = llid;
 	sta->peer_lid = 0;
 	sta->peer_aid = 0;
@@ -587,6 +607,8 @@ void mesh_mpm_deinit(struct wpa_supplicant *wpa_s, struct hostapd_iface *ifmsh)
 
 	hapd->num_plinks = 0;
 	hostapd_free_stas(hapd);
+	os_free(hapd->mesh_llid_map);
+	hapd->mesh_llid_map = NULL;
 	eloop_cancel_timeout(peer_add_timer, wpa_s, NULL);
 }
 
@@ -725,6 +747,36 @@ static struct sta_info * mesh_mpm_add_peer(struct wpa_supplicant *wpa_s,
 }
 
 
+/*
+ * Limit the number of new peer candidates that are added per second
+ * (mesh_max_new_peers). The driver reports a candidate again on its following
+ * Beacon frames, so a deferred peer is picked up later. This avoids starting a
+ * large number of SAE exchanges at once when joining a dense mesh.
+ */
+static int mesh_mpm_admit_peer(struct wpa_supplicant *wpa_s,
+			       struct hostapd_data *hapd, const u8 *addr)
+{
+	struct os_reltime now;
+
+	os_get_reltime(&now);
+	if (os_reltime_expired(&now, &hapd->mesh_admit_time, 1)) {
+		hapd->mesh_admit_time = now;
+		hapd->mesh_admit_count = 0;
+	}
+	if (wpa_s->conf->mesh_max_new_peers &&
+	    hapd->mesh_admit_count >=
+	    (unsigned int) wpa_s->conf->mesh_max_new_peers) {
+		wpa_msg(wpa_s, MSG_DEBUG,
+			"mesh: Too many new peers - defer " MACSTR,
+			MAC2STR(addr));
+		return 0;
+	}
+	hapd->mesh_admit_count++;
+
+	return 1;
+}
+
+
 void wpa_mesh_new_mesh_peer(struct wpa_supplicant *wpa_s, const u8 *addr,
 			    struct ieee802_11_elems *elems)
 {
@@ -733,6 +785,9 @@ void wpa_mesh_new_mesh_peer(struct wpa_supplicant *wpa_s, const u8 *addr,
 	struct sta_info *sta;
 	struct wpa_ssid *ssid = wpa_s->current_ssid;
 
+	if (!ap_get_sta(data, addr) && !mesh_mpm_admit_peer(wpa_s, data, addr))
+		return;
+
 	sta = mesh_mpm_add_peer(wpa_s, addr, elems);
 	if (!sta)
 		return;
@@ -1261,6 +1316,8 @@ void mesh_mpm_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 {
 	if (sta->plink_state == PLINK_ESTAB)
 		hapd->num_plinks--;
+	if (hapd->mesh_llid_map && sta->my_lid)
+		hapd->mesh_llid_map[sta->my_lid / 8] &= ~BIT(sta->my_lid % 8);
 	eloop_cancel_timeout(plink_timer, ELOOP_ALL_CTX, sta);
 	eloop_cancel_timeout(mesh_auth_timer, ELOOP_ALL_CTX, sta);
 }
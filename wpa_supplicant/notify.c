@@ -526,6 +526,12 @@ void wpas_notify_debug_show_keys_changed(struct wpa_global *global)
 }
 
 
+void wpas_notify_dbus_config_changed(struct wpa_supplicant *wpa_s)
+{
+	wpas_dbus_update_config(wpa_s);
+}
+
+
 void wpas_notify_suspend(struct wpa_global *global)
 {
 	struct wpa_supplicant *wpa_s;
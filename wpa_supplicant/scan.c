@@ -2129,6 +2129,128 @@ void scan_est_throughput(struct wpa_supplicant *wpa_s,
 }
 
 
+static struct wpa_scan_results *
+wpa_scan_results_dup(const struct wpa_scan_results *src, int clear_status)
+{
+	struct wpa_scan_results *res;
+	size_t i;
+
+	res = os_zalloc(sizeof(*res));
+	if (!res)
+		return NULL;
+	res->fetch_time = src->fetch_time;
+	if (!src->num)
+		return res;
+	res->res = os_calloc(src->num, sizeof(struct wpa_scan_res *));
+	if (!res->res)
+		goto fail;
+	for (i = 0; i < src->num; i++) {
+		const struct wpa_scan_res *r = src->res[i];
+		struct wpa_scan_res *n;
+		size_t len = sizeof(*r) + r->ie_len + r->beacon_ie_len;
+
+		n = os_malloc(len);
+		if (!n)
+			goto fail;
+		os_memcpy(n, r, len);
+		if (clear_status)
+			n->flags &= ~WPA_SCAN_ASSOCIATED;
+		res->res[res->num++] = n;
+	}
+
+	return res;
+fail:
+	wpa_scan_results_free(res);
+	return NULL;
+}
+
+
+/*
+ * The driver derives the associated BSS status from the interface used for
+ * fetching the scan results and uses that to detect and clear a state mismatch
+ * between the driver and the kernel on station mode interfaces. Those need to
+ * fetch their own copy to keep that check, so only the interface types below
+ * use the shared copy in addition to the interface that fetched it.
+ */
+static int wpas_scan_res_shared_user(struct wpa_supplicant *wpa_s)
+{
+#ifdef CONFIG_AP
+	if (wpa_s->ap_iface)
+		return 1;
+#endif /* CONFIG_AP */
+	return wpa_s->ifmsh || wpa_s->p2p_mgmt;
+}
+
+
+/**
+ * wpas_scan_res_share_start - Share driver scan results within a radio
+ * @wpa_s: Pointer to wpa_supplicant data for the interface that received the
+ *	scan results event
+ *
+ * Fetch the scan results from the driver once so that all interfaces sharing
+ * the radio can process them without each one doing a separate fetch. The
+ * driver reports the associated status of a BSS based on the interface used
+ * for fetching, so that status is cleared for the other interfaces. Other
+ * station mode interfaces still fetch their own results, so that the driver
+ * can check their association state against the BSS status. This does nothing
+ * unless another interface on the radio can use the shared copy.
+ */
+void wpas_scan_res_share_start(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_global *global = wpa_s->global;
+	struct wpa_supplicant *ifs;
+	int users = 0;
+
+	if (global->scan_res)
+		return;
+
+	dl_list_for_each(ifs, &wpa_s->radio->ifaces, struct wpa_supplicant,
+			 radio_list) {
+		if (ifs != wpa_s && wpas_scan_res_shared_user(ifs)) {
+			users = 1;
+			break;
+		}
+	}
+	if (!users)
+		return;
+
+	global->scan_res = wpa_drv_get_scan_results2(wpa_s);
+	if (!global->scan_res)
+		return;
+	if (global->scan_res->fetch_time.sec == 0)
+		os_get_reltime(&global->scan_res->fetch_time);
+	global->scan_res_radio = wpa_s->radio;
+	global->scan_res_owner = wpa_s;
+	wpa_printf(MSG_DEBUG,
+		   "Sharing %u scan results between interfaces on radio %s",
+		   (unsigned int) global->scan_res->num, wpa_s->radio->name);
+}
+
+
+void wpas_scan_res_share_end(struct wpa_global *global)
+{
+	wpa_scan_results_free(global->scan_res);
+	global->scan_res = NULL;
+	global->scan_res_radio = NULL;
+	global->scan_res_owner = NULL;
+}
+
+
+static struct wpa_scan_results *
+wpas_get_driver_scan_results(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_global *global = wpa_s->global;
+
+	if (global->scan_res && global->scan_res_radio == wpa_s->radio &&
+	    (wpa_s == global->scan_res_owner ||
+	     wpas_scan_res_shared_user(wpa_s)))
+		return wpa_scan_results_dup(global->scan_res,
+					    global->scan_res_owner != wpa_s);
+
+	return wpa_drv_get_scan_results2(wpa_s);
+}
+
+
 /**
  * wpa_supplicant_get_scan_results - Get scan results
  * @wpa_s: Pointer to wpa_supplicant data
@@ -2148,7 +2270,7 @@ wpa_supplicant_get_scan_results(struct wpa_supplicant *wpa_s,
 	size_t i;
 	int (*compar)(const void *, const void *) = wpa_scan_result_compar;
 
-	scan_res = wpa_drv_get_scan_results2(wpa_s);
+	scan_res = wpas_get_driver_scan_results(wpa_s);
 	if (scan_res == NULL) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "Failed to get scan results");
 		return NULL;
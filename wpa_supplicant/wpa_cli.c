@@ -410,7 +410,7 @@ static char ** wpa_cli_complete_set(const char *str, int pos)
 		"eapol_version", "ap_scan", "bgscan",
 #ifdef CONFIG_MESH
 		"user_mpm", "max_peer_links", "mesh_max_inactivity",
-		"dot11RSNASAERetransPeriod",
+		"mesh_max_new_peers", "dot11RSNASAERetransPeriod",
 #endif /* CONFIG_MESH */
 		"disable_scan_offload", "fast_reauth", "opensc_engine_path",
 		"pkcs11_engine_path", "pkcs11_module_path", "openssl_ciphers",
@@ -509,6 +509,7 @@ static char ** wpa_cli_complete_get(const char *str, int pos)
 		"eapol_version", "ap_scan",
 #ifdef CONFIG_MESH
 		"user_mpm", "max_peer_links", "mesh_max_inactivity",
+		"mesh_max_new_peers",
 #endif /* CONFIG_MESH */
 		"disable_scan_offload", "fast_reauth", "opensc_engine_path",
 		"pkcs11_engine_path", "pkcs11_module_path", "openssl_ciphers",
@@ -3367,7 +3368,7 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	  "<command> = driver private commands" },
 #endif /* ANDROID */
 	{ "radio_work", wpa_cli_cmd_radio_work, NULL, cli_cmd_flag_none,
-	  "= radio_work <show/add/done>" },
+	  "= radio_work <show/add/done/stats/stats_flush>" },
 	{ "vendor", wpa_cli_cmd_vendor, NULL, cli_cmd_flag_none,
 	  "<vendor id> <command id> [<hex formatted command argument>] = Send vendor command"
 	},
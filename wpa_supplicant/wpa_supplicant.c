@@ -56,6 +56,7 @@
 #include "scan.h"
 #include "offchannel.h"
 #include "hs20_supplicant.h"
+#include "interworking.h"
 #include "wnm_sta.h"
 #include "wpas_kay.h"
 #include "mesh.h"
@@ -524,6 +525,9 @@ static void wpa_supplicant_cleanup(struct wpa_supplicant *wpa_s)
 		radio_remove_works(wpa_s, "gas-query", 0);
 	gas_query_deinit(wpa_s->gas);
 	wpa_s->gas = NULL;
+#ifdef CONFIG_INTERWORKING
+	interworking_stop_fetch_anqp(wpa_s);
+#endif /* CONFIG_INTERWORKING */
 
 	free_hw_features(wpa_s);
 
@@ -4284,12 +4288,162 @@ static struct wpa_radio * radio_add_interface(struct wpa_supplicant *wpa_s,
 		os_strlcpy(radio->name, rn, sizeof(radio->name));
 	dl_list_init(&radio->ifaces);
 	dl_list_init(&radio->work);
+	dl_list_init(&radio->work_stats);
 	dl_list_add(&radio->ifaces, &wpa_s->radio_list);
 
 	return radio;
 }
 
 
+static unsigned int radio_work_hist_bucket(const struct os_reltime *t)
+{
+	unsigned long ms = t->sec * 1000 + t->usec / 1000;
+	unsigned int i = 0;
+
+	while (ms && i < RADIO_WORK_HIST_BUCKETS - 1) {
+		ms >>= 1;
+		i++;
+	}
+
+	return i;
+}
+
+
+static struct wpa_radio_work_stats *
+radio_work_get_stats(struct wpa_radio *radio, const char *type)
+{
+	struct wpa_radio_work_stats *stats;
+	unsigned int count = 0;
+
+	/*
+	 * External works get their type from the RADIO_WORK add command, so
+	 * account all of them under a single entry.
+	 */
+	if (os_strncmp(type, "ext:", 4) == 0)
+		type = "ext";
+
+	dl_list_for_each(stats, &radio->work_stats, struct wpa_radio_work_stats,
+			 list) {
+		if (os_strcmp(stats->type, type) == 0)
+			return stats;
+		count++;
+	}
+
+	if (count >= RADIO_WORK_STATS_MAX_TYPES) {
+		wpa_printf(MSG_DEBUG,
+			   "Too many radio work types - no statistics for %s",
+			   type);
+		return NULL;
+	}
+
+	stats = os_zalloc(sizeof(*stats));
+	if (!stats)
+		return NULL;
+	stats->type = os_strdup(type);
+	if (!stats->type) {
+		os_free(stats);
+		return NULL;
+	}
+	dl_list_add_tail(&radio->work_stats, &stats->list);
+
+	return stats;
+}
+
+
+/**
+ * radio_work_stats_flush - Clear radio work statistics
+ * @radio: Radio
+ */
+void radio_work_stats_flush(struct wpa_radio *radio)
+{
+	struct wpa_radio_work_stats *stats, *tmp;
+
+	dl_list_for_each_safe(stats, tmp, &radio->work_stats,
+			      struct wpa_radio_work_stats, list) {
+		dl_list_del(&stats->list);
+		os_free(stats->type);
+		os_free(stats);
+	}
+}
+
+
+static int radio_work_print_hist(char *pos, char *end, const char *name,
+				 const unsigned int *hist)
+{
+	char *start = pos;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < RADIO_WORK_HIST_BUCKETS; i++) {
+		ret = os_snprintf(pos, end - pos, "%s%u",
+				  i == 0 ? name : ",", hist[i]);
+		if (os_snprintf_error(end - pos, ret))
+			return -1;
+		pos += ret;
+	}
+
+	return pos - start;
+}
+
+
+/**
+ * radio_work_stats - Print radio work statistics
+ * @radio: Radio
+ * @buf: Buffer for the text
+ * @buflen: Length of the buffer
+ * Returns: Number of bytes written to buf
+ *
+ * Each work type is printed on a separate line with the number of started,
+ * canceled, and preempted works followed by the wait time (queued until
+ * started) and run time (started until done) histograms. See
+ * RADIO_WORK_HIST_BUCKETS for the bucket boundaries. All external works are
+ * reported under the type "ext".
+ */
+int radio_work_stats(struct wpa_radio *radio, char *buf, size_t buflen)
+{
+	struct wpa_radio_work_stats *stats;
+	char *pos = buf, *end = buf + buflen;
+	int ret;
+
+	dl_list_for_each(stats, &radio->work_stats, struct wpa_radio_work_stats,
+			 list) {
+		char *line = pos;
+
+		ret = os_snprintf(pos, end - pos,
+				  "%s started=%u canceled=%u preempted=%u",
+				  stats->type, stats->started, stats->canceled,
+				  stats->preempted);
+		if (os_snprintf_error(end - pos, ret))
+			break;
+		pos += ret;
+
+		ret = radio_work_print_hist(pos, end, " wait=",
+					    stats->wait_hist);
+		if (ret < 0) {
+			pos = line;
+			break;
+		}
+		pos += ret;
+
+		ret = radio_work_print_hist(pos, end, " run=", stats->run_hist);
+		if (ret < 0) {
+			pos = line;
+			break;
+		}
+		pos += ret;
+
+		ret = os_snprintf(pos, end - pos, "\n");
+		if (os_snprintf_error(end - pos, ret)) {
+			pos = line;
+			break;
+		}
+		pos += ret;
+	}
+
+	return pos - buf;
+}
+
+
 static void radio_work_free(struct wpa_radio_work *work)
 {
 	if (work->wpa_s->scan_work == work) {
@@ -4409,6 +4563,7 @@ static void radio_start_next_work(void *eloop_ctx, void *timeout_ctx)
 {
 	struct wpa_radio *radio = eloop_ctx;
 	struct wpa_radio_work *work;
+	struct wpa_radio_work_stats *stats;
 	struct os_reltime now, diff;
 	struct wpa_supplicant *wpa_s;
 
@@ -4446,6 +4601,11 @@ static void radio_start_next_work(void *eloop_ctx, void *timeout_ctx)
 	wpa_dbg(wpa_s, MSG_DEBUG,
 		"Starting radio work '%s'@%p after %ld.%06ld second wait",
 		work->type, work, diff.sec, diff.usec);
+	stats = radio_work_get_stats(radio, work->type);
+	if (stats) {
+		stats->started++;
+		stats->wait_hist[radio_work_hist_bucket(&diff)]++;
+	}
 	work->started = 1;
 	work->time = now;
 	radio->num_active_works++;
@@ -4512,6 +4672,7 @@ static void radio_remove_interface(struct wpa_supplicant *wpa_s)
 
 	wpa_printf(MSG_DEBUG, "Remove radio %s", radio->name);
 	eloop_cancel_timeout(radio_start_next_work, radio, NULL);
+	radio_work_stats_flush(radio);
 	os_free(radio);
 }
 
@@ -4532,6 +4693,44 @@ void radio_work_check_next(struct wpa_supplicant *wpa_s)
 }
 
 
+static int radio_work_is_connect(const char *type)
+{
+	return os_strcmp(type, "connect") == 0 ||
+		os_strcmp(type, "sme-connect") == 0;
+}
+
+
+/*
+ * The caller aborts its own ongoing scan before requesting a connect work.
+ * Scans that other interfaces sharing the radio have started themselves are
+ * aborted here as well, so that the connection attempt does not have to
+ * wait for a full scan on another interface to complete.
+ */
+static void radio_work_preempt_scans(struct wpa_supplicant *wpa_s,
+				     const char *type)
+{
+	struct wpa_radio *radio = wpa_s->radio;
+	struct wpa_radio_work_stats *stats;
+	struct wpa_supplicant *iface;
+
+	dl_list_for_each(iface, &radio->ifaces, struct wpa_supplicant,
+			 radio_list) {
+		if (iface == wpa_s || !iface->scan_work ||
+		    !iface->scan_work->started || !iface->own_scan_running)
+			continue;
+
+		wpa_dbg(iface, MSG_DEBUG,
+			"Preempt ongoing scan for radio work '%s' on %s",
+			type, wpa_s->ifname);
+		if (wpas_abort_ongoing_scan(iface) < 0)
+			continue;
+		stats = radio_work_get_stats(radio, iface->scan_work->type);
+		if (stats)
+			stats->preempted++;
+	}
+}
+
+
 /**
  * radio_add_work - Add a radio work item
  * @wpa_s: Pointer to wpa_supplicant data
@@ -4592,6 +4791,8 @@ int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 		dl_list_add(&wpa_s->radio->work, &work->list);
 	else
 		dl_list_add_tail(&wpa_s->radio->work, &work->list);
+	if (!was_empty && next && radio_work_is_connect(type))
+		radio_work_preempt_scans(wpa_s, type);
 	if (was_empty) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "First radio work item in the queue - schedule start immediately");
 		radio_work_check_next(wpa_s);
@@ -4617,6 +4818,7 @@ int radio_add_work(struct wpa_supplicant *wpa_s, unsigned int freq,
 void radio_work_done(struct wpa_radio_work *work)
 {
 	struct wpa_supplicant *wpa_s = work->wpa_s;
+	struct wpa_radio_work_stats *stats;
 	struct os_reltime now, diff;
 	unsigned int started = work->started;
 
@@ -4625,6 +4827,11 @@ void radio_work_done(struct wpa_radio_work *work)
 	wpa_dbg(wpa_s, MSG_DEBUG, "Radio work '%s'@%p %s in %ld.%06ld seconds",
 		work->type, work, started ? "done" : "canceled",
 		diff.sec, diff.usec);
+	stats = radio_work_get_stats(wpa_s->radio, work->type);
+	if (stats && started)
+		stats->run_hist[radio_work_hist_bucket(&diff)]++;
+	else if (stats)
+		stats->canceled++;
 	radio_work_free(work);
 	if (started)
 		radio_work_check_next(wpa_s);
@@ -5669,6 +5876,9 @@ void wpa_supplicant_update_config(struct wpa_supplicant *wpa_s)
 	if (wpa_s->conf->changed_parameters & CFG_CHANGED_SCHED_SCAN_PLANS)
 		wpas_sched_scan_plans_set(wpa_s, wpa_s->conf->sched_scan_plans);
 
+	if (wpa_s->conf->changed_parameters & CFG_CHANGED_DBUS)
+		wpas_notify_dbus_config_changed(wpa_s);
+
 #ifdef CONFIG_WPS
 	wpas_wps_update_config(wpa_s);
 #endif /* CONFIG_WPS */
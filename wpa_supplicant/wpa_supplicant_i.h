@@ -300,6 +300,14 @@ struct wpa_global {
 #endif /* CONFIG_WIFI_DISPLAY */
 
 	struct psk_list_entry *add_psk; /* From group formation */
+
+	/*
+	 * Driver scan results shared by the interfaces of scan_res_radio while
+	 * a scan results event is being processed
+	 */
+	struct wpa_scan_results *scan_res;
+	struct wpa_radio *scan_res_radio;
+	struct wpa_supplicant *scan_res_owner;
 };
 
 
@@ -317,10 +325,37 @@ struct wpa_radio {
 	unsigned int num_active_works;
 	struct dl_list ifaces; /* struct wpa_supplicant::radio_list entries */
 	struct dl_list work; /* struct wpa_radio_work::list entries */
+	struct dl_list work_stats; /* struct wpa_radio_work_stats::list */
 };
 
 #define MAX_ACTIVE_WORKS 2
 
+/*
+ * Latency histogram buckets: bucket 0 is < 1 ms and bucket i (i > 0) covers
+ * [2^(i-1), 2^i) ms with the last bucket covering everything longer.
+ */
+#define RADIO_WORK_HIST_BUCKETS 16
+
+/*
+ * Maximum number of work types with statistics per radio. All external works
+ * (RADIO_WORK add) share a single "ext" entry, so this is only a safety limit
+ * well above the number of internal work types.
+ */
+#define RADIO_WORK_STATS_MAX_TYPES 32
+
+/**
+ * struct wpa_radio_work_stats - Per work type wait/run time statistics
+ */
+struct wpa_radio_work_stats {
+	struct dl_list list;
+	char *type;
+	unsigned int started;
+	unsigned int canceled;
+	unsigned int preempted;
+	unsigned int wait_hist[RADIO_WORK_HIST_BUCKETS];
+	unsigned int run_hist[RADIO_WORK_HIST_BUCKETS];
+};
+
 
 /**
  * struct wpa_radio_work - Radio work item
@@ -347,6 +382,8 @@ void radio_remove_works(struct wpa_supplicant *wpa_s,
 void radio_work_check_next(struct wpa_supplicant *wpa_s);
 struct wpa_radio_work *
 radio_work_pending(struct wpa_supplicant *wpa_s, const char *type);
+int radio_work_stats(struct wpa_radio *radio, char *buf, size_t buflen);
+void radio_work_stats_flush(struct wpa_radio *radio);
 
 struct wpa_connect_work {
 	unsigned int sme:1;
@@ -935,6 +972,19 @@ struct wpa_supplicant {
 	unsigned int fetch_osu_waiting_scan:1;
 	unsigned int fetch_osu_icon_in_progress:1;
 	struct wpa_bss *interworking_gas_bss;
+#define INTERWORKING_MAX_ANQP_QUERIES 4
+	struct interworking_anqp_query {
+		struct wpa_bss *bss; /* only used for pointer comparison */
+		u8 bssid[ETH_ALEN];
+		u8 hessid[ETH_ALEN];
+		u8 ssid[SSID_MAX_LEN];
+		size_t ssid_len;
+		u16 domain_id;
+		u8 dialog_token;
+		unsigned int in_use:1;
+	} anqp_queries[INTERWORKING_MAX_ANQP_QUERIES];
+	unsigned int num_anqp_queries;
+	struct dl_list anqp_cache; /* struct wpa_bss_anqp_cache_entry */
 	unsigned int osu_icon_id;
 	struct dl_list icon_head; /* struct icon_entry */
 	struct osu_provider *osu_prov;